@@ -0,0 +1,56 @@
+#include "matcher/matching_engine.h"
+
+/// Number of orders resting in the book when the checkpoint is captured, in each run.
+static const std::vector<size_t> resting_orders = {10 * 1000, 100 * 1000, 1000 * 1000};
+
+/// Number of clients the resting orders are spread over and number of bid price levels they are spread across.
+static constexpr size_t num_clients = 200;
+static constexpr Common::Price num_levels = 200;
+
+/// Rest num_orders bids in a single order book and measure how long MatchingEngine::checkpoint() holds up the matching engine thread copying them.
+/// Returns the nanoseconds spent in the capture.
+auto benchmarkCheckpoint(size_t num_orders) {
+  Common::InstrumentRegistry instruments;
+  instruments.add("TICKER0", num_orders + 1, 0); // the order memory pool always keeps one block free.
+
+  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  // Never started, the captured checkpoint is only handed over and not written.
+  auto checkpoint_writer = new Exchange::MECheckpointWriter("checkpoint_benchmark.dat", nullptr);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, nullptr, &instruments, checkpoint_writer);
+
+  for (size_t i = 0; i < num_orders; ++i) {
+    const Exchange::MEClientRequest client_request{Exchange::ClientRequestType::NEW, static_cast<Common::ClientId>(i % num_clients), 0, i / num_clients + 1,
+                                                   Common::Side::BUY, static_cast<Common::Price>(1 + i % num_levels), 1};
+    matching_engine->processClientRequest(&client_request);
+    matching_engine->publishBatch();
+
+    for (auto client_response = client_responses.getNextToRead(); client_response; client_response = client_responses.getNextToRead()) {
+      client_responses.updateReadIndex();
+    }
+    for (auto market_update = market_updates.getNextToRead(); market_update; market_update = market_updates.getNextToRead()) {
+      market_updates.updateReadIndex();
+    }
+  }
+
+  const auto start = Common::getCurrentNanos();
+  matching_engine->checkpoint();
+  const auto elapsed = Common::getCurrentNanos() - start;
+
+  delete matching_engine;
+  delete checkpoint_writer;
+
+  return elapsed;
+}
+
+int main(int, char **) {
+  for (const auto num_orders: resting_orders) {
+    // Includes faulting in the writer's order buffer, which only the first capture of a session pays for.
+    const auto elapsed = benchmarkCheckpoint(num_orders);
+    std::cout << "ORDERS:" << num_orders << " CHECKPOINT " << elapsed << " NANOS, " << (static_cast<double>(elapsed) / num_orders)
+              << " NANOS PER ORDER." << std::endl;
+  }
+
+  exit(EXIT_SUCCESS);
+}
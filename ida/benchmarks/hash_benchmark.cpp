@@ -1,5 +1,4 @@
 #include "matcher/matching_engine.h"
-#include "matcher/unordered_map_me_order_book.h"
 
 static constexpr size_t loop_count = 100000;
 
@@ -13,7 +12,8 @@ size_t benchmarkHashMap(T *order_book, const std::vector<Exchange::MEClientReque
       case Exchange::ClientRequestType::NEW: {
         const auto start = Common::rdtsc();
         order_book->add(client_request.client_id_, client_request.order_id_, client_request.ticker_id_,
-                        client_request.side_, client_request.price_, client_request.qty_);
+                        client_request.side_, client_request.price_, client_request.qty_,
+                        client_request.order_type_, client_request.tif_);
         total_rdtsc += (Common::rdtsc() - start);
       }
         break;
@@ -33,6 +33,16 @@ size_t benchmarkHashMap(T *order_book, const std::vector<Exchange::MEClientReque
   return (total_rdtsc / (loop_count * 2));
 }
 
+/// Run the benchmark against a fresh order book with the provided layout and print the average cycles per operation.
+template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+void benchmarkLayout(const std::string &name, Common::Logger *logger, Exchange::MatchingEngine *matching_engine,
+                     const std::vector<Exchange::MEClientRequest> &client_requests) {
+  auto me_order_book = new Exchange::BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>(0, ME_MAX_ORDER_IDS, logger, matching_engine);
+  const auto cycles = benchmarkHashMap(me_order_book, client_requests);
+  std::cout << name << " " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
+  delete me_order_book;
+}
+
 int main(int, char **) {
   srand(0);
 
@@ -40,7 +50,8 @@ int main(int, char **) {
   Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
   Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
   Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
-  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates);
+  const Common::InstrumentRegistry no_instruments; // the matching engine only buffers and publishes events here, the books are driven directly.
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, nullptr, &no_instruments, nullptr);
 
   Common::OrderId order_id = 1000;
   std::vector<Exchange::MEClientRequest> client_requests_vec;
@@ -60,17 +71,20 @@ int main(int, char **) {
     client_requests_vec.push_back(cxl_request);
   }
 
-  {
-    auto me_order_book = new Exchange::MEOrderBook(0, &logger, matching_engine);
-    const auto cycles = benchmarkHashMap(me_order_book, client_requests_vec);
-    std::cout << "ARRAY HASHMAP " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
-  }
-
-  {
-    auto me_order_book = new Exchange::UnorderedMapMEOrderBook(0, &logger, matching_engine);
-    const auto cycles = benchmarkHashMap(me_order_book, client_requests_vec);
-    std::cout << "UNORDERED-MAP HASHMAP " << cycles << " CLOCK CYCLES PER OPERATION." << std::endl;
-  }
+  // Every combination of order id index, price level index and allocator instantiated in me_order_book.cpp.
+  using namespace Exchange;
+  benchmarkLayout<HashOrderIndex, ArrayPriceLevelIndex, MemPoolAllocator>("ORDERS:HASH LEVELS:ARRAY ALLOC:MEMPOOL", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<HashOrderIndex, ArrayPriceLevelIndex, NewDeleteAllocator>("ORDERS:HASH LEVELS:ARRAY ALLOC:NEW", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<HashOrderIndex, UnorderedMapPriceLevelIndex, MemPoolAllocator>("ORDERS:HASH LEVELS:UNORDERED-MAP ALLOC:MEMPOOL", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<HashOrderIndex, UnorderedMapPriceLevelIndex, NewDeleteAllocator>("ORDERS:HASH LEVELS:UNORDERED-MAP ALLOC:NEW", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<ArrayOrderIndex, ArrayPriceLevelIndex, MemPoolAllocator>("ORDERS:ARRAY LEVELS:ARRAY ALLOC:MEMPOOL", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<ArrayOrderIndex, ArrayPriceLevelIndex, NewDeleteAllocator>("ORDERS:ARRAY LEVELS:ARRAY ALLOC:NEW", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<ArrayOrderIndex, UnorderedMapPriceLevelIndex, MemPoolAllocator>("ORDERS:ARRAY LEVELS:UNORDERED-MAP ALLOC:MEMPOOL", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<ArrayOrderIndex, UnorderedMapPriceLevelIndex, NewDeleteAllocator>("ORDERS:ARRAY LEVELS:UNORDERED-MAP ALLOC:NEW", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<UnorderedMapOrderIndex, ArrayPriceLevelIndex, MemPoolAllocator>("ORDERS:UNORDERED-MAP LEVELS:ARRAY ALLOC:MEMPOOL", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<UnorderedMapOrderIndex, ArrayPriceLevelIndex, NewDeleteAllocator>("ORDERS:UNORDERED-MAP LEVELS:ARRAY ALLOC:NEW", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<UnorderedMapOrderIndex, UnorderedMapPriceLevelIndex, MemPoolAllocator>("ORDERS:UNORDERED-MAP LEVELS:UNORDERED-MAP ALLOC:MEMPOOL", &logger, matching_engine, client_requests_vec);
+  benchmarkLayout<UnorderedMapOrderIndex, UnorderedMapPriceLevelIndex, NewDeleteAllocator>("ORDERS:UNORDERED-MAP LEVELS:UNORDERED-MAP ALLOC:NEW", &logger, matching_engine, client_requests_vec);
 
   exit(EXIT_SUCCESS);
 }
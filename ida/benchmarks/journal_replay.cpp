@@ -0,0 +1,75 @@
+#include "matcher/matching_engine.h"
+#include "order_server/me_journal.h"
+
+/// Feeds the first num_records client requests in the journal through a fresh MatchingEngine at full speed.
+/// Returns the digest of all the client responses and market updates generated and fills in the total time spent.
+uint64_t replayJournal(const Exchange::MEJournalReader &journal, size_t num_records, const Common::InstrumentRegistry &instruments,
+                       bool publish_trade_summaries, Common::Nanos *elapsed) {
+  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, nullptr, &instruments, nullptr);
+  matching_engine->setPublishTradeSummaries(publish_trade_summaries);
+
+  const auto start = Common::getCurrentNanos();
+  for (size_t i = 0; i < num_records; ++i) {
+    matching_engine->processClientRequest(&journal.at(i).request_);
+    matching_engine->publishBatch();
+
+    for (auto client_response = client_responses.getNextToRead(); client_response; client_response = client_responses.getNextToRead()) {
+      client_responses.updateReadIndex();
+    }
+    for (auto market_update = market_updates.getNextToRead(); market_update; market_update = market_updates.getNextToRead()) {
+      market_updates.updateReadIndex();
+    }
+  }
+  *elapsed = Common::getCurrentNanos() - start;
+
+  const auto digest = matching_engine->getOutputDigest();
+  delete matching_engine;
+
+  return digest;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    FATAL("USAGE journal_replay JOURNAL_FILE [CHECKPOINT_FILE or -] [INSTRUMENTS_FILE]");
+  }
+
+  // The journal refers to instruments by TickerId, so this has to be the listing the exchange ran with.
+  Common::InstrumentRegistry instruments;
+  if (argc > 3) {
+    ASSERT(Common::loadInstruments(argv[3], &instruments), "Unable to read instruments file:" + std::string(argv[3]));
+  } else {
+    Common::listDefaultInstruments(&instruments);
+  }
+
+  const Exchange::MEJournalReader journal(argv[1]);
+  std::cout << "Replaying " << journal.size() << " client requests from " << argv[1] << std::endl;
+  if (!journal.size()) {
+    exit(EXIT_SUCCESS);
+  }
+
+  // The exchange records the digest of the outputs it generated for the journal records covered by each checkpoint,
+  // the replay has to reproduce it exactly for the journal to be usable for recovery.
+  Exchange::MECheckpoint checkpoint;
+  const auto has_checkpoint = (argc > 2 && std::string(argv[2]) != "-" && Exchange::readCheckpoint(argv[2], &checkpoint));
+  const auto num_records = (has_checkpoint ? static_cast<size_t>(checkpoint.header_.journal_records_) : journal.size());
+  ASSERT(num_records <= journal.size(), "Checkpoint covers " + std::to_string(num_records) + " records, the journal only has " +
+                                        std::to_string(journal.size()));
+
+  Common::Nanos elapsed = 0;
+  const auto digest = replayJournal(journal, num_records, instruments, has_checkpoint && checkpoint.header_.publish_trade_summaries_, &elapsed);
+
+  std::cout << "RECORDS " << num_records << " DIGEST " << std::hex << digest << std::dec
+            << " " << elapsed / std::max(num_records, size_t{1}) << " NANOS PER REQUEST "
+            << static_cast<uint64_t>(num_records * static_cast<double>(NANOS_TO_SECS) / std::max(elapsed, Common::Nanos{1})) << " REQUESTS PER SEC."
+            << std::endl;
+
+  if (has_checkpoint) {
+    std::cout << "RECORDED DIGEST " << std::hex << checkpoint.header_.output_digest_ << std::dec << std::endl;
+    ASSERT(digest == checkpoint.header_.output_digest_, "Replay does not reproduce the outputs recorded by the exchange.");
+  }
+
+  exit(EXIT_SUCCESS);
+}
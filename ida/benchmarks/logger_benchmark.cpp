@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "common/logging.h"
 #include "common/opt_logging.h"
 
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <random>
+
+#include "matcher/matching_engine.h"
+
+/// Maximum number of client requests waiting in the matching engine's request queue when driving it through its thread.
+static constexpr size_t max_queued_requests = 1024;
+
+/// Parameters of a single benchmark run.
+struct MatchingBenchmarkCfg {
+  std::string mode_;       // "book" drives MEOrderBook directly, "engine" goes through the MatchingEngine thread and its lock free queues.
+  size_t depth_ = 0;       // number of passive price levels on each side of the book.
+  size_t spread_ = 0;      // ticks between the best bid and best ask price levels.
+  double cancel_ratio_ = 0;     // fraction of requests which are cancels of a random earlier order.
+  double aggressor_ratio_ = 0;  // fraction of new orders priced to sweep through the other side of the book.
+  size_t num_clients_ = 0;
+  size_t num_tickers_ = 0;
+  size_t num_ops_ = 0;     // number of measured requests, after the book has been pre-filled.
+};
+
+/// Generate the requests for a run, the first *num_warmup requests pre-fill every book with depth_ levels on each side and are not measured.
+auto generateRequests(const MatchingBenchmarkCfg &cfg, size_t *num_warmup) {
+  std::mt19937_64 rng(42);
+  auto uniform = [&rng](size_t n) { return static_cast<size_t>(rng() % n); };
+  auto chance = [&rng](double p) { return (rng() % 1000000) < static_cast<uint64_t>(p * 1000000); };
+
+  // Prices have to stay within ME_MAX_PRICE_LEVELS of each other since the order book hashes prices into that many slots.
+  ASSERT(2 * cfg.depth_ + cfg.spread_ < ME_MAX_PRICE_LEVELS, "depth and spread span too many price levels.");
+  ASSERT(cfg.num_clients_ <= ME_MAX_NUM_CLIENTS, "too many clients.");
+
+  const Price best_bid = 1000, best_ask = best_bid + cfg.spread_;
+  std::vector<OrderId> next_order_id(cfg.num_clients_, 1);
+  std::vector<Exchange::MEClientRequest> requests;
+  std::vector<Exchange::MEClientRequest> new_requests;
+
+  auto new_order = [&](TickerId ticker_id, bool aggressive) {
+    const auto client_id = static_cast<ClientId>(uniform(cfg.num_clients_));
+    const auto side = (uniform(2) ? Side::BUY : Side::SELL);
+    const auto level = static_cast<Price>(uniform(cfg.depth_));
+    Price price = Price_INVALID;
+    if (aggressive) { // priced anywhere on the other side of the book, so it matches and possibly sweeps several levels.
+      price = (side == Side::BUY ? best_ask + level : best_bid - level);
+    } else {
+      price = (side == Side::BUY ? best_bid - level : best_ask + level);
+    }
+    const auto qty = static_cast<Qty>(1 + uniform(aggressive ? 200 : 100));
+
+    const Exchange::MEClientRequest request{Exchange::ClientRequestType::NEW, client_id, ticker_id, next_order_id[client_id]++, side, price, qty};
+    requests.push_back(request);
+    new_requests.push_back(request);
+  };
+
+  for (TickerId ticker_id = 0; ticker_id < cfg.num_tickers_; ++ticker_id) {
+    for (size_t i = 0; i < cfg.depth_ * 8; ++i) {
+      new_order(ticker_id, false);
+    }
+  }
+  *num_warmup = requests.size();
+
+  while (requests.size() < *num_warmup + cfg.num_ops_) {
+    if (chance(cfg.cancel_ratio_)) { // might have been filled or cancelled already, which is a cancel reject.
+      auto request = new_requests[uniform(new_requests.size())];
+      request.type_ = Exchange::ClientRequestType::CANCEL;
+      requests.push_back(request);
+    } else {
+      new_order(static_cast<TickerId>(uniform(cfg.num_tickers_)), chance(cfg.aggressor_ratio_));
+    }
+  }
+
+  return requests;
+}
+
+/// Estimate rdtsc() cycles per nanosecond, to convert cycle counts to throughput.
+auto cyclesPerNano() {
+  const auto start_nanos = Common::getCurrentNanos();
+  const auto start_cycles = Common::rdtsc();
+  using namespace std::literals::chrono_literals;
+  std::this_thread::sleep_for(100ms);
+  return static_cast<double>(Common::rdtsc() - start_cycles) / (Common::getCurrentNanos() - start_nanos);
+}
+
+/// Drain the matching engine output queues, used when nothing else is consuming them.
+auto drainQueues(Exchange::ClientResponseLFQueue *client_responses, Exchange::MEMarketUpdateLFQueue *market_updates) {
+  while (client_responses->getNextToRead())
+    client_responses->updateReadIndex();
+  while (market_updates->getNextToRead())
+    market_updates->updateReadIndex();
+}
+
+/// Drive MEOrderBook::add() / cancel() directly and measure the cycles spent in each call. Returns the total cycles of the measured calls.
+auto runBookBenchmark(const MatchingBenchmarkCfg &cfg, const std::vector<Exchange::MEClientRequest> &requests, size_t num_warmup,
+                      std::vector<uint64_t> *cycles) {
+  Common::Logger logger("matching_benchmark.log");
+  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  const Common::InstrumentRegistry no_instruments; // the matching engine only buffers and publishes events here, the books are driven directly.
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, nullptr, &no_instruments, nullptr);
+
+  std::vector<Exchange::MEOrderBook *> order_books;
+  for (TickerId ticker_id = 0; ticker_id < cfg.num_tickers_; ++ticker_id) {
+    order_books.push_back(new Exchange::MEOrderBook(ticker_id, ME_MAX_ORDER_IDS, &logger, matching_engine));
+  }
+
+  uint64_t total_cycles = 0;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    const auto &request = requests[i];
+    const auto order_book = order_books[request.ticker_id_];
+
+    const auto start = Common::rdtsc();
+    if (request.type_ == Exchange::ClientRequestType::NEW) {
+      order_book->add(request.client_id_, request.order_id_, request.ticker_id_, request.side_, request.price_, request.qty_,
+                      request.order_type_, request.tif_);
+    } else {
+      order_book->cancel(request.client_id_, request.order_id_, request.ticker_id_);
+    }
+    const auto elapsed = Common::rdtsc() - start;
+
+    if (i >= num_warmup) {
+      cycles->push_back(elapsed);
+      total_cycles += elapsed;
+    }
+
+    matching_engine->publishBatch();
+    drainQueues(&client_responses, &market_updates);
+  }
+
+  for (auto order_book : order_books) {
+    delete order_book;
+  }
+  delete matching_engine;
+
+  return total_cycles;
+}
+
+/// Send requests to a running MatchingEngine through its lock free queue, with separate threads consuming client responses and market updates.
+/// Measures the cycles from writing each request to reading its acknowledgement (ACCEPTED, CANCELED or CANCEL_REJECTED), which the matching
+/// engine publishes exactly once per request and in request order. Returns the total cycles from the first measured request to the last acknowledgement.
+auto runEngineBenchmark(const MatchingBenchmarkCfg &cfg, const std::vector<Exchange::MEClientRequest> &requests, size_t num_warmup,
+                        std::vector<uint64_t> *cycles) {
+  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  Common::InstrumentRegistry instruments;
+  for (size_t i = 0; i < cfg.num_tickers_; ++i) {
+    instruments.add("TICKER" + std::to_string(i), ME_MAX_ORDER_IDS, 0);
+  }
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, nullptr, &instruments, nullptr);
+  matching_engine->start();
+
+  std::vector<uint64_t> send_cycles(requests.size()), ack_cycles(requests.size());
+  volatile bool run_consumers = true;
+
+  // Named so the closures outlive the threads running them, createAndStartThread() only keeps a reference to them.
+  auto consume_responses = [&]() {
+    size_t num_acks = 0;
+    while (num_acks < requests.size()) {
+      const auto client_response = client_responses.getNextToRead();
+      if (client_response) {
+        if (client_response->type_ == Exchange::ClientResponseType::ACCEPTED || client_response->type_ == Exchange::ClientResponseType::CANCELED ||
+            client_response->type_ == Exchange::ClientResponseType::CANCEL_REJECTED) {
+          ack_cycles[num_acks++] = Common::rdtsc();
+        }
+        client_responses.updateReadIndex();
+      }
+    }
+  };
+  auto consume_market_updates = [&]() {
+    while (run_consumers) {
+      if (market_updates.getNextToRead())
+        market_updates.updateReadIndex();
+    }
+  };
+  auto response_consumer = Common::createAndStartThread(-1, "Benchmark/ClientResponses", consume_responses);
+  auto market_update_consumer = Common::createAndStartThread(-1, "Benchmark/MarketUpdates", consume_market_updates);
+
+  for (size_t i = 0; i < requests.size(); ++i) {
+    // Keep the request queue short, so the measurement is the matching engine and not an ever growing backlog.
+    while (client_requests.size() >= max_queued_requests) {
+    }
+
+    send_cycles[i] = Common::rdtsc();
+    *client_requests.getNextToWriteTo() = requests[i];
+    client_requests.updateWriteIndex();
+  }
+
+  response_consumer->join();
+  run_consumers = false;
+  market_update_consumer->join();
+  delete response_consumer;
+  delete market_update_consumer;
+
+  matching_engine->stop();
+  delete matching_engine;
+
+  for (size_t i = num_warmup; i < requests.size(); ++i) {
+    cycles->push_back(ack_cycles[i] - send_cycles[i]);
+  }
+
+  return ack_cycles.back() - send_cycles[num_warmup];
+}
+
+/// Run one configuration and print a CSV line of results.
+auto runBenchmark(const MatchingBenchmarkCfg &cfg, double cycles_per_nano) {
+  size_t num_warmup = 0;
+  const auto requests = generateRequests(cfg, &num_warmup);
+
+  std::vector<uint64_t> cycles;
+  cycles.reserve(cfg.num_ops_);
+  uint64_t total_cycles = 0;
+  if (cfg.mode_ == "book") {
+    total_cycles = runBookBenchmark(cfg, requests, num_warmup, &cycles);
+  } else if (cfg.mode_ == "engine") {
+    total_cycles = runEngineBenchmark(cfg, requests, num_warmup, &cycles);
+  } else {
+    FATAL("Unknown mode:" + cfg.mode_ + " expected book or engine.");
+  }
+
+  std::sort(cycles.begin(), cycles.end());
+  auto percentile = [&cycles](double p) { return cycles[std::min(cycles.size() - 1, static_cast<size_t>(p * cycles.size()))]; };
+  const auto ops_per_sec = static_cast<uint64_t>(cycles.size() / (total_cycles / cycles_per_nano) * NANOS_TO_SECS);
+
+  std::cout << cfg.mode_ << "," << cfg.depth_ << "," << cfg.spread_ << "," << cfg.cancel_ratio_ << "," << cfg.aggressor_ratio_ << ","
+            << cfg.num_clients_ << "," << cfg.num_tickers_ << "," << cycles.size() << ","
+            << percentile(0.5) << "," << percentile(0.99) << "," << percentile(0.999) << "," << cycles.back() << "," << ops_per_sec << std::endl;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 1 && argc != 9) {
+    FATAL("USAGE matching_benchmark [MODE(book|engine) DEPTH SPREAD CANCEL_RATIO AGGRESSOR_RATIO NUM_CLIENTS NUM_TICKERS NUM_OPS]");
+  }
+
+  const auto cycles_per_nano = cyclesPerNano();
+  std::cout << "mode,depth,spread,cancel_ratio,aggressor_ratio,clients,tickers,ops,p50_cycles,p99_cycles,p999_cycles,max_cycles,ops_per_sec" << std::endl;
+
+  if (argc == 9) {
+    runBenchmark({argv[1], std::stoul(argv[2]), std::stoul(argv[3]), std::stod(argv[4]), std::stod(argv[5]), std::stoul(argv[6]), std::stoul(argv[7]),
+                  std::stoul(argv[8])}, cycles_per_nano);
+    exit(EXIT_SUCCESS);
+  }
+
+  // Default sweep - a baseline configuration and then one parameter varied at a time, each through both modes.
+  const MatchingBenchmarkCfg baseline{"", 10, 2, 0.5, 0.1, 1, 1, 100000};
+  std::vector<MatchingBenchmarkCfg> cfgs{baseline};
+  for (const auto depth : {2, 50}) {
+    cfgs.push_back(baseline);
+    cfgs.back().depth_ = depth;
+  }
+  for (const auto spread : {1, 20}) {
+    cfgs.push_back(baseline);
+    cfgs.back().spread_ = spread;
+  }
+  for (const auto cancel_ratio : {0.2, 0.8}) {
+    cfgs.push_back(baseline);
+    cfgs.back().cancel_ratio_ = cancel_ratio;
+  }
+  for (const auto aggressor_ratio : {0.0, 0.5}) {
+    cfgs.push_back(baseline);
+    cfgs.back().aggressor_ratio_ = aggressor_ratio;
+  }
+  cfgs.push_back(baseline);
+  cfgs.back().num_clients_ = 16;
+  cfgs.push_back(baseline);
+  cfgs.back().num_tickers_ = ME_DEFAULT_NUM_TICKERS;
+
+  for (auto cfg : cfgs) {
+    for (const auto mode : {"book", "engine"}) {
+      cfg.mode_ = mode;
+      runBenchmark(cfg, cycles_per_nano);
+    }
+  }
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,178 @@
+#include <algorithm>
+
+#include "order_server/order_server.h"
+
+/// Parameters of a single benchmark run.
+struct OrderServerBenchmarkCfg {
+  bool split_rx_tx_ = false;  // receive client requests and send client responses on separate threads.
+  size_t flood_batch_ = 0;    // client requests per frame sent by the flooding client every flood_interval, 0 for no incoming load.
+  size_t num_fills_ = 0;      // number of measured fills sent to the probe client.
+};
+
+static constexpr Common::ClientId flood_client_id = 1, probe_client_id = 2;
+
+/// Interval at which the stand-in matching engine publishes fills for the probe client.
+static constexpr Common::Nanos fill_interval = 20 * Common::NANOS_TO_MICROS;
+
+/// Interval at which the flooding client sends a frame of client requests.
+static constexpr Common::Nanos flood_interval = 100 * Common::NANOS_TO_MICROS;
+
+/// Give up on fills not received this long after the last one was published.
+static constexpr Common::Nanos fill_timeout = 5 * Common::NANOS_TO_SECS;
+
+static int next_port = 23500;
+
+/// Run an OrderServer with a stand-in matching engine which publishes a FILLED client response for the probe client every fill_interval,
+/// while a second client floods the server with client requests at a fixed rate. Measures the nanoseconds from publishing each fill to the probe client
+/// reading it off its socket, and returns the number of flood client requests the server published per second.
+auto runBenchmark(const OrderServerBenchmarkCfg &cfg, std::vector<Common::Nanos> *latencies) {
+  const auto port = next_port++;
+  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  auto order_server = new Exchange::OrderServer(&client_requests, &client_responses, nullptr, Exchange::ME_MAX_PENDING_REQUESTS, cfg.split_rx_tx_, -1, -1,
+                                                Common::TCPBackend::EPOLL, "lo", port);
+  order_server->start();
+
+  Common::Logger flood_logger("order_server_benchmark_flood.log"), probe_logger("order_server_benchmark_probe.log");
+  Common::TCPSocket flood_socket(flood_logger), probe_socket(probe_logger);
+  ASSERT(flood_socket.connect("127.0.0.1", "lo", port, false) >= 0 && probe_socket.connect("127.0.0.1", "lo", port, false) >= 0,
+         "Failed to connect to the order server on port:" + std::to_string(port));
+
+  volatile bool run_flood = true, probe_bound = false;
+  size_t num_flood_requests = 0;
+  Common::Nanos flood_start = 0, flood_end = 0;
+
+  // Named so the closures outlive the threads running them, createAndStartThread() only keeps a reference to them.
+  // The flooding client writes its frames with blocking semantics, so a full socket buffer slows the flood down instead of piling up in the send buffer.
+  auto flood = [&]() {
+    Common::WireFrameEncoder encoder(Exchange::ORDER_ENTRY_SCHEMA_ID, Exchange::ORDER_ENTRY_SCHEMA_VERSION, Common::WIRE_MAX_FRAME_SIZE);
+    size_t seq_num = 1;
+    auto next_frame = Common::getCurrentNanos();
+    while (run_flood && cfg.flood_batch_) {
+      if (Common::getCurrentNanos() < next_frame)
+        continue;
+      next_frame += flood_interval;
+
+      for (size_t i = 0; i < cfg.flood_batch_; ++i, ++seq_num) {
+        encoder.append<Exchange::WireClientRequest>(&flood_socket, seq_num)->encode(
+            {Exchange::ClientRequestType::NEW, flood_client_id, 0, seq_num, Common::Side::BUY, 100, 1});
+      }
+      for (size_t sent = 0; run_flood && sent < flood_socket.next_send_valid_index_;) {
+        const auto n = ::send(flood_socket.socket_fd_, flood_socket.outbound_data_.data() + sent, flood_socket.next_send_valid_index_ - sent, MSG_NOSIGNAL);
+        if (n > 0)
+          sent += n;
+      }
+      flood_socket.next_send_valid_index_ = 0;
+    }
+  };
+
+  // Stands in for the matching engine, consumes every client request and publishes the fills.
+  size_t num_fills_sent = 0;
+  auto matching_engine = [&]() {
+    auto next_fill = Common::getCurrentNanos();
+    while (run_flood) {
+      for (auto client_request = client_requests.getNextToRead(); client_request; client_request = client_requests.getNextToRead()) {
+        if (client_request->client_id_ == flood_client_id) {
+          if (UNLIKELY(!num_flood_requests))
+            flood_start = Common::getCurrentNanos();
+          ++num_flood_requests;
+          flood_end = Common::getCurrentNanos();
+        } else {
+          probe_bound = true;
+        }
+        client_requests.updateReadIndex();
+      }
+
+      const auto now = Common::getCurrentNanos();
+      if (probe_bound && num_fills_sent < cfg.num_fills_ && now >= next_fill) {
+        *client_responses.getNextToWriteTo() = {Exchange::ClientResponseType::FILLED, probe_client_id, 0, num_fills_sent, static_cast<OrderId>(now),
+                                               Common::Side::BUY, 100, 1, 0, true};
+        client_responses.updateWriteIndex();
+        ++num_fills_sent;
+        next_fill = now + fill_interval;
+      }
+    }
+  };
+
+  // The probe client logs on with a single request, after which the fills start, and timestamps each fill as its frame is decoded.
+  latencies->clear();
+  latencies->reserve(cfg.num_fills_);
+  probe_socket.recv_callback_ = [&](Common::TCPSocket *socket, Common::Nanos) {
+    const auto now = Common::getCurrentNanos();
+    const auto consumed = Common::decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [&](const Common::WireFrameHeader *frame) {
+      Common::forEachWireMessage(frame, Exchange::ORDER_ENTRY_SCHEMA_ID, [&](size_t, const Common::WireMessageHeader *message_header, const char *block) {
+        if (const auto wire_response = Common::wireMessage<Exchange::WireClientResponse>(message_header, block); wire_response)
+          latencies->push_back(now - static_cast<Common::Nanos>(wire_response->market_order_id_));
+      });
+      return true;
+    });
+    memmove(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+    socket->next_rcv_valid_index_ -= consumed;
+  };
+
+  auto flood_thread = Common::createAndStartThread(-1, "Benchmark/FloodClient", flood);
+  auto matching_engine_thread = Common::createAndStartThread(-1, "Benchmark/MatchingEngine", matching_engine);
+
+  Common::WireFrameEncoder probe_encoder(Exchange::ORDER_ENTRY_SCHEMA_ID, Exchange::ORDER_ENTRY_SCHEMA_VERSION, Common::WIRE_MAX_FRAME_SIZE);
+  probe_encoder.append<Exchange::WireClientRequest>(&probe_socket, 1)->encode({Exchange::ClientRequestType::NEW, probe_client_id, 0, 1, Common::Side::SELL, 200, 1});
+
+  auto last_progress = Common::getCurrentNanos();
+  size_t num_received = 0;
+  while (latencies->size() < cfg.num_fills_ && Common::getCurrentNanos() - last_progress < fill_timeout) {
+    probe_socket.sendAndRecv();
+    if (latencies->size() != num_received) {
+      num_received = latencies->size();
+      last_progress = Common::getCurrentNanos();
+    }
+  }
+
+  run_flood = false;
+  flood_thread->join();
+  matching_engine_thread->join();
+  delete flood_thread;
+  delete matching_engine_thread;
+
+  // Not destroyed, its threads are not joined and could still be in their last loop iteration.
+  order_server->stop();
+
+  return (flood_end > flood_start ? static_cast<uint64_t>(static_cast<double>(num_flood_requests) / (flood_end - flood_start) * NANOS_TO_SECS) : 0);
+}
+
+/// Run one configuration and print a CSV line of results.
+auto printBenchmark(const OrderServerBenchmarkCfg &cfg) {
+  std::vector<Common::Nanos> latencies;
+  const auto flood_requests_per_sec = runBenchmark(cfg, &latencies);
+
+  if (latencies.empty()) {
+    std::cout << cfg.split_rx_tx_ << "," << cfg.flood_batch_ << ",0," << flood_requests_per_sec << ",,,," << std::endl;
+    return;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) { return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))]; };
+
+  std::cout << cfg.split_rx_tx_ << "," << cfg.flood_batch_ << "," << latencies.size() << "," << flood_requests_per_sec << ","
+            << percentile(0.5) << "," << percentile(0.99) << "," << percentile(0.999) << "," << latencies.back() << std::endl;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 1 && argc != 4) {
+    FATAL("USAGE order_server_benchmark [SPLIT_RX_TX(0|1) FLOOD_BATCH NUM_FILLS]");
+  }
+
+  std::cout << "split_rx_tx,flood_batch,fills,flood_requests_per_sec,p50_ns,p99_ns,p999_ns,max_ns" << std::endl;
+
+  if (argc == 4) {
+    printBenchmark({std::stoul(argv[1]) != 0, std::stoul(argv[2]), std::stoul(argv[3])});
+    exit(EXIT_SUCCESS);
+  }
+
+  // Default sweep - fill latency without and with a flood of incoming client requests, each with one thread and with separate threads.
+  for (const size_t flood_batch : {0, 8, 64}) {
+    for (const bool split_rx_tx : {false, true}) {
+      printBenchmark({split_rx_tx, flood_batch, 20000});
+    }
+  }
+
+  exit(EXIT_SUCCESS);
+}
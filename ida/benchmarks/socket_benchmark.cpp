@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include "common/tcp_server.h"
+#include "common/io_uring_tcp.h"
+
+/// Parameters of a single benchmark run.
+struct SocketBenchmarkCfg {
+  Common::TCPBackend backend_ = Common::TCPBackend::EPOLL;
+  size_t num_connections_ = 0;  // clients connected to the echo server, each sends one message per round.
+  size_t num_rounds_ = 0;
+};
+
+/// Size of each message the clients send and the server echoes back.
+static constexpr size_t message_size = 32;
+
+/// Give up on a round not completed this long after it started.
+static constexpr Common::Nanos round_timeout = 5 * Common::NANOS_TO_SECS;
+
+static int next_port = 23600;
+
+/// Run a TCPServer on the backend which echoes everything back, with num_connections_ plain non-blocking clients which each send one message
+/// per round and wait for all echoes before starting the next. The clients do not use TCPSocket so only the server's connections carry its buffers.
+/// Returns the number of system calls the server made per message received and the round trip of every round.
+auto runBenchmark(const SocketBenchmarkCfg &cfg, std::vector<Common::Nanos> *round_trips, double *syscalls_per_msg) {
+  const auto port = next_port++;
+  Common::Logger logger("socket_benchmark_" + Common::tcpBackendToString(cfg.backend_) + ".log");
+  Common::TCPServer server(logger, cfg.backend_);
+
+  // With epoll every echo is sent by the send() which TCPSocket::sendAndRecv() makes right after the recvmsg() that called back.
+  size_t num_syscalls = 0;
+  server.recv_callback_ = [&num_syscalls](Common::TCPSocket *socket, Common::Nanos) {
+    socket->send(socket->inbound_data_.data(), socket->next_rcv_valid_index_);
+    socket->next_rcv_valid_index_ = 0;
+    ++num_syscalls;
+  };
+  server.recv_finished_callback_ = []() {};
+  server.listen("lo", port);
+
+  // System calls of one server loop iteration, with epoll one epoll_wait(), a recvmsg() per connection and a send() per connection with data to send.
+  auto serverIteration = [&]() {
+    server.poll();
+    if (server.io_uring_) {
+      server.sendAndRecv();
+      return;
+    }
+    num_syscalls += 1 + server.receive_sockets_.size() + server.send_sockets_.size() +
+                    std::count_if(server.receive_sockets_.begin(), server.receive_sockets_.end(), [](auto socket) { return socket->next_send_valid_index_ > 0; });
+    server.sendAndRecv();
+  };
+
+  std::vector<int> clients;
+  for (size_t i = 0; i < cfg.num_connections_; ++i) {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT(fd >= 0 && !connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) && Common::setNonBlocking(fd) && Common::disableNagle(fd),
+           "Failed to connect to the echo server on port:" + std::to_string(port) + " error:" + std::string(std::strerror(errno)));
+    clients.push_back(fd);
+  }
+  while (server.receive_sockets_.size() < cfg.num_connections_)
+    serverIteration();
+
+  const auto start_syscalls = (server.io_uring_ ? server.io_uring_->num_enter_calls_ : num_syscalls);
+  const char message[message_size] = {};
+  char echo[message_size * 4];
+  std::vector<size_t> received(cfg.num_connections_);
+
+  round_trips->clear();
+  round_trips->reserve(cfg.num_rounds_);
+  for (size_t round = 0; round < cfg.num_rounds_; ++round) {
+    const auto round_start = Common::getCurrentNanos();
+    for (const auto fd : clients)
+      ASSERT(::send(fd, message, message_size, MSG_NOSIGNAL) == static_cast<ssize_t>(message_size), "Client send failed.");
+
+    std::fill(received.begin(), received.end(), 0);
+    for (size_t num_done = 0; num_done < cfg.num_connections_;) {
+      ASSERT(Common::getCurrentNanos() - round_start < round_timeout, "Round:" + std::to_string(round) + " timed out.");
+      serverIteration();
+
+      for (size_t i = 0; i < clients.size(); ++i) {
+        if (received[i] == message_size)
+          continue;
+        const auto n = ::recv(clients[i], echo, sizeof(echo), MSG_DONTWAIT);
+        if (n > 0 && (received[i] += n) == message_size)
+          ++num_done;
+      }
+    }
+    round_trips->push_back(Common::getCurrentNanos() - round_start);
+  }
+
+  const auto end_syscalls = (server.io_uring_ ? server.io_uring_->num_enter_calls_ : num_syscalls);
+  *syscalls_per_msg = static_cast<double>(end_syscalls - start_syscalls) / (cfg.num_rounds_ * cfg.num_connections_);
+
+  // Disconnect and let the server destroy its connections and their buffers before the next run.
+  for (const auto fd : clients)
+    close(fd);
+  const auto close_start = Common::getCurrentNanos();
+  while (!server.receive_sockets_.empty() && Common::getCurrentNanos() - close_start < round_timeout)
+    serverIteration();
+  close(server.listener_socket_.socket_fd_);
+}
+
+/// Run one configuration and print a CSV line of results.
+auto printBenchmark(const SocketBenchmarkCfg &cfg) {
+  std::vector<Common::Nanos> round_trips;
+  double syscalls_per_msg = 0;
+  runBenchmark(cfg, &round_trips, &syscalls_per_msg);
+
+  Common::Nanos total = 0;
+  for (const auto round_trip : round_trips)
+    total += round_trip;
+  std::sort(round_trips.begin(), round_trips.end());
+  auto percentile = [&round_trips](double p) { return round_trips[std::min(round_trips.size() - 1, static_cast<size_t>(p * round_trips.size()))]; };
+
+  std::cout << Common::tcpBackendToString(cfg.backend_) << "," << cfg.num_connections_ << "," << cfg.num_rounds_ * cfg.num_connections_ << ","
+            << syscalls_per_msg << "," << static_cast<uint64_t>(static_cast<double>(cfg.num_rounds_ * cfg.num_connections_) / total * Common::NANOS_TO_SECS)
+            << "," << percentile(0.5) << "," << percentile(0.99) << std::endl;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 1 && argc != 4) {
+    FATAL("USAGE socket_benchmark [BACKEND(0=EPOLL|1=IO_URING|2=IO_URING_SQPOLL) NUM_CONNECTIONS NUM_ROUNDS]");
+  }
+
+  std::cout << "backend,connections,messages,server_syscalls_per_msg,msgs_per_sec,p50_round_ns,p99_round_ns" << std::endl;
+
+  if (argc == 4) {
+    printBenchmark({static_cast<Common::TCPBackend>(std::stoul(argv[1])), std::stoul(argv[2]), std::stoul(argv[3])});
+    exit(EXIT_SUCCESS);
+  }
+
+  // Default sweep - every backend with a growing number of connections. Every server connection allocates TCPBufferSize send and receive buffers,
+  // plus another send buffer with io_uring, which bounds the connection counts that fit in memory.
+  for (const size_t num_connections : {1, 4, 16}) {
+    for (const auto backend : {Common::TCPBackend::EPOLL, Common::TCPBackend::IO_URING, Common::TCPBackend::IO_URING_SQPOLL}) {
+      printBenchmark({backend, num_connections, 20000 / num_connections});
+    }
+  }
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,74 @@
+#include "common/time_utils.h"
+
+#include "order_server/order_entry_protocol.h"
+#include "market_data/market_data_protocol.h"
+
+static constexpr size_t loop_count = 1000000;
+
+/// Stands in for the send buffer of a TCPSocket / McastSocket, frames are encoded into it the same way.
+struct WireBuffer {
+  std::vector<char> outbound_data_ = std::vector<char>(64 * 1024 * 1024);
+  size_t next_send_valid_index_ = 0;
+};
+
+/// Encode the messages in frames of batch_size messages, then decode every frame and print the average wire bytes per message and the nanoseconds to encode / decode one.
+template<typename Wire, typename Legacy, typename T>
+void benchmarkWire(const std::string &name, uint16_t schema_id, const std::vector<T> &messages, size_t batch_size) {
+  Common::WireFrameEncoder encoder(schema_id, 1, Common::WIRE_MAX_FRAME_SIZE);
+  WireBuffer buffer;
+
+  // Frames are kept back to back in one buffer so they can be decoded afterwards, skipping a sequence number at the start of every batch
+  // makes the encoder start a new frame the same way a flush by sendAndRecv() would.
+  const auto encode_start = Common::getCurrentNanos();
+  for (size_t i = 0; i < messages.size(); ++i) {
+    encoder.append<Wire>(&buffer, i + i / batch_size)->encode(messages[i]);
+  }
+  const auto encode_nanos = Common::getCurrentNanos() - encode_start;
+  const auto wire_bytes = buffer.next_send_valid_index_;
+
+  size_t num_frames = 0, num_decoded = 0, checksum = 0;
+  const auto decode_start = Common::getCurrentNanos();
+  Common::decodeWireFrames(buffer.outbound_data_.data(), wire_bytes, [&](const Common::WireFrameHeader *frame) {
+    Common::forEachWireMessage(frame, schema_id, [&](size_t seq_num, const Common::WireMessageHeader *message_header, const char *block) {
+      const auto decoded = Common::wireMessage<Wire>(message_header, block)->decode();
+      checksum += seq_num + static_cast<size_t>(decoded.ticker_id_);
+      ++num_decoded;
+    });
+    ++num_frames;
+    return true;
+  });
+  const auto decode_nanos = Common::getCurrentNanos() - decode_start;
+
+  ASSERT(num_decoded == messages.size(), "Decoded " + std::to_string(num_decoded) + " of " + std::to_string(messages.size()) + " messages.");
+  std::cout << name << " BATCH:" << batch_size << " FRAMES:" << num_frames
+            << " BYTES/MSG:" << static_cast<double>(wire_bytes) / messages.size() << " (was " << sizeof(Legacy) << ")"
+            << " ENCODE:" << static_cast<double>(encode_nanos) / messages.size() << " NS/MSG"
+            << " DECODE:" << static_cast<double>(decode_nanos) / messages.size() << " NS/MSG"
+            << " CHECKSUM:" << checksum << std::endl;
+}
+
+int main(int, char **) {
+  srand(0);
+
+  std::vector<Exchange::MEClientRequest> client_requests;
+  std::vector<Exchange::MEClientResponse> client_responses;
+  std::vector<Exchange::MEMarketUpdate> market_updates;
+  for (size_t i = 0; i < loop_count; ++i) {
+    const Common::TickerId ticker_id = rand() % 8;
+    const Common::Price price = 100 + rand() % 100;
+    const Common::Qty qty = 1 + rand() % 100;
+    const auto side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);
+
+    client_requests.push_back({Exchange::ClientRequestType::NEW, 1, ticker_id, i, side, price, qty, Exchange::OrderType::LIMIT, Exchange::TimeInForce::GTC});
+    client_responses.push_back({Exchange::ClientResponseType::ACCEPTED, 1, ticker_id, i, i + 1000, side, price, 0, qty, true});
+    market_updates.push_back({Exchange::MarketUpdateType::ADD, i + 1000, ticker_id, side, price, qty, static_cast<Common::Priority>(1 + rand() % 10), true});
+  }
+
+  for (const size_t batch_size : {1, 8, 64}) {
+    benchmarkWire<Exchange::WireClientRequest, Exchange::OMClientRequest>("CLIENT_REQUEST", Exchange::ORDER_ENTRY_SCHEMA_ID, client_requests, batch_size);
+    benchmarkWire<Exchange::WireClientResponse, Exchange::OMClientResponse>("CLIENT_RESPONSE", Exchange::ORDER_ENTRY_SCHEMA_ID, client_responses, batch_size);
+    benchmarkWire<Exchange::WireMarketUpdate, Exchange::MDPMarketUpdate>("MARKET_UPDATE", Exchange::MARKET_DATA_SCHEMA_ID, market_updates, batch_size);
+  }
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,31 @@
+#include "instrument_registry.h"
+
+#include <fstream>
+
+namespace Common {
+  /// List the instruments from a text file with one "SYMBOL MAX_ORDERS [CHANNEL]" entry per line, blank lines and lines starting with '#' are skipped.
+  /// Instruments without a CHANNEL are published on market data channel 0. Returns false if the file cannot be opened.
+  auto loadInstruments(const std::string &file_name, InstrumentRegistry *registry) -> bool {
+    std::ifstream file(file_name);
+    if (!file.is_open())
+      return false;
+
+    std::string line;
+    for (size_t line_num = 1; std::getline(file, line); ++line_num) {
+      if (line.empty() || line[0] == '#')
+        continue;
+
+      std::istringstream ss(line);
+      std::string symbol;
+      size_t max_orders = 0;
+      ASSERT(static_cast<bool>(ss >> symbol >> max_orders), "Invalid instrument at " + file_name + ":" + std::to_string(line_num) + " " + line);
+
+      ChannelId channel_id = 0;
+      if (!(ss >> std::ws).eof())
+        ASSERT(static_cast<bool>(ss >> channel_id), "Invalid channel at " + file_name + ":" + std::to_string(line_num) + " " + line);
+      registry->add(symbol, max_orders, channel_id);
+    }
+
+    return true;
+  }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "common/macros.h"
+#include "common/types.h"
+
+namespace Common {
+  /// Static attributes of a listed trading instrument.
+  struct InstrumentInfo {
+    TickerId ticker_id_ = TickerId_INVALID;
+    std::string symbol_;
+
+    /// Maximum number of orders resting in this instrument's order book at the same time, sizes the memory pools for the instrument.
+    size_t max_orders_ = 0;
+
+    /// Market data channel which carries this instrument's incremental and snapshot streams.
+    ChannelId channel_id_ = 0;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "InstrumentInfo"
+         << "["
+         << "ticker:" << tickerIdToString(ticker_id_) << " "
+         << "symbol:" << symbol_ << " "
+         << "max_orders:" << max_orders_ << " "
+         << "channel:" << channelIdToString(channel_id_)
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Instruments listed on the exchange, built at startup instead of being fixed at compile time.
+  /// TickerIds are assigned densely in listing order, so per instrument containers are vectors indexed directly by TickerId on the hot path
+  /// and only hold entries for listed instruments.
+  class InstrumentRegistry final {
+  public:
+    InstrumentRegistry() = default;
+
+    /// List a new instrument published on market data channel channel_id and return the TickerId assigned to it.
+    auto add(const std::string &symbol, size_t max_orders, ChannelId channel_id) -> TickerId {
+      ASSERT(symbol_ticker_.find(symbol) == symbol_ticker_.end(), "Instrument already listed:" + symbol);
+      ASSERT(max_orders > 0, "Instrument:" + symbol + " needs a non-zero max_orders.");
+      ASSERT(channel_id != ChannelId_INVALID, "Instrument:" + symbol + " needs a valid channel.");
+
+      const auto ticker_id = static_cast<TickerId>(instruments_.size());
+      instruments_.push_back({ticker_id, symbol, max_orders, channel_id});
+      symbol_ticker_[symbol] = ticker_id;
+      total_max_orders_ += max_orders;
+      num_channels_ = std::max(num_channels_, static_cast<size_t>(channel_id) + 1);
+      return ticker_id;
+    }
+
+    auto isListed(TickerId ticker_id) const noexcept {
+      return (ticker_id < instruments_.size());
+    }
+
+    auto at(TickerId ticker_id) const -> const InstrumentInfo & {
+      return instruments_.at(ticker_id);
+    }
+
+    /// Returns the TickerId of the instrument listed with this symbol, or TickerId_INVALID.
+    auto find(const std::string &symbol) const noexcept -> TickerId {
+      const auto itr = symbol_ticker_.find(symbol);
+      return (itr == symbol_ticker_.end() ? TickerId_INVALID : itr->second);
+    }
+
+    /// Number of listed instruments, TickerIds are [0, size()).
+    auto size() const noexcept {
+      return instruments_.size();
+    }
+
+    /// Sum of max_orders_ across all listed instruments.
+    auto totalMaxOrders() const noexcept {
+      return total_max_orders_;
+    }
+
+    /// Number of market data channels the instruments are assigned to, ChannelIds are [0, numChannels()).
+    auto numChannels() const noexcept {
+      return num_channels_;
+    }
+
+    /// Deleted copy & move constructors and assignment-operators.
+    InstrumentRegistry(const InstrumentRegistry &) = delete;
+
+    InstrumentRegistry(const InstrumentRegistry &&) = delete;
+
+    InstrumentRegistry &operator=(const InstrumentRegistry &) = delete;
+
+    InstrumentRegistry &operator=(const InstrumentRegistry &&) = delete;
+
+  private:
+    std::vector<InstrumentInfo> instruments_;
+    std::unordered_map<std::string, TickerId> symbol_ticker_;
+    size_t total_max_orders_ = 0;
+    size_t num_channels_ = 0;
+  };
+
+  /// List the instruments from a text file with one "SYMBOL MAX_ORDERS [CHANNEL]" entry per line, blank lines and lines starting with '#' are skipped.
+  /// Instruments without a CHANNEL are published on market data channel 0.
+  /// Returns false if the file cannot be opened.
+  auto loadInstruments(const std::string &file_name, InstrumentRegistry *registry) -> bool;
+
+  /// List ME_DEFAULT_NUM_TICKERS instruments with ME_MAX_ORDER_IDS orders each, used when no instrument file is provided.
+  inline auto listDefaultInstruments(InstrumentRegistry *registry) {
+    for (size_t i = 0; i < ME_DEFAULT_NUM_TICKERS; ++i) {
+      registry->add("TICKER" + std::to_string(i), ME_MAX_ORDER_IDS, 0);
+    }
+  }
+}
@@ -0,0 +1,453 @@
+#include "io_uring_tcp.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace Common {
+  IoUringTCP::IoUringTCP(Logger &logger, bool sqpoll)
+      : sqpoll_(sqpoll), connections_(IO_URING_MAX_SOCKETS), logger_(logger) {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | (sqpoll_ ? IORING_SETUP_SQPOLL : 0);
+    params.cq_entries = IO_URING_SQ_ENTRIES * IO_URING_CQ_ENTRIES_FACTOR;
+    params.sq_thread_idle = IO_URING_SQPOLL_IDLE_MS;
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, IO_URING_SQ_ENTRIES, &params));
+    ASSERT(ring_fd_ >= 0, "io_uring_setup() failed error:" + std::string(std::strerror(errno)));
+    ASSERT(params.features & IORING_FEAT_SINGLE_MMAP, "io_uring does not map the submission and completion queues as one, kernel is too old.");
+
+    // The submission and completion queue rings share one mapping, the submission queue entries are mapped separately.
+    rings_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    rings_ = mmap(nullptr, rings_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    ASSERT(rings_ != MAP_FAILED, "mmap() of io_uring rings failed error:" + std::string(std::strerror(errno)));
+    sq_entries_ = params.sq_entries;
+    sqes_ = reinterpret_cast<io_uring_sqe *>(mmap(nullptr, sq_entries_ * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                   ring_fd_, IORING_OFF_SQES));
+    ASSERT(sqes_ != MAP_FAILED, "mmap() of io_uring submission queue entries failed error:" + std::string(std::strerror(errno)));
+
+    auto rings = reinterpret_cast<char *>(rings_);
+    sq_head_ = reinterpret_cast<unsigned *>(rings + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(rings + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(rings + params.sq_off.ring_mask);
+    sq_flags_ = reinterpret_cast<unsigned *>(rings + params.sq_off.flags);
+    sq_array_ = reinterpret_cast<unsigned *>(rings + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(rings + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(rings + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(rings + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(rings + params.cq_off.cqes);
+
+    // Submission queue entries are used in order, so the indirection array never changes.
+    for (unsigned i = 0; i < sq_entries_; ++i)
+      sq_array_[i] = i;
+    sqe_tail_ = submitted_tail_ = *sq_tail_;
+
+    // Provided buffer ring the kernel picks the buffers for multishot receives from.
+    buf_ring_ = reinterpret_cast<io_uring_buf_ring *>(mmap(nullptr, IO_URING_RECV_BUFFERS * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                                                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0));
+    ASSERT(buf_ring_ != MAP_FAILED, "mmap() of provided buffer ring failed error:" + std::string(std::strerror(errno)));
+    io_uring_buf_reg buf_reg{};
+    buf_reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    buf_reg.ring_entries = IO_URING_RECV_BUFFERS;
+    buf_reg.bgid = 0;
+    ASSERT(!syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PBUF_RING, &buf_reg, 1),
+           "Failed to register provided buffer ring error:" + std::string(std::strerror(errno)));
+    recv_buffers_.resize(IO_URING_RECV_BUFFERS * IO_URING_RECV_BUFFER_SIZE);
+    for (unsigned bid = 0; bid < IO_URING_RECV_BUFFERS; ++bid)
+      recycleBuffer(bid);
+
+    // Sparse table of fixed files, sockets are registered in a free slot when added so submissions do not look up the file descriptor.
+    io_uring_rsrc_register files_reg{};
+    files_reg.nr = IO_URING_MAX_SOCKETS;
+    files_reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    ASSERT(!syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES2, &files_reg, sizeof(files_reg)),
+           "Failed to register fixed files error:" + std::string(std::strerror(errno)));
+
+    free_slots_.reserve(IO_URING_MAX_SOCKETS);
+    for (unsigned slot = IO_URING_MAX_SOCKETS; slot > 0; --slot)
+      free_slots_.push_back(slot - 1);
+    received_slots_.reserve(IO_URING_MAX_SOCKETS);
+    rearm_slots_.reserve(IO_URING_MAX_SOCKETS);
+
+    logger_.log("%:% %() % io_uring fd:% sqpoll:% sq_entries:% cq_entries:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                ring_fd_, sqpoll_, sq_entries_, params.cq_entries);
+  }
+
+  /// Closing the ring cancels everything in flight and drops the registered files and buffers, the sockets are left to their owners.
+  IoUringTCP::~IoUringTCP() {
+    close(ring_fd_);
+    munmap(sqes_, sq_entries_ * sizeof(io_uring_sqe));
+    munmap(rings_, rings_size_);
+    munmap(buf_ring_, IO_URING_RECV_BUFFERS * sizeof(io_uring_buf));
+  }
+
+  /// Accept connections on a listening socket with a multishot accept, accept_callback_ is called with the file descriptor of every new connection.
+  auto IoUringTCP::accept(int listener_fd) -> void {
+    listener_fd_ = listener_fd;
+
+    auto sqe = getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener_fd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = static_cast<uint64_t>(IoUringOp::ACCEPT) << 32;
+  }
+
+  /// Start receiving on a connected socket, the socket's data is moved by this backend from now on.
+  auto IoUringTCP::addSocket(TCPSocket *socket) -> void {
+    ASSERT(!free_slots_.empty(), "Too many sockets on io_uring, max:" + std::to_string(IO_URING_MAX_SOCKETS));
+    const auto slot = free_slots_.back();
+    free_slots_.pop_back();
+
+    auto &connection = connections_[slot];
+    connection.socket_ = socket;
+    connection.send_data_.resize(TCPBufferSize);
+    connection.send_offset_ = connection.send_len_ = 0;
+    connection.send_in_flight_ = connection.recv_armed_ = connection.recv_throttled_ = connection.removed_ = false;
+    connection.received_buffers_.clear();
+    connection.num_in_flight_ = 0;
+
+    registerFile(slot, socket->socket_fd_);
+    socket->io_uring_ = this;
+    socket->io_uring_slot_ = slot;
+
+    logger_.log("%:% %() % added socket:% slot:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket->socket_fd_, slot);
+    armRecv(slot);
+  }
+
+  /// Stop moving the data of a socket whose connection was closed, the socket is closed and destroyed once nothing is in flight on it anymore.
+  auto IoUringTCP::removeSocket(TCPSocket *socket) noexcept -> void {
+    const auto slot = socket->io_uring_slot_;
+    auto &connection = connections_[slot];
+    connection.removed_ = true;
+
+    for (const auto &[bid, len] : connection.received_buffers_)
+      recycleBuffer(bid);
+    connection.received_buffers_.clear();
+    received_slots_.erase(std::remove(received_slots_.begin(), received_slots_.end(), slot), received_slots_.end());
+    rearm_slots_.erase(std::remove(rearm_slots_.begin(), rearm_slots_.end(), slot), rearm_slots_.end());
+
+    // Cancel the receive and send still in flight, the slot is only released once their completions are in.
+    if (connection.num_in_flight_) {
+      auto sqe = getSqe();
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = static_cast<int32_t>(slot);
+      sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_FD_FIXED | IORING_ASYNC_CANCEL_ALL;
+      sqe->user_data = (static_cast<uint64_t>(IoUringOp::CANCEL) << 32) | slot;
+      ++connection.num_in_flight_;
+    }
+
+    releaseIfDone(slot);
+  }
+
+  /// Send the data in the socket's outbound_data_, now if no send is in flight on it or else as soon as that completes.
+  auto IoUringTCP::flush(TCPSocket *socket) noexcept -> void {
+    const auto &connection = connections_[socket->io_uring_slot_];
+    if (!connection.send_in_flight_ && !connection.removed_ && socket->next_send_valid_index_)
+      startSend(socket->io_uring_slot_);
+  }
+
+  /// Submit what was queued, process the completions and call recv_callback_ for sockets which received data.
+  auto IoUringTCP::poll() noexcept -> bool {
+    submit();
+
+    // Completions which did not fit the completion queue are only flushed to it by entering the kernel.
+    if (UNLIKELY(__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW))
+      enter(0, 0, IORING_ENTER_GETEVENTS);
+
+    auto head = *cq_head_;
+    const auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head != tail) {
+      for (; head != tail; ++head)
+        processCompletion(cqes_[head & *cq_mask_]);
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    // Receives which stopped for lack of provided buffers are restarted once some were returned.
+    if (UNLIKELY(!rearm_slots_.empty() && num_free_buffers_)) {
+      for (const auto slot : rearm_slots_)
+        armRecv(slot);
+      rearm_slots_.clear();
+    }
+
+    return (!received_slots_.empty() && deliverReceived());
+  }
+
+  auto IoUringTCP::getSqe() noexcept -> io_uring_sqe * {
+    // The submission queue is full, hand it to the kernel and wait for it to consume some entries.
+    while (UNLIKELY(sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)) {
+      submit();
+      if (sqpoll_)
+        enter(0, 0, IORING_ENTER_SQ_WAIT);
+    }
+
+    auto sqe = &sqes_[sqe_tail_ & *sq_mask_];
+    memset(sqe, 0, sizeof(*sqe));
+    ++sqe_tail_;
+    return sqe;
+  }
+
+  auto IoUringTCP::enter(unsigned to_submit, unsigned min_complete, unsigned flags) noexcept -> int {
+    ++num_enter_calls_;
+    const auto ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0));
+    if (UNLIKELY(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)) {
+      logger_.log("%:% %() % io_uring_enter() failed error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  std::strerror(errno));
+    }
+    return ret;
+  }
+
+  /// Hand the queued submission queue entries to the kernel, with SQPOLL its thread picks them up and only needs a wake up if it went to sleep.
+  auto IoUringTCP::submit() noexcept -> void {
+    if (sqe_tail_ == submitted_tail_)
+      return;
+
+    const auto to_submit = sqe_tail_ - submitted_tail_;
+    submitted_tail_ = sqe_tail_;
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+
+    if (sqpoll_) {
+      // The tail store has to be visible before the flag is checked, or the kernel thread could go to sleep without seeing the new entries.
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (UNLIKELY(__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP))
+        enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+    } else {
+      enter(to_submit, 0, 0);
+    }
+  }
+
+  /// Multishot receive into the provided buffer ring, it keeps completing with one buffer each until it runs out of buffers or the connection closes.
+  auto IoUringTCP::armRecv(unsigned slot) noexcept -> void {
+    auto &connection = connections_[slot];
+    if (connection.recv_armed_ || connection.recv_throttled_ || connection.removed_)
+      return;
+
+    auto sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = static_cast<int32_t>(slot);
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = 0;
+    sqe->user_data = (static_cast<uint64_t>(IoUringOp::RECV) << 32) | slot;
+
+    connection.recv_armed_ = true;
+    ++connection.num_in_flight_;
+  }
+
+  /// Stop a connection whose socket does not take its data from taking more provided buffers, the data backs up in the kernel's socket buffer
+  /// instead and TCP flow control pushes back on that sender only. The receive is re-armed by deliverReceived() once its buffers were delivered.
+  auto IoUringTCP::throttleRecv(unsigned slot) noexcept -> void {
+    auto &connection = connections_[slot];
+    connection.recv_throttled_ = true;
+    if (!connection.recv_armed_)
+      return;
+
+    auto sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (static_cast<uint64_t>(IoUringOp::RECV) << 32) | slot;
+    sqe->user_data = (static_cast<uint64_t>(IoUringOp::CANCEL) << 32) | slot;
+    ++connection.num_in_flight_;
+  }
+
+  /// Send the socket's outbound_data_ after swapping it with the connection's send buffer, the socket starts over with an empty one.
+  auto IoUringTCP::startSend(unsigned slot) noexcept -> void {
+    auto &connection = connections_[slot];
+    auto socket = connection.socket_;
+
+    connection.send_data_.swap(socket->outbound_data_);
+    connection.send_offset_ = 0;
+    connection.send_len_ = socket->next_send_valid_index_;
+    socket->next_send_valid_index_ = 0;
+
+    auto sqe = getSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = static_cast<int32_t>(slot);
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->addr = reinterpret_cast<uint64_t>(connection.send_data_.data());
+    sqe->len = static_cast<uint32_t>(connection.send_len_);
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = (static_cast<uint64_t>(IoUringOp::SEND) << 32) | slot;
+
+    connection.send_in_flight_ = true;
+    ++connection.num_in_flight_;
+  }
+
+  /// Return a provided buffer to the ring for the kernel to receive into again.
+  auto IoUringTCP::recycleBuffer(uint16_t bid) noexcept -> void {
+    // Indexed as a plain array since the header declares bufs[] as a flexible array after an empty struct, which has a size in C++ and shifts it.
+    auto &buf = reinterpret_cast<io_uring_buf *>(buf_ring_)[buf_ring_tail_ & (IO_URING_RECV_BUFFERS - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(recv_buffers_.data() + bid * IO_URING_RECV_BUFFER_SIZE);
+    buf.len = IO_URING_RECV_BUFFER_SIZE;
+    buf.bid = bid;
+    ++buf_ring_tail_;
+    __atomic_store_n(&buf_ring_->tail, buf_ring_tail_, __ATOMIC_RELEASE);
+    ++num_free_buffers_;
+  }
+
+  auto IoUringTCP::processCompletion(const io_uring_cqe &cqe) noexcept -> void {
+    const auto op = static_cast<IoUringOp>(cqe.user_data >> 32);
+    const auto slot = static_cast<unsigned>(cqe.user_data & 0xffffffff);
+    const bool more = (cqe.flags & IORING_CQE_F_MORE);
+
+    switch (op) {
+      case IoUringOp::ACCEPT: {
+        if (LIKELY(cqe.res >= 0)) {
+          accept_callback_(cqe.res);
+        } else {
+          logger_.log("%:% %() % accept failed error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), std::strerror(-cqe.res));
+        }
+        if (!more)
+          accept(listener_fd_);
+      }
+        break;
+
+      case IoUringOp::RECV: {
+        auto &connection = connections_[slot];
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+          const auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+          --num_free_buffers_;
+          if (UNLIKELY(cqe.res <= 0 || connection.removed_)) {
+            recycleBuffer(bid);
+          } else {
+            if (connection.received_buffers_.empty()) {
+              connection.rx_time_ = getCurrentNanos();
+              received_slots_.push_back(slot);
+            }
+            connection.received_buffers_.emplace_back(bid, cqe.res);
+            if (UNLIKELY(connection.received_buffers_.size() >= IO_URING_MAX_CONNECTION_BUFFERS && !connection.recv_throttled_ && more))
+              throttleRecv(slot);
+          }
+        }
+
+        if (UNLIKELY(cqe.res <= 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED && !connection.removed_)) {
+          if (!connection.socket_->disconnected_) {
+            logger_.log("%:% %() % disconnected socket:% error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                        connection.socket_->socket_fd_, (cqe.res == 0 ? "closed by peer" : std::strerror(-cqe.res)));
+          }
+          connection.socket_->disconnected_ = true;
+        }
+
+        if (!more) {
+          connection.recv_armed_ = false;
+          --connection.num_in_flight_;
+          // A receive cancelled by throttleRecv() whose connection was already delivered to in the meantime is restarted like one out of buffers.
+          if ((cqe.res == -ENOBUFS || cqe.res == -ECANCELED) && !connection.recv_throttled_ && !connection.removed_)
+            rearm_slots_.push_back(slot);
+          releaseIfDone(slot);
+        }
+      }
+        break;
+
+      case IoUringOp::SEND: {
+        auto &connection = connections_[slot];
+        --connection.num_in_flight_;
+        connection.send_in_flight_ = false;
+        if (UNLIKELY(connection.removed_)) {
+          releaseIfDone(slot);
+          break;
+        }
+
+        if (UNLIKELY(cqe.res < 0)) {
+          if (!connection.socket_->disconnected_) {
+            logger_.log("%:% %() % send failed socket:% error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                        connection.socket_->socket_fd_, std::strerror(-cqe.res));
+          }
+          connection.socket_->disconnected_ = true;
+          break;
+        }
+
+        // Resubmit the rest of a short send before anything written since, which keeps the stream in order.
+        connection.send_offset_ += cqe.res;
+        if (UNLIKELY(connection.send_offset_ < connection.send_len_)) {
+          auto sqe = getSqe();
+          sqe->opcode = IORING_OP_SEND;
+          sqe->fd = static_cast<int32_t>(slot);
+          sqe->flags = IOSQE_FIXED_FILE;
+          sqe->addr = reinterpret_cast<uint64_t>(connection.send_data_.data() + connection.send_offset_);
+          sqe->len = static_cast<uint32_t>(connection.send_len_ - connection.send_offset_);
+          sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+          sqe->user_data = (static_cast<uint64_t>(IoUringOp::SEND) << 32) | slot;
+          connection.send_in_flight_ = true;
+          ++connection.num_in_flight_;
+        } else if (connection.socket_->next_send_valid_index_) {
+          startSend(slot);
+        }
+      }
+        break;
+
+      case IoUringOp::CANCEL: {
+        --connections_[slot].num_in_flight_;
+        releaseIfDone(slot);
+      }
+        break;
+    }
+  }
+
+  /// Copy received buffers to the sockets which can take them and call back, returns true if any recv_callback_ was called.
+  /// Buffers of a paused socket stay out of the ring until it resumes, at most IO_URING_MAX_CONNECTION_BUFFERS of them per connection.
+  auto IoUringTCP::deliverReceived() noexcept -> bool {
+    bool recv = false;
+
+    for (auto itr = received_slots_.begin(); itr != received_slots_.end();) {
+      const auto slot = *itr;
+      auto &connection = connections_[slot];
+      auto socket = connection.socket_;
+      if (socket->recv_paused_) {
+        ++itr;
+        continue;
+      }
+
+      size_t num_copied = 0;
+      for (const auto &[bid, len] : connection.received_buffers_) {
+        if (socket->next_rcv_valid_index_ + len > TCPBufferSize)
+          break;
+        memcpy(socket->inbound_data_.data() + socket->next_rcv_valid_index_, recv_buffers_.data() + bid * IO_URING_RECV_BUFFER_SIZE, len);
+        socket->next_rcv_valid_index_ += len;
+        recycleBuffer(bid);
+        ++num_copied;
+      }
+      connection.received_buffers_.erase(connection.received_buffers_.begin(), connection.received_buffers_.begin() + num_copied);
+
+      const auto rx_time = connection.rx_time_;
+      if (connection.received_buffers_.empty()) {
+        itr = received_slots_.erase(itr);
+        if (UNLIKELY(connection.recv_throttled_)) {
+          connection.recv_throttled_ = false;
+          armRecv(slot);
+        }
+      } else {
+        connection.rx_time_ = getCurrentNanos();
+        ++itr;
+      }
+
+      if (num_copied) {
+        logger_.log("%:% %() % read socket:% len:% utime:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    socket->socket_fd_, socket->next_rcv_valid_index_, rx_time);
+        socket->recv_callback_(socket, rx_time);
+        recv = true;
+      }
+    }
+
+    return recv;
+  }
+
+  /// Free the slot and close and destroy the socket of a removed connection once nothing is in flight on it.
+  auto IoUringTCP::releaseIfDone(unsigned slot) noexcept -> void {
+    auto &connection = connections_[slot];
+    if (!connection.removed_ || connection.num_in_flight_)
+      return;
+
+    registerFile(slot, -1);
+    logger_.log("%:% %() % released socket:% slot:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                connection.socket_->socket_fd_, slot);
+    close(connection.socket_->socket_fd_);
+    delete connection.socket_;
+    connection.socket_ = nullptr;
+    connection.removed_ = false;
+    free_slots_.push_back(slot);
+  }
+
+  auto IoUringTCP::registerFile(unsigned slot, int fd) noexcept -> void {
+    io_uring_files_update update{};
+    update.offset = slot;
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+    const auto ret = syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1);
+    ASSERT(ret == 1, "Failed to register socket:" + std::to_string(fd) + " in slot:" + std::to_string(slot) + " error:" + std::string(std::strerror(errno)));
+  }
+}
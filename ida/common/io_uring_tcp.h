@@ -0,0 +1,165 @@
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include "tcp_socket.h"
+
+namespace Common {
+  /// Number of submission queue entries, the completion queue is IO_URING_CQ_ENTRIES_FACTOR times larger since multishot requests complete many times.
+  constexpr unsigned IO_URING_SQ_ENTRIES = 1024;
+  constexpr unsigned IO_URING_CQ_ENTRIES_FACTOR = 8;
+
+  /// Number and size of the buffers in the provided buffer ring the kernel receives into, the number has to be a power of 2.
+  constexpr unsigned IO_URING_RECV_BUFFERS = 1024;
+  constexpr size_t IO_URING_RECV_BUFFER_SIZE = 16 * 1024;
+
+  /// Most provided buffers one connection holds before its multishot receive is cancelled, so a paused socket or one with a full inbound_data_
+  /// cannot take the whole ring from the other connections. Its receive is re-armed once its buffers were copied to the socket.
+  constexpr size_t IO_URING_MAX_CONNECTION_BUFFERS = IO_URING_RECV_BUFFERS / 16;
+
+  /// Number of registered file slots, i.e. the maximum number of sockets on one IoUringTCP.
+  constexpr unsigned IO_URING_MAX_SOCKETS = 1024;
+
+  /// How long the SQPOLL kernel thread keeps polling the submission queue after the last submission before it goes to sleep.
+  constexpr unsigned IO_URING_SQPOLL_IDLE_MS = 1000;
+
+  /// io_uring backend for TCPSocket and TCPServer, moves the data of any number of sockets with one io_uring.
+  /// - Connections are accepted with a multishot accept and registered in a table of fixed files.
+  /// - Every socket has a multishot receive into a ring of buffers provided to the kernel, the data is copied to the socket's inbound_data_ and
+  ///   recv_callback_ is called the same way TCPSocket::sendAndRecv() does.
+  /// - Sends are submitted from the socket's outbound_data_, which is swapped with a second buffer owned by the backend so the application keeps
+  ///   writing into a buffer the kernel is not reading from. At most one send is in flight per socket, which keeps them in order.
+  /// - Submissions and completions are batched, without SQPOLL one io_uring_enter() per poll() with something to submit and none otherwise,
+  ///   with SQPOLL a kernel thread picks up the submissions and io_uring_enter() is only needed to wake it up.
+  /// Not thread safe, every method has to be called from the thread polling it.
+  class IoUringTCP {
+  public:
+    IoUringTCP(Logger &logger, bool sqpoll);
+
+    ~IoUringTCP();
+
+    /// Accept connections on a listening socket with a multishot accept, accept_callback_ is called with the file descriptor of every new connection.
+    auto accept(int listener_fd) -> void;
+
+    /// Start receiving on a connected socket, the socket's data is moved by this backend from now on.
+    auto addSocket(TCPSocket *socket) -> void;
+
+    /// Stop moving the data of a socket whose connection was closed, the socket is closed and destroyed once nothing is in flight on it anymore.
+    auto removeSocket(TCPSocket *socket) noexcept -> void;
+
+    /// Send the data in the socket's outbound_data_, now if no send is in flight on it or else as soon as that completes.
+    auto flush(TCPSocket *socket) noexcept -> void;
+
+    /// Submit what was queued, process the completions and call recv_callback_ for sockets which received data.
+    /// Returns true if any recv_callback_ was called.
+    auto poll() noexcept -> bool;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    IoUringTCP() = delete;
+
+    IoUringTCP(const IoUringTCP &) = delete;
+
+    IoUringTCP(const IoUringTCP &&) = delete;
+
+    IoUringTCP &operator=(const IoUringTCP &) = delete;
+
+    IoUringTCP &operator=(const IoUringTCP &&) = delete;
+
+    /// Function wrapper to call back with the file descriptor of every accepted connection.
+    std::function<void(int fd)> accept_callback_ = nullptr;
+
+    /// Number of io_uring_enter() system calls made so far, the only system call made per message.
+    size_t num_enter_calls_ = 0;
+
+  private:
+    /// Kind of request in the user data of a submission, the fixed file slot of the socket is in the lower 32 bits.
+    enum class IoUringOp : uint64_t {
+      ACCEPT = 1,
+      RECV = 2,
+      SEND = 3,
+      CANCEL = 4
+    };
+
+    /// State of a socket registered with this backend, indexed by its fixed file slot.
+    struct IoUringConnection {
+      TCPSocket *socket_ = nullptr;
+
+      /// Buffer the send in flight reads from, swapped with the socket's outbound_data_ when a send is started.
+      std::vector<char> send_data_;
+      size_t send_offset_ = 0, send_len_ = 0;
+      bool send_in_flight_ = false;
+
+      bool recv_armed_ = false;
+
+      /// Set once received_buffers_ reached IO_URING_MAX_CONNECTION_BUFFERS, the receive is cancelled and not re-armed until they are delivered.
+      bool recv_throttled_ = false;
+
+      /// Provided buffers received into but not yet copied to the socket, because it was paused or its inbound_data_ was full.
+      std::vector<std::pair<uint16_t, uint32_t>> received_buffers_;
+      Nanos rx_time_ = 0;
+
+      /// Requests in flight on this slot, the slot is only freed once this drops to 0 so no completion refers to a reused slot.
+      size_t num_in_flight_ = 0;
+      bool removed_ = false;
+    };
+
+    auto getSqe() noexcept -> io_uring_sqe *;
+
+    auto enter(unsigned to_submit, unsigned min_complete, unsigned flags) noexcept -> int;
+
+    /// Hand the queued submission queue entries to the kernel.
+    auto submit() noexcept -> void;
+
+    auto armRecv(unsigned slot) noexcept -> void;
+
+    /// Cancel the multishot receive of a connection holding IO_URING_MAX_CONNECTION_BUFFERS buffers.
+    auto throttleRecv(unsigned slot) noexcept -> void;
+
+    auto startSend(unsigned slot) noexcept -> void;
+
+    auto recycleBuffer(uint16_t bid) noexcept -> void;
+
+    auto processCompletion(const io_uring_cqe &cqe) noexcept -> void;
+
+    /// Copy received buffers to the sockets which can take them and call back, returns true if any recv_callback_ was called.
+    auto deliverReceived() noexcept -> bool;
+
+    /// Free the slot and close and destroy the socket of a removed connection once nothing is in flight on it.
+    auto releaseIfDone(unsigned slot) noexcept -> void;
+
+    auto registerFile(unsigned slot, int fd) noexcept -> void;
+
+    const bool sqpoll_ = false;
+
+    int ring_fd_ = -1;
+
+    /// Submission and completion queue rings, mapped from the kernel as one, and the submission queue entries.
+    void *rings_ = nullptr;
+    size_t rings_size_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    unsigned *sq_head_ = nullptr, *sq_tail_ = nullptr, *sq_mask_ = nullptr, *sq_array_ = nullptr, *sq_flags_ = nullptr;
+    unsigned *cq_head_ = nullptr, *cq_tail_ = nullptr, *cq_mask_ = nullptr;
+    io_uring_cqe *cqes_ = nullptr;
+    unsigned sq_entries_ = 0;
+
+    /// Local submission queue tail and the tail last handed to the kernel.
+    unsigned sqe_tail_ = 0, submitted_tail_ = 0;
+
+    /// Provided buffer ring and the buffers it hands out.
+    io_uring_buf_ring *buf_ring_ = nullptr;
+    std::vector<char> recv_buffers_;
+    uint16_t buf_ring_tail_ = 0;
+    size_t num_free_buffers_ = 0;
+
+    int listener_fd_ = -1;
+
+    std::vector<IoUringConnection> connections_;
+    std::vector<unsigned> free_slots_;
+
+    /// Slots with received buffers waiting to be copied to their socket, and slots whose multishot receive ran out of provided buffers.
+    std::vector<unsigned> received_slots_, rearm_slots_;
+
+    std::string time_str_;
+    Logger &logger_;
+  };
+}
@@ -23,6 +23,17 @@ namespace Common {
       num_elements_++;
     }
 
+    /// Fetch the element offset elements past the next one to write to, used to fill a batch of elements before publishing it.
+    auto getNextToWriteTo(size_t offset) noexcept {
+      return &store_[(next_write_index_ + offset) % store_.size()];
+    }
+
+    /// Publish num_elems elements written with getNextToWriteTo(offset) at once, readers never see a partially written batch.
+    auto updateWriteIndex(size_t num_elems) noexcept {
+      next_write_index_ = (next_write_index_ + num_elems) % store_.size();
+      num_elements_ += num_elems;
+    }
+
     auto getNextToRead() const noexcept -> const T * {
       return (size() ? &store_[next_read_index_] : nullptr);
     }
@@ -37,6 +48,11 @@ namespace Common {
       return num_elements_.load();
     }
 
+    /// Maximum number of elements which can be queued and not read yet.
+    auto capacity() const noexcept {
+      return store_.size();
+    }
+
     /// Deleted default, copy & move constructors and assignment-operators.
     LFQueue() = delete;
 
@@ -6,6 +6,7 @@ namespace Common {
   auto McastSocket::init(const std::string &ip, const std::string &iface, int port, bool is_listening) -> int {
     const SocketCfg socket_cfg{ip, iface, port, true, is_listening, false};
     socket_fd_ = createSocket(logger_, socket_cfg);
+    next_exp_packet_seq_num_ = 0; // a re-joined stream continues at whatever packet it is at now.
     return socket_fd_;
   }
 
@@ -22,30 +23,105 @@ namespace Common {
 
   /// Publish outgoing data and read incoming data.
   auto McastSocket::sendAndRecv() noexcept -> bool {
-    // Read data and dispatch callbacks if data is available - non blocking.
-    const ssize_t n_rcv = recv(socket_fd_, inbound_data_.data() + next_rcv_valid_index_, McastBufferSize - next_rcv_valid_index_, MSG_DONTWAIT);
+    // Read a packet and dispatch callbacks if one is available - non blocking. The packet header is read separately so only whole frames land in inbound_data_.
+    WirePacketHeader packet_header;
+    iovec iov[2] = {{&packet_header, sizeof(packet_header)}, {inbound_data_.data() + next_rcv_valid_index_, McastBufferSize - next_rcv_valid_index_}};
+    msghdr msg{nullptr, 0, iov, 2, nullptr, 0, 0};
+    const ssize_t n_rcv = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
     if (n_rcv > 0) {
-      next_rcv_valid_index_ += n_rcv;
-      logger_.log("%:% %() % read socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_,
-                  next_rcv_valid_index_);
+      if (UNLIKELY(static_cast<size_t>(n_rcv) < sizeof(packet_header) || (msg.msg_flags & MSG_TRUNC))) {
+        logger_.log("%:% %() % Dropping malformed packet socket:% len:% flags:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    socket_fd_, n_rcv, msg.msg_flags);
+        return false;
+      }
+
+      if (UNLIKELY(next_exp_packet_seq_num_ && packet_header.packet_seq_num_ != next_exp_packet_seq_num_)) {
+        if (packet_header.packet_seq_num_ > next_exp_packet_seq_num_)
+          num_packets_lost_ += packet_header.packet_seq_num_ - next_exp_packet_seq_num_;
+        logger_.log("%:% %() % Packet gap socket:% expected:% received:% lost:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    socket_fd_, next_exp_packet_seq_num_, packet_header.packet_seq_num_, num_packets_lost_);
+      }
+      next_exp_packet_seq_num_ = packet_header.packet_seq_num_ + 1;
+
+      next_rcv_valid_index_ += n_rcv - sizeof(packet_header);
+      logger_.log("%:% %() % read socket:% packet:% msgs:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_,
+                  packet_header.packet_seq_num_, packet_header.num_messages_, next_rcv_valid_index_);
       recv_callback_(this);
     }
 
-    // Publish market data in the send buffer to the multicast stream.
-    if (next_send_valid_index_ > 0) {
-      ssize_t n = ::send(socket_fd_, outbound_data_.data(), next_send_valid_index_, MSG_DONTWAIT | MSG_NOSIGNAL);
-
-      logger_.log("%:% %() % send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_, n);
+    // Publish the frames in the send buffer to the multicast stream, a partially filled packet once it has waited max_packet_delay_ for more frames.
+    if (next_send_valid_index_ > next_send_packet_index_) {
+      const auto now = getCurrentNanos();
+      if (!partial_packet_time_)
+        partial_packet_time_ = now;
+      sendPackets(now - partial_packet_time_ >= max_packet_delay_);
     }
-    next_send_valid_index_ = 0;
 
     return (n_rcv > 0);
   }
 
-  /// Copy data to send buffers - does not send them out yet.
+  /// Limit the datagrams sent to max_packet_size bytes and let a partially filled packet wait up to max_packet_delay for more frames.
+  auto McastSocket::setPacketization(size_t max_packet_size, Nanos max_packet_delay) -> void {
+    ASSERT(max_packet_size > sizeof(WirePacketHeader) + sizeof(WireFrameHeader) && max_packet_size <= MCAST_MAX_PACKET_SIZE,
+           "Invalid max packet size:" + std::to_string(max_packet_size));
+    max_packet_size_ = max_packet_size;
+    max_packet_delay_ = max_packet_delay;
+  }
+
+  /// Send the frames in the send buffer as packets of whole frames, the last partially filled packet only if send_partial is set.
+  auto McastSocket::sendPackets(bool send_partial) noexcept -> void {
+    const auto max_payload = mcastMaxFrameSize(max_packet_size_);
+    auto data = outbound_data_.data();
+
+    size_t packet_end = next_send_packet_index_;
+    uint16_t num_messages = 0;
+    while (next_send_packet_index_ < next_send_valid_index_) {
+      const bool at_end = (packet_end + sizeof(WireFrameHeader) > next_send_valid_index_);
+      const auto frame = reinterpret_cast<const WireFrameHeader *>(data + packet_end);
+      if (!at_end && frame->length_ >= sizeof(WireFrameHeader) && packet_end + frame->length_ <= next_send_valid_index_ &&
+          packet_end + frame->length_ - next_send_packet_index_ <= max_payload) {
+        packet_end += frame->length_;
+        num_messages += frame->num_messages_;
+        continue;
+      }
+
+      // The packet is closed by a frame which does not fit in it, or by the end of the data if partially filled packets go out too.
+      if (UNLIKELY(packet_end == next_send_packet_index_)) { // only a broken frame does not fit an empty packet.
+        logger_.log("%:% %() % Dropping % bytes which are not whole frames of at most % bytes socket:%\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), next_send_valid_index_ - next_send_packet_index_, max_payload, socket_fd_);
+        next_send_packet_index_ = next_send_valid_index_;
+        break;
+      }
+      if (at_end && !send_partial)
+        break;
+
+      WirePacketHeader packet_header{next_packet_seq_num_++, static_cast<uint64_t>(getCurrentNanos()), num_messages};
+      iovec iov[2] = {{&packet_header, sizeof(packet_header)}, {data + next_send_packet_index_, packet_end - next_send_packet_index_}};
+      const msghdr msg{nullptr, 0, iov, 2, nullptr, 0, 0};
+      const ssize_t n = sendmsg(socket_fd_, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+      logger_.log("%:% %() % send socket:% packet:% msgs:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_,
+                  packet_header.packet_seq_num_, num_messages, n);
+
+      next_send_packet_index_ = packet_end;
+      num_messages = 0;
+    }
+
+    if (next_send_packet_index_ == next_send_valid_index_) { // everything went out, start over at the front of the buffer.
+      next_send_packet_index_ = next_send_valid_index_ = 0;
+      partial_packet_time_ = 0;
+    } else if (next_send_packet_index_ > McastBufferSize / 2) { // move the partially filled packet to the front, encoders start a new frame after it.
+      memmove(data, data + next_send_packet_index_, next_send_valid_index_ - next_send_packet_index_);
+      next_send_valid_index_ -= next_send_packet_index_;
+      next_send_packet_index_ = 0;
+    }
+  }
+
+  /// Copy wire frames to send buffers - does not send them out yet, unless the send buffer is full.
   auto McastSocket::send(const void *data, size_t len) noexcept -> void {
+    if (UNLIKELY(next_send_valid_index_ + len > McastBufferSize))
+      sendPackets(true);
+    ASSERT(next_send_valid_index_ + len <= McastBufferSize, "Mcast socket send of:" + std::to_string(len) + " bytes larger than its buffer.");
     memcpy(outbound_data_.data() + next_send_valid_index_, data, len);
     next_send_valid_index_ += len;
-    ASSERT(next_send_valid_index_ < McastBufferSize, "Mcast socket buffer filled up and sendAndRecv() not called.");
   }
 }
@@ -3,6 +3,7 @@
 #include <functional>
 
 #include "socket_utils.h"
+#include "wire_protocol.h"
 
 #include "logging.h"
 
@@ -10,6 +11,17 @@ namespace Common {
   /// Size of send and receive buffers in bytes.
   constexpr size_t McastBufferSize = 64 * 1024 * 1024;
 
+  /// Largest datagram which fits an Ethernet MTU of 1500 bytes without IP fragmentation, after the 20 byte IPv4 and 8 byte UDP headers.
+  constexpr size_t MCAST_MTU_PACKET_SIZE = 1472;
+
+  /// Largest datagram UDP over IPv4 can carry at all.
+  constexpr size_t MCAST_MAX_PACKET_SIZE = 65507;
+
+  /// Largest frame which fits a packet of max_packet_size bytes, the size the encoders writing to the socket have to cap their frames at.
+  inline auto mcastMaxFrameSize(size_t max_packet_size) noexcept -> size_t {
+    return max_packet_size - sizeof(WirePacketHeader);
+  }
+
   struct McastSocket {
     McastSocket(Logger &logger)
         : logger_(logger) {
@@ -28,9 +40,20 @@ namespace Common {
     auto leave(const std::string &ip, int port) -> void;
 
     /// Publish outgoing data and read incoming data.
+    /// Full packets are always sent, the last partially filled one once it has waited for more frames for max_packet_delay_.
     auto sendAndRecv() noexcept -> bool;
 
-    /// Copy data to send buffers - does not send them out yet.
+    /// Send the packets which are full already, called by publishers between appending frames so a burst goes out as it is encoded.
+    auto sendFullPackets() noexcept -> void {
+      if (UNLIKELY(next_send_valid_index_ - next_send_packet_index_ > mcastMaxFrameSize(max_packet_size_)))
+        sendPackets(false);
+    }
+
+    /// Limit the datagrams sent to max_packet_size bytes and let a partially filled packet wait up to max_packet_delay for more frames,
+    /// frames written to the socket have to fit mcastMaxFrameSize(max_packet_size).
+    auto setPacketization(size_t max_packet_size, Nanos max_packet_delay) -> void;
+
+    /// Copy wire frames to send buffers - does not send them out yet, unless the send buffer is full.
     auto send(const void *data, size_t len) noexcept -> void;
 
     int socket_fd_ = -1;
@@ -44,7 +67,26 @@ namespace Common {
     /// Function wrapper for the method to call when data is read.
     std::function<void(McastSocket *s)> recv_callback_ = nullptr;
 
+    /// Packetization of outgoing frames, by default datagrams fit an Ethernet MTU and every sendAndRecv() sends what was written.
+    size_t max_packet_size_ = MCAST_MTU_PACKET_SIZE;
+    Nanos max_packet_delay_ = 0;
+
+    /// Start of the data in the send buffer not sent yet, and when sendAndRecv() first found it there.
+    size_t next_send_packet_index_ = 0;
+    Nanos partial_packet_time_ = 0;
+
+    /// Sequence number of the next packet sent, and of the next packet expected to be received, 0 until the first one arrives.
+    uint64_t next_packet_seq_num_ = 1;
+    uint64_t next_exp_packet_seq_num_ = 0;
+
+    /// Number of packets lost according to the gaps in the packet sequence numbers received.
+    size_t num_packets_lost_ = 0;
+
     std::string time_str_;
     Logger &logger_;
+
+  private:
+    /// Send the frames in the send buffer as packets of whole frames, the last partially filled packet only if send_partial is set.
+    auto sendPackets(bool send_partial) noexcept -> void;
   };
 }
@@ -35,7 +35,7 @@ int main(int, char **) {
   const int port = 12345;
 
   logger_.log("Creating TCPServer on iface:% port:%\n", iface, port);
-  TCPServer server(logger_);
+  TCPServer server(logger_, TCPBackend::EPOLL);
   server.recv_callback_ = tcpServerRecvCallback;
   server.recv_finished_callback_ = tcpServerRecvFinishedCallback;
   server.listen(iface, port);
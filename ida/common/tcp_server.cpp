@@ -1,26 +1,107 @@
 #include "tcp_server.h"
+#include "io_uring_tcp.h"
 
 namespace Common {
+  TCPServer::~TCPServer() {
+    delete io_uring_;
+    io_uring_ = nullptr;
+  }
+
   /// Add and remove socket file descriptors to and from the EPOLL list.
   auto TCPServer::addToEpollList(TCPSocket *socket) {
     epoll_event ev{EPOLLET | EPOLLIN, {reinterpret_cast<void *>(socket)}};
     return !epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket->socket_fd_, &ev);
   }
 
+  /// Close and destroy sockets whose connection has been closed, after calling back disconnect_callback_ for each of them.
+  /// Sockets are handed to release_callback_ instead if it is set, or to the io_uring backend which destroys them once nothing is in flight on them.
+  auto TCPServer::removeDisconnectedSockets() noexcept {
+    for (auto itr = receive_sockets_.begin(); itr != receive_sockets_.end();) {
+      auto socket = *itr;
+      if (LIKELY(!socket->disconnected_)) {
+        ++itr;
+        continue;
+      }
+
+      logger_.log("%:% %() % removing socket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket->socket_fd_);
+      if (disconnect_callback_)
+        disconnect_callback_(socket);
+
+      itr = receive_sockets_.erase(itr);
+      if (io_uring_) {
+        io_uring_->removeSocket(socket);
+        continue;
+      }
+
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket->socket_fd_, nullptr);
+      send_sockets_.erase(std::remove(send_sockets_.begin(), send_sockets_.end(), socket), send_sockets_.end());
+      if (release_callback_) {
+        release_callback_(socket);
+      } else {
+        close(socket->socket_fd_);
+        delete socket;
+      }
+    }
+  }
+
   /// Start listening for connections on the provided interface and port.
   auto TCPServer::listen(const std::string &iface, int port) -> void {
-    epoll_fd_ = epoll_create(1);
-    ASSERT(epoll_fd_ >= 0, "epoll_create() failed error:" + std::string(std::strerror(errno)));
-
     ASSERT(listener_socket_.connect("", iface, port, true) >= 0,
            "Listener socket failed to connect. iface:" + iface + " port:" + std::to_string(port) + " error:" +
            std::string(std::strerror(errno)));
 
+    logger_.log("%:% %() % listening socket:% backend:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                listener_socket_.socket_fd_, tcpBackendToString(backend_));
+
+    if (backend_ != TCPBackend::EPOLL) {
+      ASSERT(!release_callback_, "release_callback_ is not supported with io_uring.");
+      io_uring_ = new IoUringTCP(logger_, backend_ == TCPBackend::IO_URING_SQPOLL);
+      io_uring_->accept_callback_ = [this](int fd) { addConnection(fd); };
+      io_uring_->accept(listener_socket_.socket_fd_);
+      return;
+    }
+
+    epoll_fd_ = epoll_create(1);
+    ASSERT(epoll_fd_ >= 0, "epoll_create() failed error:" + std::string(std::strerror(errno)));
+
     ASSERT(addToEpollList(&listener_socket_), "epoll_ctl() failed. error:" + std::string(std::strerror(errno)));
   }
 
+  /// Create a TCPSocket for an accepted connection and start receiving on it.
+  auto TCPServer::addConnection(int fd) noexcept -> void {
+    ASSERT(setNonBlocking(fd) && disableNagle(fd),
+           "Failed to set non-blocking or no-delay on socket:" + std::to_string(fd));
+
+    logger_.log("%:% %() % accepted socket:%\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), fd);
+
+    auto socket = new TCPSocket(logger_);
+    socket->socket_fd_ = fd;
+    socket->recv_callback_ = recv_callback_;
+    if (io_uring_) {
+      io_uring_->addSocket(socket);
+    } else {
+      ASSERT(addToEpollList(socket), "Unable to add socket. error:" + std::string(std::strerror(errno)));
+    }
+
+    if (std::find(receive_sockets_.begin(), receive_sockets_.end(), socket) == receive_sockets_.end())
+      receive_sockets_.push_back(socket);
+  }
+
   /// Publish outgoing data from the send buffer and read incoming data from the receive buffer.
   auto TCPServer::sendAndRecv() noexcept -> void {
+    // With io_uring the sends are queued first so one io_uring_enter() submits them all and reaps the completions.
+    if (io_uring_) {
+      std::for_each(receive_sockets_.begin(), receive_sockets_.end(), [](auto socket) {
+        if (socket->next_send_valid_index_)
+          socket->flush();
+      });
+
+      if (io_uring_->poll())
+        recv_finished_callback_();
+      return;
+    }
+
     auto recv = false;
 
     std::for_each(receive_sockets_.begin(), receive_sockets_.end(), [&recv](auto socket) {
@@ -35,8 +116,31 @@ namespace Common {
     });
   }
 
+  /// Only read incoming data from the receive buffers, for users which send on a different thread.
+  auto TCPServer::recv() noexcept -> void {
+    if (io_uring_) {
+      if (io_uring_->poll())
+        recv_finished_callback_();
+      return;
+    }
+
+    auto recv = false;
+
+    std::for_each(receive_sockets_.begin(), receive_sockets_.end(), [&recv](auto socket) {
+      recv |= socket->recv();
+    });
+
+    if (recv) // There were some events and they have all been dispatched, inform listener.
+      recv_finished_callback_();
+  }
+
   /// Check for new connections or dead connections and update containers that track the sockets.
+  /// With io_uring connections are accepted as the completions are processed in sendAndRecv() or recv().
   auto TCPServer::poll() noexcept -> void {
+    removeDisconnectedSockets();
+    if (io_uring_)
+      return;
+
     const int max_events = 1 + send_sockets_.size() + receive_sockets_.size();
 
     const int n = epoll_wait(epoll_fd_, events_, max_events, 0);
@@ -84,19 +188,7 @@ namespace Common {
       if (fd == -1)
         break;
 
-      ASSERT(setNonBlocking(fd) && disableNagle(fd),
-             "Failed to set non-blocking or no-delay on socket:" + std::to_string(fd));
-
-      logger_.log("%:% %() % accepted socket:%\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), fd);
-
-      auto socket = new TCPSocket(logger_);
-      socket->socket_fd_ = fd;
-      socket->recv_callback_ = recv_callback_;
-      ASSERT(addToEpollList(socket), "Unable to add socket. error:" + std::string(std::strerror(errno)));
-
-      if (std::find(receive_sockets_.begin(), receive_sockets_.end(), socket) == receive_sockets_.end())
-        receive_sockets_.push_back(socket);
+      addConnection(fd);
     }
   }
 }
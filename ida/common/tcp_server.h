@@ -4,10 +4,12 @@
 
 namespace Common {
   struct TCPServer {
-    explicit TCPServer(Logger &logger)
-        : listener_socket_(logger), logger_(logger) {
+    TCPServer(Logger &logger, TCPBackend backend)
+        : backend_(backend), listener_socket_(logger), logger_(logger) {
     }
 
+    ~TCPServer();
+
     /// Start listening for connections on the provided interface and port.
     auto listen(const std::string &iface, int port) -> void;
 
@@ -17,11 +19,25 @@ namespace Common {
     /// Publish outgoing data from the send buffer and read incoming data from the receive buffer.
     auto sendAndRecv() noexcept -> void;
 
+    /// Only read incoming data from the receive buffers, for users which send on a different thread.
+    auto recv() noexcept -> void;
+
   private:
     /// Add and remove socket file descriptors to and from the EPOLL list.
     auto addToEpollList(TCPSocket *socket);
 
+    /// Create a TCPSocket for an accepted connection and start receiving on it.
+    auto addConnection(int fd) noexcept -> void;
+
+    /// Close and destroy sockets whose connection has been closed, after calling back disconnect_callback_ for each of them.
+    auto removeDisconnectedSockets() noexcept;
+
   public:
+    const TCPBackend backend_;
+
+    /// Set with the io_uring backends, which accepts and moves the data of all sockets instead of epoll.
+    IoUringTCP *io_uring_ = nullptr;
+
     /// Socket on which this server is listening for new connections on.
     int epoll_fd_ = -1;
     TCPSocket listener_socket_;
@@ -35,6 +51,11 @@ namespace Common {
     std::function<void(TCPSocket *s, Nanos rx_time)> recv_callback_ = nullptr;
     /// Function wrapper to call back when all data across all TCPSockets has been read and dispatched this round.
     std::function<void()> recv_finished_callback_ = nullptr;
+    /// Function wrapper to call back when a connection has been closed, just before the TCPSocket is destroyed.
+    std::function<void(TCPSocket *s)> disconnect_callback_ = nullptr;
+    /// If set, a closed connection's TCPSocket is handed to this instead of being closed and destroyed, which is then up to the callee.
+    /// Lets a thread other than the one polling keep sending on the socket until it learns about the disconnect, not supported with io_uring.
+    std::function<void(TCPSocket *s)> release_callback_ = nullptr;
 
     std::string time_str_;
     Logger &logger_;
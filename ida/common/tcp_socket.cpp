@@ -1,4 +1,5 @@
 #include "tcp_socket.h"
+#include "io_uring_tcp.h"
 
 namespace Common {
   /// Create TCPSocket with provided attributes to either listen-on / connect-to.
@@ -16,43 +17,91 @@ namespace Common {
 
   /// Called to publish outgoing data from the buffers as well as check for and callback if data is available in the read buffers.
   auto TCPSocket::sendAndRecv() noexcept -> bool {
-    char ctrl[CMSG_SPACE(sizeof(struct timeval))];
-    auto cmsg = reinterpret_cast<struct cmsghdr *>(&ctrl);
-
-    iovec iov{inbound_data_.data() + next_rcv_valid_index_, TCPBufferSize - next_rcv_valid_index_};
-    msghdr msg{&socket_attrib_, sizeof(socket_attrib_), &iov, 1, ctrl, sizeof(ctrl), 0};
-
-    // Non-blocking call to read available data.
-    const auto read_size = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
-    if (read_size > 0) {
-      next_rcv_valid_index_ += read_size;
-
-      Nanos kernel_time = 0;
-      timeval time_kernel;
-      if (cmsg->cmsg_level == SOL_SOCKET &&
-          cmsg->cmsg_type == SCM_TIMESTAMP &&
-          cmsg->cmsg_len == CMSG_LEN(sizeof(time_kernel))) {
-        memcpy(&time_kernel, CMSG_DATA(cmsg), sizeof(time_kernel));
-        kernel_time = time_kernel.tv_sec * NANOS_TO_SECS + time_kernel.tv_usec * NANOS_TO_MICROS; // convert timestamp to nanoseconds.
+    // With io_uring the send is queued first so the same io_uring_enter() submits it and reaps the completions.
+    if (io_uring_) {
+      if (next_send_valid_index_ > 0) {
+        const auto n = flush();
+        logger_.log("%:% %() % send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_, n);
       }
-
-      const auto user_time = getCurrentNanos();
-
-      logger_.log("%:% %() % read socket:% len:% utime:% ktime:% diff:%\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), socket_fd_, next_rcv_valid_index_, user_time, kernel_time, (user_time - kernel_time));
-      recv_callback_(this, kernel_time);
+      return recv();
     }
 
+    const auto recv_data = recv();
+
     if (next_send_valid_index_ > 0) {
-      // Non-blocking call to send data.
-      const auto n = ::send(socket_fd_, outbound_data_.data(), next_send_valid_index_, MSG_DONTWAIT | MSG_NOSIGNAL);
+      const auto n = flush();
       logger_.log("%:% %() % send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_, n);
     }
-    next_send_valid_index_ = 0;
+
+    return recv_data;
+  }
+
+  /// Read available data into the receive buffer and callback if there is any.
+  auto TCPSocket::recv() noexcept -> bool {
+    if (io_uring_)
+      return io_uring_->poll();
+
+    // While the receiver is paused new data is left in the kernel socket buffer, which pushes back on the sender once that fills up.
+    ssize_t read_size = 0;
+    if (LIKELY(!recv_paused_)) {
+      char ctrl[CMSG_SPACE(sizeof(struct timeval))];
+      auto cmsg = reinterpret_cast<struct cmsghdr *>(&ctrl);
+
+      iovec iov{inbound_data_.data() + next_rcv_valid_index_, TCPBufferSize - next_rcv_valid_index_};
+      msghdr msg{&socket_attrib_, sizeof(socket_attrib_), &iov, 1, ctrl, sizeof(ctrl), 0};
+
+      // Non-blocking call to read available data.
+      read_size = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
+      if (read_size > 0) {
+        next_rcv_valid_index_ += read_size;
+
+        Nanos kernel_time = 0;
+        timeval time_kernel;
+        if (cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SCM_TIMESTAMP &&
+            cmsg->cmsg_len == CMSG_LEN(sizeof(time_kernel))) {
+          memcpy(&time_kernel, CMSG_DATA(cmsg), sizeof(time_kernel));
+          kernel_time = time_kernel.tv_sec * NANOS_TO_SECS + time_kernel.tv_usec * NANOS_TO_MICROS; // convert timestamp to nanoseconds.
+        }
+
+        const auto user_time = getCurrentNanos();
+
+        logger_.log("%:% %() % read socket:% len:% utime:% ktime:% diff:%\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), socket_fd_, next_rcv_valid_index_, user_time, kernel_time, (user_time - kernel_time));
+        recv_callback_(this, kernel_time);
+      } else if (read_size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        if (!disconnected_) {
+          logger_.log("%:% %() % disconnected socket:% error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket_fd_,
+                      (read_size == 0 ? "closed by peer" : std::strerror(errno)));
+        }
+        disconnected_ = true;
+      }
+    }
 
     return (read_size > 0);
   }
 
+  /// Publish outgoing data from the send buffer, does not log since it can be called from a thread other than the one owning logger_.
+  /// With io_uring returns the number of bytes handed to it, which is 0 while the previous send is still in flight.
+  auto TCPSocket::flush() noexcept -> ssize_t {
+    if (io_uring_) {
+      const auto len = next_send_valid_index_;
+      io_uring_->flush(this);
+      return static_cast<ssize_t>(len - next_send_valid_index_);
+    }
+
+    // Non-blocking call to send data, what the kernel did not take yet is kept at the front of the send buffer for the next flush()
+    // so a large burst is not cut off in the middle of a frame. Data is only dropped if the connection failed.
+    const auto n = ::send(socket_fd_, outbound_data_.data(), next_send_valid_index_, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n >= 0 && static_cast<size_t>(n) < next_send_valid_index_) {
+      memmove(outbound_data_.data(), outbound_data_.data() + n, next_send_valid_index_ - n);
+      next_send_valid_index_ -= n;
+    } else if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+      next_send_valid_index_ = 0;
+    }
+    return n;
+  }
+
   /// Write outgoing data to the send buffers.
   auto TCPSocket::send(const void *data, size_t len) noexcept -> void {
     memcpy(outbound_data_.data() + next_send_valid_index_, data, len);
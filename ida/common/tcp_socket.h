@@ -9,6 +9,27 @@ namespace Common {
   /// Size of our send and receive buffers in bytes.
   constexpr size_t TCPBufferSize = 64 * 1024 * 1024;
 
+  /// Kernel interface moving the data of TCPSockets and TCPServers.
+  enum class TCPBackend : uint8_t {
+    EPOLL = 0,           // epoll for readiness and a recvmsg() / send() system call per socket.
+    IO_URING = 1,        // one io_uring per TCPServer or TCPSocket, see IoUringTCP.
+    IO_URING_SQPOLL = 2  // io_uring with a kernel thread polling the submission queue, which saves the system call to submit.
+  };
+
+  inline std::string tcpBackendToString(TCPBackend backend) {
+    switch (backend) {
+      case TCPBackend::EPOLL:
+        return "EPOLL";
+      case TCPBackend::IO_URING:
+        return "IO_URING";
+      case TCPBackend::IO_URING_SQPOLL:
+        return "IO_URING_SQPOLL";
+    }
+    return "UNKNOWN";
+  }
+
+  class IoUringTCP;
+
   struct TCPSocket {
     explicit TCPSocket(Logger &logger)
         : logger_(logger) {
@@ -22,6 +43,13 @@ namespace Common {
     /// Called to publish outgoing data from the buffers as well as check for and callback if data is available in the read buffers.
     auto sendAndRecv() noexcept -> bool;
 
+    /// The two halves of sendAndRecv(), for users which receive and send on different threads.
+    /// recv() reads available data and calls back, flush() publishes the send buffer and returns the result of the send() system call,
+    /// data the kernel did not take yet stays in the send buffer for the next flush().
+    auto recv() noexcept -> bool;
+
+    auto flush() noexcept -> ssize_t;
+
     /// Write outgoing data to the send buffers.
     auto send(const void *data, size_t len) noexcept -> void;
 
@@ -45,12 +73,22 @@ namespace Common {
     std::vector<char> inbound_data_;
     size_t next_rcv_valid_index_ = 0;
 
+    /// Set once a read finds the connection closed by the peer or broken.
+    bool disconnected_ = false;
+
+    /// Set by a receiver which could not consume all of inbound_data_, no more data is read until it is cleared so it stays in the kernel socket buffer.
+    bool recv_paused_ = false;
+
     /// Socket attributes.
     struct sockaddr_in socket_attrib_{};
 
     /// Function wrapper to callback when there is data to be processed.
     std::function<void(TCPSocket *s, Nanos rx_time)> recv_callback_ = nullptr;
 
+    /// Set once the socket was added to an io_uring backend, which then moves its data instead of the system calls made here.
+    IoUringTCP *io_uring_ = nullptr;
+    unsigned io_uring_slot_ = 0;
+
     std::string time_str_;
     Logger &logger_;
   };
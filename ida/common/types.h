@@ -4,19 +4,23 @@
 #include <limits>
 #include <sstream>
 #include <array>
+#include <vector>
 
 #include "common/macros.h"
 
 namespace Common {
   /// Constants used across the ecosystem to represent upper bounds on various containers.
-  /// Trading instruments / TickerIds from [0, ME_MAX_TICKERS].
-  constexpr size_t ME_MAX_TICKERS = 8;
+  /// Trading instruments are listed at runtime in an InstrumentRegistry, this is the number listed when no instrument file is provided.
+  constexpr size_t ME_DEFAULT_NUM_TICKERS = 8;
 
   /// Maximum size of lock free queues used to transfer client requests, client responses and market updates between components.
   constexpr size_t ME_MAX_CLIENT_UPDATES = 256 * 1024;
   constexpr size_t ME_MAX_MARKET_UPDATES = 256 * 1024;
 
-  /// Maximum trading clients.
+  /// Maximum number of client responses and market updates buffered by the matching engine for a single client request before publishing them.
+  constexpr size_t ME_MAX_BATCH_EVENTS = 1024;
+
+  /// Maximum trading clients, including the ClientId_WARMUP reserved for the matching engine.
   constexpr size_t ME_MAX_NUM_CLIENTS = 256;
 
   /// Maximum number of orders per trading client.
@@ -47,9 +51,23 @@ namespace Common {
     return std::to_string(ticker_id);
   }
 
+  typedef uint16_t ChannelId;
+  constexpr auto ChannelId_INVALID = std::numeric_limits<ChannelId>::max();
+
+  inline auto channelIdToString(ChannelId channel_id) -> std::string {
+    if (UNLIKELY(channel_id == ChannelId_INVALID)) {
+      return "INVALID";
+    }
+
+    return std::to_string(channel_id);
+  }
+
   typedef uint32_t ClientId;
   constexpr auto ClientId_INVALID = std::numeric_limits<ClientId>::max();
 
+  /// Reserved for the matching engine's warmup traffic, the order server never accepts it from a trading client.
+  constexpr ClientId ClientId_WARMUP = ME_MAX_NUM_CLIENTS - 1;
+
   inline auto clientIdToString(ClientId client_id) -> std::string {
     if (UNLIKELY(client_id == ClientId_INVALID)) {
       return "INVALID";
@@ -197,6 +215,6 @@ namespace Common {
     }
   };
 
-  /// Hash map from TickerId -> TradeEngineCfg.
-  typedef std::array<TradeEngineCfg, ME_MAX_TICKERS> TradeEngineCfgHashMap;
+  /// Hash map from TickerId -> TradeEngineCfg, sized to the instruments being traded.
+  typedef std::vector<TradeEngineCfg> TradeEngineCfgHashMap;
 }
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "common/macros.h"
+
+namespace Common {
+  /// Binary wire framing shared by the order entry and market data protocols.
+  /// A frame is a WireFrameHeader followed by num_messages_ messages, each a WireMessageHeader followed by a fixed size block of block_length_ bytes.
+  /// Messages in a frame carry consecutive sequence numbers starting at first_seq_num_, so sequence numbers are sent once per frame.
+  /// Schemas are versioned by only ever appending fields to the end of a block, readers access the fields they know in place and use
+  /// block_length_ to skip the rest, a block shorter than the reader's message was encoded with an older schema version.
+
+  /// These structures go over the wire / network, so the binary structures are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+  struct WireFrameHeader {
+    /// Total length of the frame in bytes, including this header.
+    uint16_t length_ = 0;
+    uint16_t schema_id_ = 0;
+    uint16_t schema_version_ = 0;
+    uint16_t num_messages_ = 0;
+    uint64_t first_seq_num_ = 0;
+  };
+
+  struct WireMessageHeader {
+    uint8_t template_id_ = 0;
+    uint8_t block_length_ = 0;
+  };
+
+  /// Header of every multicast datagram, followed by whole frames only so a lost datagram never leaves a partial frame behind.
+  /// Packet sequence numbers are per stream and independent of the message sequence numbers, a jump means datagrams were lost.
+  struct WirePacketHeader {
+    uint64_t packet_seq_num_ = 0;
+    uint64_t send_time_ = 0;
+    uint16_t num_messages_ = 0;
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  /// Largest frame the 16 bit frame length can describe.
+  constexpr size_t WIRE_MAX_FRAME_SIZE = std::numeric_limits<uint16_t>::max();
+
+  /// Whether a field can be narrowed to its wire type, every value of the wire type is available except the largest which is the INVALID sentinel.
+  template<typename Wire, typename T>
+  constexpr auto fitsWire(T value, T invalid) noexcept {
+    return (value == invalid || (std::in_range<Wire>(value) && std::cmp_less(value, std::numeric_limits<Wire>::max())));
+  }
+
+  /// Narrow a field to its wire type, the INVALID sentinel of the field maps to the largest value of the wire type.
+  /// Values are expected to fit in the wire type, that is what the protocol schemas assume about the domain of each field, one which does not
+  /// would be truncated or decoded as INVALID on the other side so it is fatal.
+  template<typename Wire, typename T>
+  inline auto narrowToWire(T value, T invalid) noexcept -> Wire {
+    if (UNLIKELY(!fitsWire<Wire>(value, invalid)))
+      FATAL("Value:" + std::to_string(value) + " does not fit its wire type.");
+
+    return (UNLIKELY(value == invalid) ? std::numeric_limits<Wire>::max() : static_cast<Wire>(value));
+  }
+
+  /// Widen a field from its wire type, the inverse of narrowToWire().
+  template<typename T, typename Wire>
+  inline auto widenFromWire(Wire value, T invalid) noexcept -> T {
+    return (UNLIKELY(value == std::numeric_limits<Wire>::max()) ? invalid : static_cast<T>(value));
+  }
+
+  /// Encodes messages of one schema directly into the send buffer of a TCPSocket or McastSocket, the caller fills in the returned block in place.
+  /// Consecutive messages are batched into the frame at the end of the send buffer as long as nothing else was written after it,
+  /// their sequence numbers are consecutive and the frame stays within max_frame_size bytes, otherwise a new frame is started.
+  class WireFrameEncoder {
+  public:
+    WireFrameEncoder(uint16_t schema_id, uint16_t schema_version, size_t max_frame_size)
+        : schema_id_(schema_id), schema_version_(schema_version), max_frame_size_(max_frame_size) {
+      ASSERT(max_frame_size_ <= WIRE_MAX_FRAME_SIZE, "Max frame size:" + std::to_string(max_frame_size_) + " does not fit the frame length.");
+    }
+
+    /// Append a message with the specified sequence number to the socket's send buffer and return its block to be filled in.
+    template<typename Message, typename Socket>
+    auto append(Socket *socket, uint64_t seq_num) noexcept -> Message * {
+      constexpr size_t message_size = sizeof(WireMessageHeader) + sizeof(Message);
+      static_assert(sizeof(Message) <= std::numeric_limits<uint8_t>::max(), "Message block does not fit the block length.");
+
+      auto buffer = socket->outbound_data_.data();
+      auto end = buffer + socket->next_send_valid_index_;
+      if (!(frame_buffer_ == buffer && reinterpret_cast<char *>(frame_) + frame_->length_ == end &&
+            frame_->first_seq_num_ + frame_->num_messages_ == seq_num && frame_->length_ + message_size <= max_frame_size_ &&
+            frame_->num_messages_ < std::numeric_limits<uint16_t>::max())) {
+        ASSERT(socket->next_send_valid_index_ + sizeof(WireFrameHeader) + message_size <= socket->outbound_data_.size(),
+               "Socket send buffer filled up and sendAndRecv() not called.");
+        frame_buffer_ = buffer;
+        frame_ = reinterpret_cast<WireFrameHeader *>(end);
+        *frame_ = {sizeof(WireFrameHeader), schema_id_, schema_version_, 0, seq_num};
+        end += sizeof(WireFrameHeader);
+        socket->next_send_valid_index_ += sizeof(WireFrameHeader);
+      } else {
+        ASSERT(socket->next_send_valid_index_ + message_size <= socket->outbound_data_.size(), "Socket send buffer filled up and sendAndRecv() not called.");
+      }
+
+      *reinterpret_cast<WireMessageHeader *>(end) = {Message::TEMPLATE_ID, sizeof(Message)};
+      frame_->length_ += message_size;
+      ++frame_->num_messages_;
+      socket->next_send_valid_index_ += message_size;
+
+      return reinterpret_cast<Message *>(end + sizeof(WireMessageHeader));
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    WireFrameEncoder() = delete;
+
+    WireFrameEncoder(const WireFrameEncoder &) = delete;
+
+    WireFrameEncoder(const WireFrameEncoder &&) = delete;
+
+    WireFrameEncoder &operator=(const WireFrameEncoder &) = delete;
+
+    WireFrameEncoder &operator=(const WireFrameEncoder &&) = delete;
+
+  private:
+    const uint16_t schema_id_;
+    const uint16_t schema_version_;
+    const size_t max_frame_size_;
+
+    /// The last frame started by this encoder and the send buffer it was written to.
+    WireFrameHeader *frame_ = nullptr;
+    const char *frame_buffer_ = nullptr;
+  };
+
+  /// Decode the complete frames at the start of [data, data + len) in order, calling frame_handler(frame) for each of them until it returns false.
+  /// Returns the number of bytes consumed, a trailing partial frame and the frame the handler declined are left for the next call.
+  /// A frame too short to hold its own header means the stream is corrupt, the rest of the data is consumed and dropped.
+  template<typename FrameHandler>
+  inline auto decodeWireFrames(const char *data, size_t len, FrameHandler &&frame_handler) noexcept -> size_t {
+    size_t i = 0;
+    while (i + sizeof(WireFrameHeader) <= len) {
+      auto frame = reinterpret_cast<const WireFrameHeader *>(data + i);
+      if (UNLIKELY(frame->length_ < sizeof(WireFrameHeader)))
+        return len;
+      if (i + frame->length_ > len || !frame_handler(frame))
+        break;
+      i += frame->length_;
+    }
+    return i;
+  }
+
+  /// Call message_handler(seq_num, message_header, block) for every message in a frame of the specified schema, blocks are accessed in place.
+  /// Returns false without calling the handler if the frame belongs to a different schema.
+  template<typename MessageHandler>
+  inline auto forEachWireMessage(const WireFrameHeader *frame, uint16_t schema_id, MessageHandler &&message_handler) noexcept {
+    if (UNLIKELY(frame->schema_id_ != schema_id))
+      return false;
+
+    auto data = reinterpret_cast<const char *>(frame) + sizeof(WireFrameHeader);
+    const auto end = reinterpret_cast<const char *>(frame) + frame->length_;
+    auto seq_num = frame->first_seq_num_;
+    for (uint16_t i = 0; i < frame->num_messages_ && data + sizeof(WireMessageHeader) <= end; ++i, ++seq_num) {
+      auto message_header = reinterpret_cast<const WireMessageHeader *>(data);
+      data += sizeof(WireMessageHeader);
+      if (UNLIKELY(data + message_header->block_length_ > end))
+        break;
+
+      message_handler(seq_num, message_header, data);
+      data += message_header->block_length_;
+    }
+    return true;
+  }
+
+  /// Access the block of a message in place as the specified message type, nullptr if it is a different template or the block is too short.
+  template<typename Message>
+  inline auto wireMessage(const WireMessageHeader *message_header, const char *block) noexcept -> const Message * {
+    return ((message_header->template_id_ == Message::TEMPLATE_ID && message_header->block_length_ >= sizeof(Message)) ?
+            reinterpret_cast<const Message *>(block) : nullptr);
+  }
+}
@@ -9,6 +9,28 @@ Common::Logger *logger = nullptr;
 Exchange::MatchingEngine *matching_engine = nullptr;
 Exchange::MarketDataPublisher *market_data_publisher = nullptr;
 Exchange::OrderServer *order_server = nullptr;
+Exchange::MEJournal *journal = nullptr;
+Exchange::MECheckpointWriter *checkpoint_writer = nullptr;
+
+/// Instruments listed on the exchange, TickerIds are assigned in the order of this file.
+const std::string instruments_file = "/home/praveen/omlaxmiquant/ida/config/Instruments.txt";
+
+/// Number of synthetic add / match / modify / cancel rounds run through each order book before the exchange opens.
+const size_t warmup_iterations = 1000;
+
+/// Files used to recover the state of the exchange on restart.
+const std::string journal_file = "/home/praveen/omlaxmiquant/ida/logs/exchange_journal.dat";
+const std::string checkpoint_file = "/home/praveen/omlaxmiquant/ida/logs/exchange_checkpoint.dat";
+
+/// Capacity of the journal in client requests, its file is preallocated on disk for this many but only a window ahead of the last one is kept in
+/// memory. An existing journal has to be reopened with the capacity it was created with.
+const size_t journal_max_records = Exchange::ME_MAX_JOURNAL_RECORDS;
+
+/// Time between checkpoints, 0 to not take any so a restart replays the whole journal.
+/// A checkpoint copies every resting order on the matching engine thread between two client requests, nothing is matched meanwhile -
+/// checkpoint_benchmark measures 0.3 to 0.7 us per resting order, i.e. around half a second for a million. Only worth it when restarts
+/// have to be faster than replaying the journal and the stall can be taken, e.g. while the market is quiet.
+const Common::Nanos checkpoint_interval = 0;
 
 /// Shut down gracefully on external signals to this server.
 void signal_handler(int) {
@@ -19,10 +41,14 @@ void signal_handler(int) {
   logger = nullptr;
   delete matching_engine;
   matching_engine = nullptr;
+  delete checkpoint_writer; // after the matching engine, which captures checkpoints for it.
+  checkpoint_writer = nullptr;
   delete market_data_publisher;
   market_data_publisher = nullptr;
   delete order_server;
   order_server = nullptr;
+  delete journal; // after the order server, which appends to it.
+  journal = nullptr;
 
   std::this_thread::sleep_for(10s);
 
@@ -40,30 +66,132 @@ int main(int, char **) {
   Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
   Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
   Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  Exchange::MEPriceLevelUpdateLFQueue price_level_updates(ME_MAX_MARKET_UPDATES);
 
   std::string time_str;
 
-  logger->log("%:% %() % Starting Matching Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates);
-  matching_engine->start();
+  // The listing has to be the same across restarts, the checkpoint and journal refer to instruments by TickerId.
+  Common::InstrumentRegistry instruments;
+  if (!Common::loadInstruments(instruments_file, &instruments)) {
+    logger->log("%:% %() % No instrument file:% listing % default instruments.\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str), instruments_file, Common::ME_DEFAULT_NUM_TICKERS);
+    Common::listDefaultInstruments(&instruments);
+  }
+  logger->log("%:% %() % Listed % instruments.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), instruments.size());
+
+  // Opened before recovery so a checkpoint is only written once the journal has synced the client requests it covers.
+  journal = new Exchange::MEJournal(journal_file, journal_max_records, Exchange::JournalSyncPolicy::ASYNC);
+
+  if (checkpoint_interval) {
+    checkpoint_writer = new Exchange::MECheckpointWriter(checkpoint_file, journal);
+    checkpoint_writer->start();
+  }
+  matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, &price_level_updates, &instruments, checkpoint_writer);
+
+  // Trade summaries let consumers that only act on trades handle a sweep as a single update.
+  matching_engine->setPublishTradeSummaries(true);
+
+  // Run the matching paths against a shadow client before recovery, so the first client request does not pay for cold caches and page faults.
+  matching_engine->warmup(warmup_iterations);
+
+  // Recover the order books from the last checkpoint, if any, and then the client requests journaled after that checkpoint was taken.
+  {
+    const auto start = Common::getCurrentNanos();
+    Exchange::MECheckpoint checkpoint;
+    if (Exchange::readCheckpoint(checkpoint_file, &checkpoint)) {
+      matching_engine->restore(checkpoint);
+    }
+
+    size_t num_replayed = 0;
+    {
+      const Exchange::MEJournalReader journal_reader(journal_file);
+      for (auto i = matching_engine->getNumRequests(); i < journal_reader.size(); ++i, ++num_replayed) {
+        matching_engine->replayClientRequest(&journal_reader.at(i).request_);
+      }
+    }
+
+    // The journal header can be behind the checkpoint if its last records were never synced, e.g. a machine crash with the ASYNC policy.
+    // The checkpoint alone has the state, new records continue after the ones it covers so a later restart replays the right ones.
+    if (matching_engine->getNumRequests() > journal->getNumSynced()) {
+      logger->log("%:% %() % Checkpoint requests:% ahead of journal records:%, recovering from the checkpoint alone.\n", __FILE__, __LINE__,
+                  __FUNCTION__, Common::getCurrentTimeStr(&time_str), matching_engine->getNumRequests(), journal->getNumSynced());
+      journal->resumeAt(matching_engine->getNumRequests());
+    }
+
+    logger->log("%:% %() % Recovered checkpoint orders:% replayed journal records:% in % nanos\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str), checkpoint.orders_.size(), num_replayed, Common::getCurrentNanos() - start);
+  }
 
   const std::string mkt_pub_iface = "lo";
-  const std::string snap_pub_ip = "233.252.14.1", inc_pub_ip = "233.252.14.3";
-  const int snap_pub_port = 20000, inc_pub_port = 20001;
+  // Incremental and snapshot streams of each market data channel indexed by ChannelId, the instrument file assigns every instrument to one of them.
+  const Exchange::MarketDataChannels mkt_pub_channels = {{"233.252.14.3", 20001, "233.252.14.1", 20000},
+                                                         {"233.252.15.3", 20011, "233.252.15.1", 20010}};
+  const std::string mbp_pub_ip = "233.252.14.5";
+  const int mbp_pub_port = 20002;
+  // Full depth level snapshot of every instrument's market by price levels, published every interval to build or recover that stream from.
+  const std::string mbp_snap_pub_ip = "233.252.14.6";
+  const int mbp_snap_pub_port = 20006;
+  const Common::Nanos mbp_snap_pub_interval = 1 * Common::NANOS_TO_SECS;
+  // Conflated stream of the top price levels of each instrument, a changed book is published at most once per interval and an unchanged one every refresh.
+  const std::string conflated_pub_ip = "233.252.14.7";
+  const int conflated_pub_port = 20005;
+  const Common::Nanos conflated_pub_interval = 100 * Common::NANOS_TO_MILLIS;
+  const Common::Nanos conflated_pub_refresh_interval = 1 * Common::NANOS_TO_SECS;
+  // Pack market updates into datagrams which fit the Ethernet MTU, a partially filled one is sent after waiting this long for more updates.
+  const size_t mkt_pub_max_packet_size = Common::MCAST_MTU_PACKET_SIZE;
+  const Common::Nanos mkt_pub_max_packet_delay = 0;
+  // Publish a snapshot cycle every interval, paced to this many bytes per second so it does not burst the network (0 publishes it all at once).
+  const Common::Nanos snap_pub_interval = 60 * Common::NANOS_TO_SECS;
+  const size_t snap_pub_bytes_per_sec = 10 * 1024 * 1024;
+  // TCP snapshot service for consumers which need a book without waiting for the next snapshot cycle, e.g. when starting mid-session.
+  const int snapshot_service_port = 20004;
+  // TCP replay service for consumers recovering from a gap on the incremental stream, serving the most recent replay_ring_size updates.
+  const int replay_port = 20003;
+  const size_t replay_ring_size = 1024 * 1024;
 
   logger->log("%:% %() % Starting Market Data Publisher...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  market_data_publisher = new Exchange::MarketDataPublisher(&market_updates, mkt_pub_iface, snap_pub_ip, snap_pub_port, inc_pub_ip, inc_pub_port);
+  market_data_publisher = new Exchange::MarketDataPublisher(&market_updates, &price_level_updates, &instruments, mkt_pub_iface, mkt_pub_channels,
+                                                            mbp_pub_ip, mbp_pub_port, mbp_snap_pub_ip, mbp_snap_pub_port, mbp_snap_pub_interval,
+                                                            conflated_pub_ip, conflated_pub_port, conflated_pub_interval, conflated_pub_refresh_interval,
+                                                            mkt_pub_max_packet_size, mkt_pub_max_packet_delay, snap_pub_interval, snap_pub_bytes_per_sec,
+                                                            snapshot_service_port, replay_port, replay_ring_size);
   market_data_publisher->start();
 
+  // Announce the recovered orders before any new client request is matched, the market data streams start empty after a restart.
+  matching_engine->publishBooks();
+
+  logger->log("%:% %() % Starting Matching Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
+  matching_engine->start();
+
   const std::string order_gw_iface = "lo";
   const int order_gw_port = 12345;
+  const size_t max_pending_requests = Exchange::ME_MAX_PENDING_REQUESTS;
+  // Receive client requests and send client responses on separate threads, each pinned to its own core (-1 leaves a thread unpinned).
+  const bool order_server_split_rx_tx = false;
+  const int order_server_rx_core_id = -1, order_server_tx_core_id = -1;
+  // Kernel interface for the client connections, the io_uring backends need order_server_split_rx_tx = false.
+  const auto order_server_tcp_backend = Common::TCPBackend::EPOLL;
+
+  logger->log("%:% %() % Starting Journal...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
+  journal->start();
 
   logger->log("%:% %() % Starting Order Server...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  order_server = new Exchange::OrderServer(&client_requests, &client_responses, order_gw_iface, order_gw_port);
+  order_server = new Exchange::OrderServer(&client_requests, &client_responses, journal, max_pending_requests, order_server_split_rx_tx,
+                                           order_server_rx_core_id, order_server_tx_core_id, order_server_tcp_backend, order_gw_iface, order_gw_port);
+  for (Common::ClientId client_id = 0; client_id < ME_MAX_NUM_CLIENTS; ++client_id) {
+    order_server->restoreSequenceNumbers(client_id, matching_engine->getNumClientRequests(client_id), matching_engine->getNumClientResponses(client_id));
+  }
   order_server->start();
 
+  auto last_checkpoint_time = Common::getCurrentNanos();
   while (true) {
     logger->log("%:% %() % Sleeping for a few milliseconds..\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
     usleep(sleep_time * 1000);
+
+    // Periodically checkpoint so a restart only has to replay the journal records since then.
+    if (checkpoint_interval && Common::getCurrentNanos() - last_checkpoint_time >= checkpoint_interval) {
+      last_checkpoint_time = Common::getCurrentNanos();
+      matching_engine->requestCheckpoint();
+    }
   }
 }
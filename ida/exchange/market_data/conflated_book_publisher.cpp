@@ -0,0 +1,162 @@
+#include "conflated_book_publisher.h"
+
+namespace Exchange {
+  ConflatedBookPublisher::ConflatedBookPublisher(MDPPriceLevelUpdateLFQueue *price_level_updates, const InstrumentRegistry *instruments,
+                                                 const std::string &iface, const std::string &conflated_ip, int conflated_port, size_t max_packet_size,
+                                                 Nanos publish_interval, Nanos refresh_interval,
+                                                 const std::string &mbp_snapshot_ip, int mbp_snapshot_port, Nanos mbp_snapshot_interval)
+      : conflated_price_level_updates_(price_level_updates), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_conflated_book_publisher.log"),
+        conflated_socket_(logger_), conflated_encoder_(MARKET_DATA_SCHEMA_ID, MARKET_DATA_SCHEMA_VERSION, mcastMaxFrameSize(max_packet_size)),
+        ticker_books_(instruments->size()), publish_interval_(publish_interval), refresh_interval_(refresh_interval),
+        mbp_snapshot_socket_(logger_), mbp_snapshot_encoder_(MARKET_DATA_SCHEMA_ID, MARKET_DATA_SCHEMA_VERSION, mcastMaxFrameSize(max_packet_size)),
+        mbp_snapshot_interval_(mbp_snapshot_interval) {
+    ASSERT(conflated_socket_.init(conflated_ip, iface, conflated_port, /*is_listening*/ false) >= 0,
+           "Unable to create conflated mcast socket. error:" + std::string(std::strerror(errno)));
+    conflated_socket_.setPacketization(max_packet_size, 0);
+
+    ASSERT(mbp_snapshot_socket_.init(mbp_snapshot_ip, iface, mbp_snapshot_port, /*is_listening*/ false) >= 0,
+           "Unable to create market by price snapshot mcast socket. error:" + std::string(std::strerror(errno)));
+    mbp_snapshot_socket_.setPacketization(max_packet_size, 0);
+  }
+
+  ConflatedBookPublisher::~ConflatedBookPublisher() {
+    stop();
+  }
+
+  /// Start and stop the conflated book publisher thread.
+  auto ConflatedBookPublisher::start() -> void {
+    run_ = true;
+    ASSERT(Common::createAndStartThread(-1, "Exchange/ConflatedBookPublisher", [this]() { run(); }) != nullptr,
+           "Failed to start ConflatedBookPublisher thread.");
+  }
+
+  auto ConflatedBookPublisher::stop() -> void {
+    run_ = false;
+  }
+
+  /// Apply a price level update to the side's levels, worse(a, b) is true if price a is worse than price b on that side.
+  /// Returns true if it changed one of the top MD_CONFLATED_BOOK_DEPTH levels, counted from the back where the best level is.
+  template<typename Worse>
+  auto ConflatedBookPublisher::updateLevels(std::vector<BookLevel> *levels, const MEPriceLevelUpdate &price_level_update, Worse worse) noexcept -> bool {
+    const auto itr = std::lower_bound(levels->begin(), levels->end(), price_level_update.price_,
+                                      [&worse](const BookLevel &level, Price price) { return worse(level.price_, price); });
+    const auto num_better = static_cast<size_t>(levels->end() - itr);
+
+    if (itr != levels->end() && itr->price_ == price_level_update.price_) {
+      if (price_level_update.num_orders_ == 0)
+        levels->erase(itr);
+      else
+        *itr = {price_level_update.price_, price_level_update.qty_, price_level_update.num_orders_};
+      return (num_better - 1 < MD_CONFLATED_BOOK_DEPTH);
+    }
+
+    if (UNLIKELY(price_level_update.num_orders_ == 0)) // a price level removed before this thread saw it.
+      return false;
+
+    levels->insert(itr, {price_level_update.price_, price_level_update.qty_, price_level_update.num_orders_});
+    return (num_better < MD_CONFLATED_BOOK_DEPTH);
+  }
+
+  /// Copy the top MD_CONFLATED_BOOK_DEPTH levels of a side, best first, and return how many there are.
+  auto ConflatedBookPublisher::encodeLevels(const std::vector<BookLevel> &levels, WireBookLevel *wire_levels) noexcept -> uint8_t {
+    const auto num_levels = std::min(levels.size(), MD_CONFLATED_BOOK_DEPTH);
+    for (size_t i = 0; i < MD_CONFLATED_BOOK_DEPTH; ++i) {
+      if (i < num_levels) {
+        const auto &level = levels.at(levels.size() - 1 - i);
+        wire_levels[i] = {narrowToWire<WireMDPrice>(level.price_, Price_INVALID), level.qty_, level.num_orders_};
+      } else {
+        wire_levels[i] = {};
+      }
+    }
+    return static_cast<uint8_t>(num_levels);
+  }
+
+  /// Publish the book of every ticker which changed since it was last published, or was not published for refresh_interval_.
+  /// The books go out in as few packets as fit them, the last one flushed once they are all encoded.
+  auto ConflatedBookPublisher::publishBooks() noexcept -> void {
+    const auto now = getCurrentNanos();
+    size_t num_books = 0;
+    for (size_t ticker_id = 0; ticker_id < ticker_books_.size(); ++ticker_id) {
+      auto &book = ticker_books_.at(ticker_id);
+      if (!book.changed_ && now - book.last_publish_time_ < refresh_interval_)
+        continue;
+
+      auto wire_book = conflated_encoder_.append<WireConflatedBook>(&conflated_socket_, next_conflated_seq_num_++);
+      wire_book->ticker_id_ = narrowToWire<WireMDTickerId>(static_cast<TickerId>(ticker_id), TickerId_INVALID);
+      wire_book->num_bids_ = encodeLevels(book.bids_, wire_book->bids_);
+      wire_book->num_asks_ = encodeLevels(book.asks_, wire_book->asks_);
+      conflated_socket_.sendFullPackets();
+
+      book.changed_ = false;
+      book.last_publish_time_ = now;
+      ++num_books;
+    }
+
+    if (num_books) {
+      conflated_socket_.sendAndRecv();
+      logger_.log("%:% %() % Published % books up to seq:%\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), num_books,
+                  next_conflated_seq_num_ - 1);
+    }
+  }
+
+  /// Publish the level snapshot of every ticker on the market by price snapshot stream, a WireLevelSnapshot followed by each level best first.
+  /// All of them are consistent with last_mbp_seq_num_, only the totals are logged and not each level.
+  auto ConflatedBookPublisher::publishLevelSnapshots() noexcept -> void {
+    size_t num_levels = 0;
+    for (size_t ticker_id = 0; ticker_id < ticker_books_.size(); ++ticker_id) {
+      const auto &book = ticker_books_.at(ticker_id);
+      const auto wire_ticker_id = narrowToWire<WireMDTickerId>(static_cast<TickerId>(ticker_id), TickerId_INVALID);
+      *mbp_snapshot_encoder_.append<WireLevelSnapshot>(&mbp_snapshot_socket_, next_mbp_snapshot_seq_num_++) =
+          {wire_ticker_id, last_mbp_seq_num_, static_cast<uint32_t>(book.bids_.size() + book.asks_.size())};
+
+      auto encode_levels = [&](const std::vector<BookLevel> &levels, Side side, bool last_side) {
+        for (auto itr = levels.rbegin(); itr != levels.rend(); ++itr) {
+          const auto last_in_batch = (last_side && itr + 1 == levels.rend());
+          mbp_snapshot_encoder_.append<WirePriceLevelUpdate>(&mbp_snapshot_socket_, next_mbp_snapshot_seq_num_++)->encode(
+              {static_cast<TickerId>(ticker_id), side, itr->price_, itr->qty_, itr->num_orders_, last_in_batch});
+          mbp_snapshot_socket_.sendFullPackets();
+        }
+      };
+      encode_levels(book.bids_, Side::BUY, book.asks_.empty());
+      encode_levels(book.asks_, Side::SELL, true);
+      mbp_snapshot_socket_.sendFullPackets();
+
+      num_levels += book.bids_.size() + book.asks_.size();
+    }
+
+    mbp_snapshot_socket_.sendAndRecv();
+    logger_.log("%:% %() % Published level snapshots of % books with % levels at mbp seq:% up to seq:%\n", __FILE__, __LINE__, __FUNCTION__,
+                getCurrentTimeStr(&time_str_), ticker_books_.size(), num_levels, last_mbp_seq_num_, next_mbp_snapshot_seq_num_ - 1);
+  }
+
+  /// Main run loop for this thread - applies the price level updates forwarded by the market data publisher, publishes the changed books and the
+  /// level snapshots periodically.
+  /// Updates to a book between two publications are conflated into the one published, only its latest levels go out.
+  auto ConflatedBookPublisher::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_));
+    while (run_) {
+      for (auto mdp_price_level_update = conflated_price_level_updates_->getNextToRead(); mdp_price_level_update;
+           mdp_price_level_update = conflated_price_level_updates_->getNextToRead()) {
+        const auto &price_level_update = mdp_price_level_update->me_price_level_update_;
+        auto &book = ticker_books_.at(price_level_update.ticker_id_);
+        const auto changed = (price_level_update.side_ == Side::BUY ?
+                              updateLevels(&book.bids_, price_level_update, [](Price price, Price other) { return price < other; }) :
+                              updateLevels(&book.asks_, price_level_update, [](Price price, Price other) { return price > other; }));
+        book.changed_ = (book.changed_ || changed);
+        last_mbp_seq_num_ = mdp_price_level_update->seq_num_;
+
+        conflated_price_level_updates_->updateReadIndex();
+      }
+
+      if (getCurrentNanos() - last_publish_time_ >= publish_interval_) {
+        last_publish_time_ = getCurrentNanos();
+        publishBooks();
+      }
+
+      if (getCurrentNanos() - last_mbp_snapshot_time_ >= mbp_snapshot_interval_) {
+        last_mbp_snapshot_time_ = getCurrentNanos();
+        publishLevelSnapshots();
+      }
+    }
+  }
+}
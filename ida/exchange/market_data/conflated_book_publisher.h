@@ -0,0 +1,120 @@
+#pragma once
+
+#include "common/types.h"
+#include "common/thread_utils.h"
+#include "common/lf_queue.h"
+#include "common/macros.h"
+#include "common/mcast_socket.h"
+#include "common/logging.h"
+#include "common/instrument_registry.h"
+
+#include "market_data/market_update.h"
+#include "market_data/market_data_protocol.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Publishes the top MD_CONFLATED_BOOK_DEPTH price levels of every instrument on the conflated multicast stream, for consumers which only need
+  /// the top of the book and should not have to keep up with every order to get it.
+  /// The price level updates forwarded by the market data publisher are applied as they arrive, but a ticker's book is only published once per
+  /// publish_interval, with its latest levels and only if they changed, so the stream's rate is bounded by the number of instruments and not the activity.
+  /// Unchanged books are republished every refresh_interval so consumers which joined late or lost a packet catch up.
+  /// Since it keeps every price level, it also publishes a full depth snapshot of every book on the market by price snapshot stream each
+  /// mbp_snapshot_interval, consistent with the market by price sequence number of the last update applied, to build or recover that stream from.
+  class ConflatedBookPublisher {
+  public:
+    ConflatedBookPublisher(MDPPriceLevelUpdateLFQueue *price_level_updates, const InstrumentRegistry *instruments, const std::string &iface,
+                           const std::string &conflated_ip, int conflated_port, size_t max_packet_size, Nanos publish_interval, Nanos refresh_interval,
+                           const std::string &mbp_snapshot_ip, int mbp_snapshot_port, Nanos mbp_snapshot_interval);
+
+    ~ConflatedBookPublisher();
+
+    /// Start and stop the conflated book publisher thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Main run loop for this thread - applies the price level updates forwarded by the market data publisher, publishes the changed books and the
+    /// level snapshots periodically.
+    auto run() noexcept -> void;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    ConflatedBookPublisher() = delete;
+
+    ConflatedBookPublisher(const ConflatedBookPublisher &) = delete;
+
+    ConflatedBookPublisher(const ConflatedBookPublisher &&) = delete;
+
+    ConflatedBookPublisher &operator=(const ConflatedBookPublisher &) = delete;
+
+    ConflatedBookPublisher &operator=(const ConflatedBookPublisher &&) = delete;
+
+  private:
+    /// Totals of one price level.
+    struct BookLevel {
+      Price price_ = Price_INVALID;
+      Qty qty_ = 0;
+      uint32_t num_orders_ = 0;
+    };
+
+    /// Every price level of one instrument, each side densely stored and sorted worst price first, so the best levels which change the most are at the back.
+    /// changed_ is set when one of the top MD_CONFLATED_BOOK_DEPTH levels of either side changed since the book was last published.
+    struct ConflatedBook {
+      std::vector<BookLevel> bids_, asks_;
+      bool changed_ = false;
+      Nanos last_publish_time_ = 0;
+    };
+
+    /// Apply a price level update to the side's levels, worse(a, b) is true if price a is worse than price b on that side.
+    /// Returns true if it changed one of the top MD_CONFLATED_BOOK_DEPTH levels.
+    template<typename Worse>
+    static auto updateLevels(std::vector<BookLevel> *levels, const MEPriceLevelUpdate &price_level_update, Worse worse) noexcept -> bool;
+
+    /// Copy the top MD_CONFLATED_BOOK_DEPTH levels of a side, best first, and return how many there are.
+    static auto encodeLevels(const std::vector<BookLevel> &levels, WireBookLevel *wire_levels) noexcept -> uint8_t;
+
+    /// Publish the book of every ticker which changed since it was last published, or was not published for refresh_interval_.
+    auto publishBooks() noexcept -> void;
+
+    /// Publish the level snapshot of every ticker on the market by price snapshot stream.
+    auto publishLevelSnapshots() noexcept -> void;
+
+    /// Lock free queue on which the market data publisher forwards every price level update from the matching engine with its market by price sequence number.
+    MDPPriceLevelUpdateLFQueue *conflated_price_level_updates_ = nullptr;
+
+    Logger logger_;
+
+    volatile bool run_ = false;
+
+    std::string time_str_;
+
+    /// Multicast socket for the conflated stream.
+    McastSocket conflated_socket_;
+
+    /// Encodes the books into market data protocol frames, the books published together share frames and packets of up to max_packet_size bytes.
+    WireFrameEncoder conflated_encoder_;
+
+    /// Sequence number tracker on the conflated stream.
+    size_t next_conflated_seq_num_ = 1;
+
+    /// Book of each listed instrument, indexed by TickerId.
+    std::vector<ConflatedBook> ticker_books_;
+
+    /// Minimum time between two publications of the same book and maximum time an unchanged book goes without being published.
+    const Nanos publish_interval_;
+    const Nanos refresh_interval_;
+    Nanos last_publish_time_ = 0;
+
+    /// Multicast socket and encoder for the market by price snapshot stream, and its sequence number tracker.
+    McastSocket mbp_snapshot_socket_;
+    WireFrameEncoder mbp_snapshot_encoder_;
+    size_t next_mbp_snapshot_seq_num_ = 1;
+
+    /// Market by price sequence number of the last price level update applied to the books.
+    size_t last_mbp_seq_num_ = 0;
+
+    /// Time between two level snapshots of every book.
+    const Nanos mbp_snapshot_interval_;
+    Nanos last_mbp_snapshot_time_ = 0;
+  };
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/types.h"
+
+namespace Exchange {
+  /// Multicast groups of one market data channel. Each channel carries the incremental and snapshot streams of the instruments assigned to it
+  /// in the InstrumentRegistry, with sequence numbers of its own, so a consumer only receives the channels of the instruments it needs
+  /// and a gap on one channel only has the instruments of that channel recovered.
+  struct MarketDataChannel {
+    std::string incremental_ip_;
+    int incremental_port_ = 0;
+    std::string snapshot_ip_;
+    int snapshot_port_ = 0;
+  };
+
+  /// Market data channels indexed by ChannelId.
+  typedef std::vector<MarketDataChannel> MarketDataChannels;
+}
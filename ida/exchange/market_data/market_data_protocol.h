@@ -0,0 +1,343 @@
+#pragma once
+
+#include "common/wire_protocol.h"
+
+#include "exchange/market_data/market_update.h"
+
+namespace Exchange {
+  /// Market data protocol published over multicast on the incremental, snapshot, market by price and conflated streams.
+  /// Market updates are framed with the Common wire framing, the frame sequence numbers are those of the stream the frame is published on,
+  /// every market data channel has incremental and snapshot streams with sequence numbers of their own.
+  /// The replay and snapshot services speak the same protocol over TCP, replayed updates keep their incremental sequence numbers, the updates of a
+  /// snapshot image are numbered from 0 like a snapshot cycle and the session messages are sent in frames of their own with sequence number 0.
+  /// Version 2 added the replay session messages, version 3 the snapshot session messages, version 4 the conflated book,
+  /// version 5 the channel of the session messages, version 6 the market by price level snapshot, version 7 the aggressor side best price
+  /// of the trade summary and version 8 the REJECTED replay status.
+  constexpr uint16_t MARKET_DATA_SCHEMA_ID = 2;
+  constexpr uint16_t MARKET_DATA_SCHEMA_VERSION = 8;
+
+  /// Sequence number of the frames carrying replay and snapshot session messages.
+  constexpr uint64_t MD_SESSION_SEQ_NUM = 0;
+
+  /// Outcome of a replay request.
+  enum class ReplayStatus : uint8_t {
+    INVALID = 0,
+    OK = 1,         // the updates first_seq_num_ to last_seq_num_ were sent ahead of the response, possibly fewer than asked for.
+    UNAVAILABLE = 2, // none of the updates asked for are kept anymore or published yet, or the channel is not listed,
+                     // first_seq_num_ to last_seq_num_ is what is kept.
+    REJECTED = 3     // last_seq_num_ of the request is before its first_seq_num_, or not a single update fits in the send buffer, nothing was sent.
+                     // first_seq_num_ to last_seq_num_ is what is kept.
+  };
+
+  inline std::string replayStatusToString(ReplayStatus status) {
+    switch (status) {
+      case ReplayStatus::OK:
+        return "OK";
+      case ReplayStatus::UNAVAILABLE:
+        return "UNAVAILABLE";
+      case ReplayStatus::REJECTED:
+        return "REJECTED";
+      case ReplayStatus::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Outcome of a snapshot request.
+  enum class SnapshotStatus : uint8_t {
+    INVALID = 0,
+    OK = 1,             // the image of the tickers asked for was sent ahead of the response, consistent with incremental sequence number last_inc_seq_num_.
+    UNKNOWN_TICKER = 2, // the channel asked for is not listed, or the ticker asked for is not listed on it.
+    UNAVAILABLE = 3     // the image does not fit in what the connection has left to send, the consumer is not reading what it asked for.
+  };
+
+  inline std::string snapshotStatusToString(SnapshotStatus status) {
+    switch (status) {
+      case SnapshotStatus::OK:
+        return "OK";
+      case SnapshotStatus::UNKNOWN_TICKER:
+        return "UNKNOWN_TICKER";
+      case SnapshotStatus::UNAVAILABLE:
+        return "UNAVAILABLE";
+      case SnapshotStatus::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Number of price levels on each side of a conflated book.
+  constexpr size_t MD_CONFLATED_BOOK_DEPTH = 5;
+
+  /// Fields are narrowed where the domain allows - TickerIds index the InstrumentRegistry, prices are in ticks and priorities
+  /// count the orders added to a price level while it exists.
+  typedef uint16_t WireMDTickerId;
+  typedef int32_t WireMDPrice;
+  typedef uint32_t WireMDPriority;
+
+#pragma pack(push, 1)
+
+  /// Wire block of an order level market update, every type except TRADE_SUMMARY.
+  struct WireMarketUpdate {
+    static constexpr uint8_t TEMPLATE_ID = 1;
+
+    MarketUpdateType type_;
+    Side side_;
+    bool last_in_batch_;
+    WireMDTickerId ticker_id_;
+    OrderId order_id_;
+    WireMDPrice price_;
+    Qty qty_;
+    WireMDPriority priority_;
+
+    auto encode(const MEMarketUpdate &market_update) noexcept {
+      type_ = market_update.type_;
+      side_ = market_update.side_;
+      last_in_batch_ = market_update.last_in_batch_;
+      ticker_id_ = narrowToWire<WireMDTickerId>(market_update.ticker_id_, TickerId_INVALID);
+      order_id_ = market_update.order_id_;
+      price_ = narrowToWire<WireMDPrice>(market_update.price_, Price_INVALID);
+      qty_ = market_update.qty_;
+      priority_ = narrowToWire<WireMDPriority>(market_update.priority_, Priority_INVALID);
+    }
+
+    auto decode() const noexcept {
+      return MEMarketUpdate{type_, order_id_, widenFromWire(ticker_id_, TickerId_INVALID), side_, widenFromWire(price_, Price_INVALID), qty_,
+                            widenFromWire(priority_, Priority_INVALID), last_in_batch_};
+    }
+  };
+
+  /// Wire block of a TRADE_SUMMARY.
+  struct WireTradeSummary {
+    static constexpr uint8_t TEMPLATE_ID = 2;
+
+    Side aggressor_side_;
+    bool last_in_batch_;
+    WireMDTickerId ticker_id_;
+    WireMDPrice best_passive_price_;
+    Qty qty_;
+    uint64_t notional_;
+    uint16_t num_levels_;
+    WireMDPrice best_aggressor_price_;
+
+    auto encode(const MEMarketUpdate &trade_summary) noexcept {
+      aggressor_side_ = trade_summary.side_;
+      last_in_batch_ = trade_summary.last_in_batch_;
+      ticker_id_ = narrowToWire<WireMDTickerId>(trade_summary.ticker_id_, TickerId_INVALID);
+      best_passive_price_ = narrowToWire<WireMDPrice>(trade_summary.price_, Price_INVALID);
+      qty_ = trade_summary.qty_;
+      notional_ = trade_summary.notional_;
+      num_levels_ = static_cast<uint16_t>(std::min<uint64_t>(trade_summary.num_levels_, std::numeric_limits<uint16_t>::max())); // saturates.
+      best_aggressor_price_ = narrowToWire<WireMDPrice>(trade_summary.aggressor_best_price_, Price_INVALID);
+    }
+
+    auto decode() const noexcept {
+      return MEMarketUpdate{MarketUpdateType::TRADE_SUMMARY, num_levels_, widenFromWire(ticker_id_, TickerId_INVALID), aggressor_side_,
+                            widenFromWire(best_passive_price_, Price_INVALID), qty_, notional_, last_in_batch_,
+                            widenFromWire(best_aggressor_price_, Price_INVALID)};
+    }
+  };
+
+  /// Wire block of a price level update on the market by price stream.
+  struct WirePriceLevelUpdate {
+    static constexpr uint8_t TEMPLATE_ID = 3;
+
+    Side side_;
+    bool last_in_batch_;
+    WireMDTickerId ticker_id_;
+    WireMDPrice price_;
+    Qty qty_;
+    uint32_t num_orders_;
+
+    auto encode(const MEPriceLevelUpdate &price_level_update) noexcept {
+      side_ = price_level_update.side_;
+      last_in_batch_ = price_level_update.last_in_batch_;
+      ticker_id_ = narrowToWire<WireMDTickerId>(price_level_update.ticker_id_, TickerId_INVALID);
+      price_ = narrowToWire<WireMDPrice>(price_level_update.price_, Price_INVALID);
+      qty_ = price_level_update.qty_;
+      num_orders_ = price_level_update.num_orders_;
+    }
+
+    auto decode() const noexcept {
+      return MEPriceLevelUpdate{widenFromWire(ticker_id_, TickerId_INVALID), side_, widenFromWire(price_, Price_INVALID), qty_, num_orders_, last_in_batch_};
+    }
+  };
+
+  /// Replay session message sent by a consumer which detected a gap on a channel's incremental stream, asks for the updates first_seq_num_ to last_seq_num_.
+  struct WireReplayRequest {
+    static constexpr uint8_t TEMPLATE_ID = 4;
+
+    ChannelId channel_id_;
+    uint64_t first_seq_num_;
+    uint64_t last_seq_num_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireReplayRequest"
+         << " ["
+         << "channel:" << channelIdToString(channel_id_)
+         << " first:" << first_seq_num_
+         << " last:" << last_seq_num_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Replay session message sent by the replay service after the updates it replayed for a request.
+  struct WireReplayResponse {
+    static constexpr uint8_t TEMPLATE_ID = 5;
+
+    ChannelId channel_id_;
+    ReplayStatus status_;
+    uint64_t first_seq_num_;
+    uint64_t last_seq_num_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireReplayResponse"
+         << " ["
+         << "channel:" << channelIdToString(channel_id_)
+         << " status:" << replayStatusToString(status_)
+         << " first:" << first_seq_num_
+         << " last:" << last_seq_num_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Snapshot session message sent by a consumer which needs a book without waiting for the next snapshot cycle, asks for the image of ticker_id_
+  /// or of every ticker on channel_id_ if it is TickerId_INVALID. request_id_ is echoed in the response.
+  struct WireSnapshotRequest {
+    static constexpr uint8_t TEMPLATE_ID = 6;
+
+    uint32_t request_id_;
+    ChannelId channel_id_;
+    WireMDTickerId ticker_id_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireSnapshotRequest"
+         << " ["
+         << "request:" << request_id_
+         << " channel:" << channelIdToString(channel_id_)
+         << " ticker:" << tickerIdToString(widenFromWire(ticker_id_, TickerId_INVALID))
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Snapshot session message sent by the snapshot service after the image it sent for a request, a CLEAR followed by an ADD per live order
+  /// for each ticker, num_updates_ updates in all. last_inc_seq_num_ is on the incremental stream of channel_id_.
+  struct WireSnapshotResponse {
+    static constexpr uint8_t TEMPLATE_ID = 7;
+
+    uint32_t request_id_;
+    ChannelId channel_id_;
+    SnapshotStatus status_;
+    WireMDTickerId ticker_id_;
+    uint64_t last_inc_seq_num_;
+    uint64_t num_updates_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireSnapshotResponse"
+         << " ["
+         << "request:" << request_id_
+         << " channel:" << channelIdToString(channel_id_)
+         << " status:" << snapshotStatusToString(status_)
+         << " ticker:" << tickerIdToString(widenFromWire(ticker_id_, TickerId_INVALID))
+         << " last_inc_seq:" << last_inc_seq_num_
+         << " updates:" << num_updates_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Totals of a price level in a conflated book.
+  struct WireBookLevel {
+    WireMDPrice price_;
+    Qty qty_;
+    uint32_t num_orders_;
+  };
+
+  /// Wire block of the top MD_CONFLATED_BOOK_DEPTH price levels on each side of one ticker, published on the conflated stream.
+  /// Levels are best first, the first num_bids_ / num_asks_ are valid and the rest are zeroed. Every book replaces the previous one of its ticker,
+  /// so a consumer which lost one only has to wait for the next.
+  struct WireConflatedBook {
+    static constexpr uint8_t TEMPLATE_ID = 8;
+
+    WireMDTickerId ticker_id_;
+    uint8_t num_bids_;
+    uint8_t num_asks_;
+    WireBookLevel bids_[MD_CONFLATED_BOOK_DEPTH];
+    WireBookLevel asks_[MD_CONFLATED_BOOK_DEPTH];
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireConflatedBook"
+         << " ["
+         << "ticker:" << tickerIdToString(widenFromWire(ticker_id_, TickerId_INVALID))
+         << " bids:";
+      for (size_t i = 0; i < num_bids_; ++i)
+        ss << bids_[i].qty_ << "@" << bids_[i].price_ << " ";
+      ss << "asks:";
+      for (size_t i = 0; i < num_asks_; ++i)
+        ss << asks_[i].qty_ << "@" << asks_[i].price_ << " ";
+      ss << "]";
+      return ss.str();
+    }
+  };
+
+  /// Wire block starting the level snapshot of one ticker, published on the market by price snapshot stream and followed by num_levels_
+  /// WirePriceLevelUpdates, the bids best first then the asks best first, the last one flagged last_in_batch_.
+  /// A consumer of the market by price stream builds a ticker's levels by replacing them with a snapshot and then applying the updates on the
+  /// market by price stream after last_mbp_seq_num_, and recovers from a gap on that stream the same way with the next snapshot.
+  struct WireLevelSnapshot {
+    static constexpr uint8_t TEMPLATE_ID = 9;
+
+    WireMDTickerId ticker_id_;
+    uint64_t last_mbp_seq_num_;
+    uint32_t num_levels_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireLevelSnapshot"
+         << " ["
+         << "ticker:" << tickerIdToString(widenFromWire(ticker_id_, TickerId_INVALID))
+         << " last_mbp_seq:" << last_mbp_seq_num_
+         << " levels:" << num_levels_
+         << "]";
+      return ss.str();
+    }
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  /// Largest encoded size of a market update, either template.
+  constexpr size_t MD_MAX_WIRE_UPDATE_SIZE = sizeof(WireMessageHeader) + std::max(sizeof(WireMarketUpdate), sizeof(WireTradeSummary));
+
+  /// Encode a market update with the template for its type.
+  template<typename Socket>
+  inline auto encodeMarketUpdate(WireFrameEncoder *encoder, Socket *socket, uint64_t seq_num, const MEMarketUpdate &market_update) noexcept {
+    if (UNLIKELY(market_update.type_ == MarketUpdateType::TRADE_SUMMARY))
+      encoder->append<WireTradeSummary>(socket, seq_num)->encode(market_update);
+    else
+      encoder->append<WireMarketUpdate>(socket, seq_num)->encode(market_update);
+  }
+
+  /// Decode a market update from either of its templates, returns false for any other message.
+  inline auto decodeMarketUpdate(const WireMessageHeader *message_header, const char *block, MEMarketUpdate *market_update) noexcept {
+    if (LIKELY(message_header->template_id_ == WireMarketUpdate::TEMPLATE_ID)) {
+      const auto wire_market_update = wireMessage<WireMarketUpdate>(message_header, block);
+      if (UNLIKELY(!wire_market_update))
+        return false;
+      *market_update = wire_market_update->decode();
+      return true;
+    }
+
+    const auto wire_trade_summary = wireMessage<WireTradeSummary>(message_header, block);
+    if (UNLIKELY(!wire_trade_summary))
+      return false;
+    *market_update = wire_trade_summary->decode();
+    return true;
+  }
+}
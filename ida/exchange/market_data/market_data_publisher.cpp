@@ -1,17 +1,43 @@
 #include "market_data_publisher.h"
 
 namespace Exchange {
-  MarketDataPublisher::MarketDataPublisher(MEMarketUpdateLFQueue *market_updates, const std::string &iface,
-                                           const std::string &snapshot_ip, int snapshot_port,
-                                           const std::string &incremental_ip, int incremental_port)
-      : outgoing_md_updates_(market_updates), snapshot_md_updates_(ME_MAX_MARKET_UPDATES),
-        run_(false), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_market_data_publisher.log"), incremental_socket_(logger_) {
-    ASSERT(incremental_socket_.init(incremental_ip, iface, incremental_port, /*is_listening*/ false) >= 0,
-           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
-    snapshot_synthesizer_ = new SnapshotSynthesizer(&snapshot_md_updates_, iface, snapshot_ip, snapshot_port);
+  MarketDataPublisher::MarketDataPublisher(MEMarketUpdateLFQueue *market_updates, MEPriceLevelUpdateLFQueue *price_level_updates,
+                                           const InstrumentRegistry *instruments, const std::string &iface, const MarketDataChannels &channels,
+                                           const std::string &market_by_price_ip, int market_by_price_port,
+                                           const std::string &mbp_snapshot_ip, int mbp_snapshot_port, Common::Nanos mbp_snapshot_interval,
+                                           const std::string &conflated_ip, int conflated_port, Common::Nanos conflated_interval,
+                                           Common::Nanos conflated_refresh_interval,
+                                           size_t max_packet_size, Common::Nanos max_packet_delay,
+                                           Common::Nanos snapshot_interval, size_t snapshot_bytes_per_sec, int snapshot_service_port,
+                                           int replay_port, size_t replay_ring_size)
+      : outgoing_md_updates_(market_updates), outgoing_price_level_updates_(price_level_updates), snapshot_md_updates_(ME_MAX_MARKET_UPDATES),
+        replay_md_updates_(ME_MAX_MARKET_UPDATES), conflated_price_level_updates_(ME_MAX_MARKET_UPDATES),
+        run_(false), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_market_data_publisher.log"),
+        market_by_price_socket_(logger_), market_by_price_encoder_(MARKET_DATA_SCHEMA_ID, MARKET_DATA_SCHEMA_VERSION, mcastMaxFrameSize(max_packet_size)) {
+    ASSERT(instruments->numChannels() <= channels.size(),
+           "Instruments are listed on " + std::to_string(instruments->numChannels()) + " channels but only " + std::to_string(channels.size()) + " are configured.");
+
+    for (const auto &channel: channels) {
+      auto &incremental_channel = incremental_channels_.emplace_back(logger_, max_packet_size);
+      ASSERT(incremental_channel.socket_.init(channel.incremental_ip_, iface, channel.incremental_port_, /*is_listening*/ false) >= 0,
+             "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+      incremental_channel.socket_.setPacketization(max_packet_size, max_packet_delay);
+    }
+    for (size_t ticker_id = 0; ticker_id < instruments->size(); ++ticker_id)
+      ticker_channels_.push_back(&incremental_channels_.at(instruments->at(ticker_id).channel_id_));
+
+    ASSERT(market_by_price_socket_.init(market_by_price_ip, iface, market_by_price_port, /*is_listening*/ false) >= 0,
+           "Unable to create market by price mcast socket. error:" + std::string(std::strerror(errno)));
+    market_by_price_socket_.setPacketization(max_packet_size, max_packet_delay);
+    snapshot_synthesizer_ = new SnapshotSynthesizer(&snapshot_md_updates_, instruments, iface, channels, max_packet_size,
+                                                    snapshot_interval, snapshot_bytes_per_sec, snapshot_service_port);
+    replay_server_ = new MarketDataReplayServer(&replay_md_updates_, instruments, iface, replay_port, replay_ring_size);
+    conflated_book_publisher_ = new ConflatedBookPublisher(&conflated_price_level_updates_, instruments, iface, conflated_ip, conflated_port, max_packet_size,
+                                                           conflated_interval, conflated_refresh_interval, mbp_snapshot_ip, mbp_snapshot_port,
+                                                           mbp_snapshot_interval);
   }
 
-  /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream and forwards them to the snapshot synthesizer.
+  /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream of their channel and forwards them to the snapshot synthesizer and the replay server.
   auto MarketDataPublisher::run() noexcept -> void {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
     while (run_) {
@@ -19,28 +45,52 @@ namespace Exchange {
            outgoing_md_updates_->size() && market_update; market_update = outgoing_md_updates_->getNextToRead()) {
         TTT_MEASURE(T5_MarketDataPublisher_LFQueue_read, logger_);
 
-        logger_.log("%:% %() % Sending seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), next_inc_seq_num_,
+        auto channel = ticker_channels_.at(market_update->ticker_id_);
+        const auto seq_num = channel->next_inc_seq_num_++;
+        logger_.log("%:% %() % Sending seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), seq_num,
                     market_update->toString().c_str());
 
         START_MEASURE(Exchange_McastSocket_send);
-        incremental_socket_.send(&next_inc_seq_num_, sizeof(next_inc_seq_num_));
-        incremental_socket_.send(market_update, sizeof(MEMarketUpdate));
+        encodeMarketUpdate(&channel->encoder_, &channel->socket_, seq_num, *market_update);
+        channel->socket_.sendFullPackets();
         END_MEASURE(Exchange_McastSocket_send, logger_);
 
         outgoing_md_updates_->updateReadIndex();
         TTT_MEASURE(T6_MarketDataPublisher_UDP_write, logger_);
 
-        // Forward this incremental market data update the snapshot synthesizer.
+        // Forward this incremental market data update the snapshot synthesizer, with the sequence number on its channel.
         auto next_write = snapshot_md_updates_.getNextToWriteTo();
-        next_write->seq_num_ = next_inc_seq_num_;
+        next_write->seq_num_ = seq_num;
         next_write->me_market_update_ = *market_update;
         snapshot_md_updates_.updateWriteIndex();
 
-        ++next_inc_seq_num_;
+        // And to the replay server.
+        *replay_md_updates_.getNextToWriteTo() = {seq_num, *market_update};
+        replay_md_updates_.updateWriteIndex();
+      }
+
+      for (auto price_level_update = outgoing_price_level_updates_->getNextToRead(); price_level_update;
+           price_level_update = outgoing_price_level_updates_->getNextToRead()) {
+        logger_.log("%:% %() % Sending mbp seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), next_mbp_seq_num_,
+                    price_level_update->toString().c_str());
+
+        START_MEASURE(Exchange_McastSocket_send);
+        market_by_price_encoder_.append<WirePriceLevelUpdate>(&market_by_price_socket_, next_mbp_seq_num_)->encode(*price_level_update);
+        market_by_price_socket_.sendFullPackets();
+        END_MEASURE(Exchange_McastSocket_send, logger_);
+
+        // Forward this price level update to the conflated book publisher, with its sequence number for the level snapshots.
+        *conflated_price_level_updates_.getNextToWriteTo() = {next_mbp_seq_num_, *price_level_update};
+        conflated_price_level_updates_.updateWriteIndex();
+
+        outgoing_price_level_updates_->updateReadIndex();
+        ++next_mbp_seq_num_;
       }
 
-      // Publish to the multicast stream.
-      incremental_socket_.sendAndRecv();
+      // Publish to the multicast streams, the updates of a burst which did not fill a packet go out once max_packet_delay has passed.
+      for (auto &channel: incremental_channels_)
+        channel.socket_.sendAndRecv();
+      market_by_price_socket_.sendAndRecv();
     }
   }
 }
@@ -1,15 +1,26 @@
 #pragma once
 
 #include <functional>
+#include <deque>
 
 #include "market_data/snapshot_synthesizer.h"
+#include "market_data/market_data_replay_server.h"
+#include "market_data/conflated_book_publisher.h"
+#include "market_data/market_data_protocol.h"
+#include "market_data/market_data_channel.h"
 
 namespace Exchange {
   class MarketDataPublisher {
   public:
-    MarketDataPublisher(MEMarketUpdateLFQueue *market_updates, const std::string &iface,
-                        const std::string &snapshot_ip, int snapshot_port,
-                        const std::string &incremental_ip, int incremental_port);
+    /// The incremental and snapshot streams of each instrument are published on the channel the InstrumentRegistry assigns it to.
+    MarketDataPublisher(MEMarketUpdateLFQueue *market_updates, MEPriceLevelUpdateLFQueue *price_level_updates,
+                        const InstrumentRegistry *instruments, const std::string &iface, const MarketDataChannels &channels,
+                        const std::string &market_by_price_ip, int market_by_price_port,
+                        const std::string &mbp_snapshot_ip, int mbp_snapshot_port, Common::Nanos mbp_snapshot_interval,
+                        const std::string &conflated_ip, int conflated_port, Common::Nanos conflated_interval, Common::Nanos conflated_refresh_interval,
+                        size_t max_packet_size, Common::Nanos max_packet_delay,
+                        Common::Nanos snapshot_interval, size_t snapshot_bytes_per_sec, int snapshot_service_port,
+                        int replay_port, size_t replay_ring_size);
 
     ~MarketDataPublisher() {
       stop();
@@ -19,24 +30,35 @@ namespace Exchange {
 
       delete snapshot_synthesizer_;
       snapshot_synthesizer_ = nullptr;
+
+      delete replay_server_;
+      replay_server_ = nullptr;
+
+      delete conflated_book_publisher_;
+      conflated_book_publisher_ = nullptr;
     }
 
-    /// Start and stop the market data publisher main thread, as well as the internal snapshot synthesizer thread.
+    /// Start and stop the market data publisher main thread, as well as the internal snapshot synthesizer, replay server and conflated book publisher threads.
     auto start() {
       run_ = true;
 
       ASSERT(Common::createAndStartThread(-1, "Exchange/MarketDataPublisher", [this]() { run(); }) != nullptr, "Failed to start MarketData thread.");
 
       snapshot_synthesizer_->start();
+      replay_server_->start();
+      conflated_book_publisher_->start();
     }
 
     auto stop() -> void {
       run_ = false;
 
       snapshot_synthesizer_->stop();
+      replay_server_->stop();
+      conflated_book_publisher_->stop();
     }
 
-    /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream and forwards them to the snapshot synthesizer.
+    /// Main run loop for this thread - consumes market updates from the lock free queue from the matching engine, publishes them on the incremental multicast stream of their channel and forwards them to the snapshot synthesizer and the replay server.
+    /// Also consumes price level updates from the matching engine, publishes them on the market by price multicast stream and forwards them to the conflated book publisher.
     auto run() noexcept -> void;
 
     // Deleted default, copy & move constructors and assignment-operators.
@@ -51,24 +73,59 @@ namespace Exchange {
     MarketDataPublisher &operator=(const MarketDataPublisher &&) = delete;
 
   private:
-    /// Sequencer number tracker on the incremental market data stream.
-    size_t next_inc_seq_num_ = 1;
-
     /// Lock free queue from which we consume market data updates sent by the matching engine.
     MEMarketUpdateLFQueue *outgoing_md_updates_ = nullptr;
 
+    /// Sequence number tracker on the market by price stream, independent of the incremental stream.
+    size_t next_mbp_seq_num_ = 1;
+
+    /// Lock free queue from which we consume price level updates sent by the matching engine.
+    MEPriceLevelUpdateLFQueue *outgoing_price_level_updates_ = nullptr;
+
     /// Lock free queue on which we forward the incremental market data updates to send to the snapshot synthesizer.
     MDPMarketUpdateLFQueue snapshot_md_updates_;
 
+    /// Lock free queue on which we forward the incremental market data updates to the replay server.
+    MDPMarketUpdateLFQueue replay_md_updates_;
+
+    /// Lock free queue on which we forward the price level updates to the conflated book publisher, with their market by price sequence numbers.
+    MDPPriceLevelUpdateLFQueue conflated_price_level_updates_;
+
     volatile bool run_ = false;
 
     std::string time_str_;
     Logger logger_;
 
-    /// Multicast socket to represent the incremental market data stream.
-    Common::McastSocket incremental_socket_;
+    /// Incremental market data stream of one channel, its multicast socket, the encoder for its frames and its sequence number tracker.
+    struct IncrementalChannel {
+      IncrementalChannel(Logger &logger, size_t max_packet_size)
+          : socket_(logger), encoder_(MARKET_DATA_SCHEMA_ID, MARKET_DATA_SCHEMA_VERSION, mcastMaxFrameSize(max_packet_size)) {
+      }
+
+      Common::McastSocket socket_;
+      WireFrameEncoder encoder_;
+      size_t next_inc_seq_num_ = 1;
+    };
+
+    /// Incremental stream of every channel indexed by ChannelId, and the one of every listed instrument indexed by TickerId.
+    std::deque<IncrementalChannel> incremental_channels_;
+    std::vector<IncrementalChannel *> ticker_channels_;
+
+    /// Multicast socket to represent the market by price stream, price level totals for consumers which do not need individual orders.
+    Common::McastSocket market_by_price_socket_;
+
+    /// Encode the updates on each stream into market data protocol frames, the updates published in one loop iteration share a frame.
+    /// Frames are capped to fit a packet, the sockets pack as many of them in each datagram as fit in max_packet_size.
+    WireFrameEncoder market_by_price_encoder_;
 
     /// Snapshot synthesizer which synthesizes and publishes limit order book snapshots on the snapshot multicast stream.
     SnapshotSynthesizer *snapshot_synthesizer_ = nullptr;
+
+    /// Replay server which serves the recent incremental updates over TCP to consumers recovering from a gap.
+    MarketDataReplayServer *replay_server_ = nullptr;
+
+    /// Conflated book publisher which publishes the top price levels of each instrument at a bounded rate on the conflated multicast stream,
+    /// and the level snapshots of the market by price stream.
+    ConflatedBookPublisher *conflated_book_publisher_ = nullptr;
   };
 }
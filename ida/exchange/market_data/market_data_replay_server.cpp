@@ -0,0 +1,115 @@
+#include "market_data_replay_server.h"
+
+namespace Exchange {
+  MarketDataReplayServer::MarketDataReplayServer(MDPMarketUpdateLFQueue *market_updates, const InstrumentRegistry *instruments, const std::string &iface,
+                                                 int port, size_t replay_ring_size)
+      : iface_(iface), port_(port), replay_md_updates_(market_updates), rings_(instruments->numChannels()),
+        logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_market_data_replay_server.log"),
+        replay_encoder_(MARKET_DATA_SCHEMA_ID, MARKET_DATA_SCHEMA_VERSION, WIRE_MAX_FRAME_SIZE), tcp_server_(logger_, Common::TCPBackend::EPOLL) {
+    ASSERT(replay_ring_size > 0, "Replay ring needs room for at least one update.");
+    for (auto &ring: rings_)
+      ring.updates_.resize(replay_ring_size);
+    for (size_t ticker_id = 0; ticker_id < instruments->size(); ++ticker_id)
+      ticker_channels_.push_back(instruments->at(ticker_id).channel_id_);
+
+    tcp_server_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
+    tcp_server_.recv_finished_callback_ = []() {};
+  }
+
+  MarketDataReplayServer::~MarketDataReplayServer() {
+    stop();
+  }
+
+  /// Start and stop the replay server thread.
+  auto MarketDataReplayServer::start() -> void {
+    run_ = true;
+    tcp_server_.listen(iface_, port_);
+    ASSERT(Common::createAndStartThread(-1, "Exchange/MarketDataReplayServer", [this]() { run(); }) != nullptr,
+           "Failed to start MarketDataReplayServer thread.");
+  }
+
+  auto MarketDataReplayServer::stop() -> void {
+    run_ = false;
+  }
+
+  /// Main run loop for this thread - keeps the ring up to date with the updates forwarded by the publisher and serves replay requests.
+  auto MarketDataReplayServer::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+    while (run_) {
+      addUpdates();
+
+      tcp_server_.poll();
+
+      tcp_server_.sendAndRecv();
+    }
+  }
+
+  /// Move the updates forwarded by the publisher into the ring of their channel.
+  auto MarketDataReplayServer::addUpdates() noexcept -> void {
+    for (auto market_update = replay_md_updates_->getNextToRead(); market_update; market_update = replay_md_updates_->getNextToRead()) {
+      auto &ring = rings_[ticker_channels_.at(market_update->me_market_update_.ticker_id_)];
+      ASSERT(market_update->seq_num_ == ring.last_seq_num_ + 1, "Expected incremental seq_nums to increase on each channel.");
+      ring.updates_[market_update->seq_num_ % ring.updates_.size()] = *market_update;
+      ring.last_seq_num_ = market_update->seq_num_;
+      replay_md_updates_->updateReadIndex();
+    }
+  }
+
+  /// Callback when replay requests are read from a consumer's connection.
+  auto MarketDataReplayServer::recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void {
+    logger_.log("%:% %() % Received socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket->socket_fd_,
+                socket->next_rcv_valid_index_, rx_time);
+
+    const auto consumed = Common::decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [&](const Common::WireFrameHeader *frame) {
+      Common::forEachWireMessage(frame, MARKET_DATA_SCHEMA_ID, [&](size_t seq_num, const Common::WireMessageHeader *message_header, const char *block) {
+        if (const auto request = Common::wireMessage<WireReplayRequest>(message_header, block); LIKELY(request)) {
+          onReplayRequest(socket, *request);
+          return;
+        }
+
+        logger_.log("%:% %() % Ignoring template:% block_length:% seq:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    static_cast<int>(message_header->template_id_), static_cast<int>(message_header->block_length_), seq_num);
+      });
+      return true;
+    });
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+    socket->next_rcv_valid_index_ -= consumed;
+  }
+
+  /// Send the updates asked for which are still in the ring and fit in the socket's send buffer, followed by a WireReplayResponse.
+  auto MarketDataReplayServer::onReplayRequest(TCPSocket *socket, const WireReplayRequest &request) noexcept -> void {
+    // The consumer asks for updates published before the one which revealed the gap, those may still be on their way from the publisher.
+    addUpdates();
+
+    constexpr size_t response_size = sizeof(WireFrameHeader) + sizeof(WireMessageHeader) + sizeof(WireReplayResponse);
+    const auto free_space = socket->outbound_data_.size() - socket->next_send_valid_index_;
+    if (UNLIKELY(free_space < response_size)) { // the consumer is not reading what it asked for, it gives up on the request and recovers from a snapshot.
+      logger_.log("%:% %() % Dropping % on socket:% with a full send buffer.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  request.toString(), socket->socket_fd_);
+      return;
+    }
+
+    WireReplayResponse response{request.channel_id_, ReplayStatus::UNAVAILABLE, 0, 0};
+    if (LIKELY(request.channel_id_ < rings_.size())) {
+      const auto &ring = rings_[request.channel_id_];
+      const auto first_kept = (ring.last_seq_num_ >= ring.updates_.size() ? ring.last_seq_num_ - ring.updates_.size() + 1 : 1);
+      // Whatever does not fit in the send buffer is left for the consumer to ask for again, sizes are rounded up to cover the frame headers.
+      const auto max_updates = (free_space - response_size) / (MD_MAX_WIRE_UPDATE_SIZE + 1);
+      response = {request.channel_id_, ReplayStatus::UNAVAILABLE, first_kept, ring.last_seq_num_};
+      if (UNLIKELY(request.first_seq_num_ > request.last_seq_num_ || !max_updates)) {
+        // An OK with an empty range would send the consumer back asking for the same gap, it recovers from a snapshot instead.
+        response.status_ = ReplayStatus::REJECTED;
+      } else if (LIKELY(request.first_seq_num_ >= first_kept && request.first_seq_num_ <= ring.last_seq_num_)) {
+        response = {request.channel_id_, ReplayStatus::OK, request.first_seq_num_,
+                    std::min({request.last_seq_num_, ring.last_seq_num_, request.first_seq_num_ + max_updates - 1})};
+        for (auto seq_num = response.first_seq_num_; seq_num <= response.last_seq_num_; ++seq_num)
+          encodeMarketUpdate(&replay_encoder_, socket, seq_num, ring.updates_[seq_num % ring.updates_.size()].me_market_update_);
+      }
+    }
+
+    *replay_encoder_.append<WireReplayResponse>(socket, MD_SESSION_SEQ_NUM) = response;
+
+    logger_.log("%:% %() % socket:% % => %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket->socket_fd_,
+                request.toString(), response.toString());
+  }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "common/thread_utils.h"
+#include "common/macros.h"
+#include "common/tcp_server.h"
+#include "common/instrument_registry.h"
+
+#include "market_data/market_update.h"
+#include "market_data/market_data_protocol.h"
+
+namespace Exchange {
+  /// Serves the most recent incremental market updates over TCP, so a consumer which lost some of them on the multicast stream can ask for
+  /// just the missing sequence numbers instead of waiting for the next snapshot cycle.
+  /// The updates are forwarded by the market data publisher and kept in a ring per market data channel of the replay_ring_size most recent ones
+  /// on that channel, indexed by the channel's sequence numbers.
+  class MarketDataReplayServer {
+  public:
+    MarketDataReplayServer(MDPMarketUpdateLFQueue *market_updates, const InstrumentRegistry *instruments, const std::string &iface, int port,
+                           size_t replay_ring_size);
+
+    ~MarketDataReplayServer();
+
+    /// Start and stop the replay server thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Main run loop for this thread - keeps the ring up to date with the updates forwarded by the publisher and serves replay requests.
+    auto run() noexcept -> void;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    MarketDataReplayServer() = delete;
+
+    MarketDataReplayServer(const MarketDataReplayServer &) = delete;
+
+    MarketDataReplayServer(const MarketDataReplayServer &&) = delete;
+
+    MarketDataReplayServer &operator=(const MarketDataReplayServer &) = delete;
+
+    MarketDataReplayServer &operator=(const MarketDataReplayServer &&) = delete;
+
+  private:
+    /// Move the updates forwarded by the publisher into the ring.
+    auto addUpdates() noexcept -> void;
+
+    /// Callback when replay requests are read from a consumer's connection.
+    auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void;
+
+    /// Send the updates asked for which are still in the ring and fit in the socket's send buffer, followed by a WireReplayResponse.
+    auto onReplayRequest(TCPSocket *socket, const WireReplayRequest &request) noexcept -> void;
+
+    const std::string iface_;
+    const int port_;
+
+    /// Lock free queue on which the market data publisher forwards every incremental update it publishes.
+    MDPMarketUpdateLFQueue *replay_md_updates_ = nullptr;
+
+    /// The most recent incremental updates of one channel, the update with sequence number n is at n % size(), and the last sequence number added.
+    struct ReplayRing {
+      std::vector<MDPMarketUpdate> updates_;
+      size_t last_seq_num_ = 0;
+    };
+
+    /// Ring of every channel indexed by ChannelId, and the channel of every listed instrument indexed by TickerId.
+    std::vector<ReplayRing> rings_;
+    std::vector<ChannelId> ticker_channels_;
+
+    volatile bool run_ = false;
+
+    std::string time_str_;
+    Logger logger_;
+
+    /// Encodes the replayed updates and the replay session messages into market data protocol frames.
+    WireFrameEncoder replay_encoder_;
+
+    /// TCP server which accepts the consumers' replay connections.
+    Common::TCPServer tcp_server_;
+  };
+}
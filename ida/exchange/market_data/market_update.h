@@ -17,7 +17,8 @@ namespace Exchange {
     CANCEL = 4,
     TRADE = 5,
     SNAPSHOT_START = 6,
-    SNAPSHOT_END = 7
+    SNAPSHOT_END = 7,
+    TRADE_SUMMARY = 8
   };
 
   inline std::string marketUpdateTypeToString(MarketUpdateType type) {
@@ -36,6 +37,8 @@ namespace Exchange {
         return "SNAPSHOT_START";
       case MarketUpdateType::SNAPSHOT_END:
         return "SNAPSHOT_END";
+      case MarketUpdateType::TRADE_SUMMARY:
+        return "TRADE_SUMMARY";
       case MarketUpdateType::INVALID:
         return "INVALID";
     }
@@ -46,32 +49,65 @@ namespace Exchange {
 #pragma pack(push, 1)
 
   /// Market update structure used internally by the matching engine.
+  /// A TRADE_SUMMARY is published ahead of the TRADE and CANCEL / MODIFY updates for all the passive orders an aggressive order matched.
+  /// It has no order, its side_ is the aggressor side, qty_ the total quantity traded and price_ the best price left on the passive side after the sweep,
+  /// and it uses the fields named for it below, which share the storage of the order fields, instead of order_id_ and priority_.
   struct MEMarketUpdate {
     MarketUpdateType type_ = MarketUpdateType::INVALID;
 
-    OrderId order_id_ = OrderId_INVALID;
+    union {
+      OrderId order_id_ = OrderId_INVALID;
+      /// TRADE_SUMMARY: number of price levels the aggressive order took liquidity from.
+      uint64_t num_levels_;
+    };
     TickerId ticker_id_ = TickerId_INVALID;
     Side side_ = Side::INVALID;
     Price price_ = Price_INVALID;
     Qty qty_ = Qty_INVALID;
-    Priority priority_ = Priority_INVALID;
+    union {
+      Priority priority_ = Priority_INVALID;
+      /// TRADE_SUMMARY: sum of price * quantity over the passive orders matched.
+      uint64_t notional_;
+    };
+
+    /// Set on the last market update generated by a single client request, the book is only consistent after this update.
+    bool last_in_batch_ = false;
+
+    /// TRADE_SUMMARY: best price on the aggressor side after the sweep, that of the aggressive order if its remainder rests.
+    /// Together with price_ it is the top of book once all the updates of the batch are applied, Price_INVALID for a side left empty.
+    Price aggressor_best_price_ = Price_INVALID;
 
     auto toString() const {
       std::stringstream ss;
       ss << "MEMarketUpdate"
          << " ["
          << " type:" << marketUpdateTypeToString(type_)
-         << " ticker:" << tickerIdToString(ticker_id_)
-         << " oid:" << orderIdToString(order_id_)
-         << " side:" << sideToString(side_)
-         << " qty:" << qtyToString(qty_)
-         << " price:" << priceToString(price_)
-         << " priority:" << priorityToString(priority_)
+         << " ticker:" << tickerIdToString(ticker_id_);
+      if (type_ == MarketUpdateType::TRADE_SUMMARY) {
+        ss << " aggressor:" << sideToString(side_)
+           << " qty:" << qtyToString(qty_)
+           << " notional:" << notional_
+           << " levels:" << num_levels_
+           << " passive_best:" << priceToString(price_)
+           << " aggressor_best:" << priceToString(aggressor_best_price_);
+      } else {
+        ss << " oid:" << orderIdToString(order_id_)
+           << " side:" << sideToString(side_)
+           << " qty:" << qtyToString(qty_)
+           << " price:" << priceToString(price_)
+           << " priority:" << priorityToString(priority_);
+      }
+      ss << " last:" << last_in_batch_
          << "]";
       return ss.str();
     }
   };
 
+  /// Volume weighted average price of the passive orders a TRADE_SUMMARY matched.
+  inline auto tradeSummaryVwap(const MEMarketUpdate *trade_summary) noexcept {
+    return static_cast<double>(trade_summary->notional_) / trade_summary->qty_;
+  }
+
   /// Market update structure published over the network by the market data publisher.
   struct MDPMarketUpdate {
     size_t seq_num_ = 0;
@@ -88,9 +124,56 @@ namespace Exchange {
     }
   };
 
+  /// Price level update structure used internally by the matching engine for the market by price stream.
+  /// Carries the total quantity and number of orders at the price level after it changed, both are 0 when the price level was removed.
+  struct MEPriceLevelUpdate {
+    TickerId ticker_id_ = TickerId_INVALID;
+    Side side_ = Side::INVALID;
+    Price price_ = Price_INVALID;
+    Qty qty_ = 0;
+    uint32_t num_orders_ = 0;
+
+    /// Set on the last price level update generated by a single client request.
+    bool last_in_batch_ = false;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "MEPriceLevelUpdate"
+         << " ["
+         << " ticker:" << tickerIdToString(ticker_id_)
+         << " side:" << sideToString(side_)
+         << " price:" << priceToString(price_)
+         << " qty:" << qtyToString(qty_)
+         << " orders:" << num_orders_
+         << " last:" << last_in_batch_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Price level update structure published over the network on the market by price stream, which has its own sequence numbers.
+  struct MDPPriceLevelUpdate {
+    size_t seq_num_ = 0;
+    MEPriceLevelUpdate me_price_level_update_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "MDPPriceLevelUpdate"
+         << " ["
+         << " seq:" << seq_num_
+         << " " << me_price_level_update_.toString()
+         << "]";
+      return ss.str();
+    }
+  };
+
 #pragma pack(pop) // Undo the packed binary structure directive moving forward.
 
   /// Lock free queues of matching engine market update messages and market data publisher market updates messages respectively.
   typedef Common::LFQueue<Exchange::MEMarketUpdate> MEMarketUpdateLFQueue;
   typedef Common::LFQueue<Exchange::MDPMarketUpdate> MDPMarketUpdateLFQueue;
+
+  /// Lock free queues of matching engine price level updates and market data publisher price level updates on the market by price stream respectively.
+  typedef Common::LFQueue<Exchange::MEPriceLevelUpdate> MEPriceLevelUpdateLFQueue;
+  typedef Common::LFQueue<Exchange::MDPPriceLevelUpdate> MDPPriceLevelUpdateLFQueue;
 }
@@ -1,13 +1,35 @@
 #include "snapshot_synthesizer.h"
 
 namespace Exchange {
-  SnapshotSynthesizer::SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface,
-                                           const std::string &snapshot_ip, int snapshot_port)
-      : snapshot_md_updates_(market_updates), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_snapshot_synthesizer.log"), snapshot_socket_(logger_), order_pool_(ME_MAX_ORDER_IDS) {
-    ASSERT(snapshot_socket_.init(snapshot_ip, iface, snapshot_port, /*is_listening*/ false) >= 0,
-           "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
-    for(auto& orders : ticker_orders_)
-      orders.fill(nullptr);
+  SnapshotSynthesizer::SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const InstrumentRegistry *instruments, const std::string &iface,
+                                           const MarketDataChannels &channels, size_t max_packet_size, Nanos snapshot_interval,
+                                           size_t snapshot_bytes_per_sec, int snapshot_service_port)
+      : snapshot_md_updates_(market_updates), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_snapshot_synthesizer.log"),
+        ticker_orders_(instruments->size()), snapshot_interval_(snapshot_interval), snapshot_bytes_per_sec_(snapshot_bytes_per_sec),
+        iface_(iface), snapshot_service_port_(snapshot_service_port),
+        snapshot_service_encoder_(MARKET_DATA_SCHEMA_ID, MARKET_DATA_SCHEMA_VERSION, WIRE_MAX_FRAME_SIZE), snapshot_service_server_(logger_, TCPBackend::EPOLL) {
+    for (const auto &channel: channels) {
+      auto &snapshot_channel = channels_.emplace_back(logger_, max_packet_size);
+      ASSERT(snapshot_channel.socket_.init(channel.snapshot_ip_, iface, channel.snapshot_port_, /*is_listening*/ false) >= 0,
+             "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
+      snapshot_channel.socket_.setPacketization(max_packet_size, 0);
+    }
+    for (size_t ticker_id = 0; ticker_id < instruments->size(); ++ticker_id) {
+      auto channel = &channels_.at(instruments->at(ticker_id).channel_id_);
+      channel->ticker_ids_.push_back(ticker_id);
+      ticker_channels_.push_back(channel);
+    }
+
+    // Sized for the most orders each instrument can have resting, so the dense order sets do not reallocate on the hot path.
+    size_t max_orders = 0;
+    for (size_t ticker_id = 0; ticker_id < ticker_orders_.size(); ++ticker_id) {
+      ticker_orders_.at(ticker_id).orders_.reserve(instruments->at(ticker_id).max_orders_);
+      max_orders = std::max(max_orders, static_cast<size_t>(instruments->at(ticker_id).max_orders_));
+    }
+    queue_orders_.reserve(max_orders);
+
+    snapshot_service_server_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
+    snapshot_service_server_.recv_finished_callback_ = []() {};
   }
 
   SnapshotSynthesizer::~SnapshotSynthesizer() {
@@ -17,6 +39,7 @@ namespace Exchange {
   /// Start and stop the snapshot synthesizer thread.
   void SnapshotSynthesizer::start() {
     run_ = true;
+    snapshot_service_server_.listen(iface_, snapshot_service_port_);
     ASSERT(Common::createAndStartThread(-1, "Exchange/SnapshotSynthesizer", [this]() { run(); }) != nullptr,
            "Failed to start SnapshotSynthesizer thread.");
   }
@@ -25,92 +48,224 @@ namespace Exchange {
     run_ = false;
   }
 
+  /// Returns the live order with this market order id, or nullptr.
+  auto SnapshotSynthesizer::findOrder(SnapshotOrders *orders, OrderId order_id) noexcept -> MEMarketUpdate * {
+    const auto itr = std::lower_bound(orders->orders_.begin(), orders->orders_.end(), order_id,
+                                      [](const MEMarketUpdate &order, OrderId id) { return order.order_id_ < id; });
+    return ((itr != orders->orders_.end() && itr->order_id_ == order_id && itr->type_ != MarketUpdateType::INVALID) ? &*itr : nullptr);
+  }
+
   /// Process an incremental market update and update the limit order book snapshot.
   auto SnapshotSynthesizer::addToSnapshot(const MDPMarketUpdate *market_update) {
     const auto &me_market_update = market_update->me_market_update_;
     auto *orders = &ticker_orders_.at(me_market_update.ticker_id_);
     switch (me_market_update.type_) {
       case MarketUpdateType::ADD: {
-        auto order = orders->at(me_market_update.order_id_);
+        auto order = findOrder(orders, me_market_update.order_id_);
         ASSERT(order == nullptr, "Received:" + me_market_update.toString() + " but order already exists:" + (order ? order->toString() : ""));
-        orders->at(me_market_update.order_id_) = order_pool_.allocate(me_market_update);
+
+        // Market order ids are increasing so adds append, an out of order one is inserted in its place.
+        auto &dense = orders->orders_;
+        if (LIKELY(dense.empty() || dense.back().order_id_ < me_market_update.order_id_)) {
+          dense.push_back(me_market_update);
+        } else {
+          auto itr = std::lower_bound(dense.begin(), dense.end(), me_market_update.order_id_,
+                                      [](const MEMarketUpdate &existing, OrderId id) { return existing.order_id_ < id; });
+          if (itr != dense.end() && itr->order_id_ == me_market_update.order_id_)
+            *itr = me_market_update;
+          else
+            dense.insert(itr, me_market_update);
+        }
+        ++orders->num_live_;
       }
         break;
       case MarketUpdateType::MODIFY: {
-        auto order = orders->at(me_market_update.order_id_);
+        auto order = findOrder(orders, me_market_update.order_id_);
         ASSERT(order != nullptr, "Received:" + me_market_update.toString() + " but order does not exist.");
-        ASSERT(order->order_id_ == me_market_update.order_id_, "Expecting existing order to match new one.");
         ASSERT(order->side_ == me_market_update.side_, "Expecting existing order to match new one.");
 
         order->qty_ = me_market_update.qty_;
         order->price_ = me_market_update.price_;
+        order->priority_ = me_market_update.priority_;
       }
         break;
       case MarketUpdateType::CANCEL: {
-        auto order = orders->at(me_market_update.order_id_);
+        auto order = findOrder(orders, me_market_update.order_id_);
         ASSERT(order != nullptr, "Received:" + me_market_update.toString() + " but order does not exist.");
-        ASSERT(order->order_id_ == me_market_update.order_id_, "Expecting existing order to match new one.");
         ASSERT(order->side_ == me_market_update.side_, "Expecting existing order to match new one.");
 
-        order_pool_.deallocate(order);
-        orders->at(me_market_update.order_id_) = nullptr;
+        order->type_ = MarketUpdateType::INVALID;
+        --orders->num_live_;
+        if (orders->orders_.size() > 2 * orders->num_live_) { // compact once the cancelled orders outnumber the live ones.
+          auto &dense = orders->orders_;
+          dense.erase(std::remove_if(dense.begin(), dense.end(), [](const MEMarketUpdate &existing) { return existing.type_ == MarketUpdateType::INVALID; }),
+                      dense.end());
+        }
       }
         break;
       case MarketUpdateType::SNAPSHOT_START:
       case MarketUpdateType::CLEAR:
       case MarketUpdateType::SNAPSHOT_END:
       case MarketUpdateType::TRADE:
+      case MarketUpdateType::TRADE_SUMMARY:
       case MarketUpdateType::INVALID:
         break;
     }
 
-    ASSERT(market_update->seq_num_ == last_inc_seq_num_ + 1, "Expected incremental seq_nums to increase.");
-    last_inc_seq_num_ = market_update->seq_num_;
+    auto channel = ticker_channels_.at(me_market_update.ticker_id_);
+    ASSERT(market_update->seq_num_ == channel->last_inc_seq_num_ + 1, "Expected incremental seq_nums to increase on each channel.");
+    channel->last_inc_seq_num_ = market_update->seq_num_;
   }
 
-  /// Publish a full snapshot cycle on the snapshot multicast stream.
-  auto SnapshotSynthesizer::publishSnapshot() {
-    size_t snapshot_size = 0;
+  /// Fill queue_orders_ with the live orders of the ticker sorted by side, price and priority, the order consumers queue them in at each price.
+  /// It is not the market order id order, a cancel-replace keeps its market order id but goes to the back of its new price with a new priority.
+  auto SnapshotSynthesizer::queueOrders(TickerId ticker_id) noexcept -> const std::vector<MEMarketUpdate> & {
+    queue_orders_.clear();
+    for (const auto &order: ticker_orders_.at(ticker_id).orders_) {
+      if (order.type_ != MarketUpdateType::INVALID)
+        queue_orders_.push_back(order);
+    }
+    std::sort(queue_orders_.begin(), queue_orders_.end(), [](const MEMarketUpdate &lhs, const MEMarketUpdate &rhs) {
+      return std::tie(lhs.side_, lhs.price_, lhs.priority_) < std::tie(rhs.side_, rhs.price_, rhs.priority_);
+    });
 
-    // The snapshot cycle starts with a SNAPSHOT_START message and order_id_ contains the last sequence number from the incremental market data stream used to build this snapshot.
-    const MDPMarketUpdate start_market_update{snapshot_size++, {MarketUpdateType::SNAPSHOT_START, last_inc_seq_num_}};
-    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), start_market_update.toString());
-    snapshot_socket_.send(&start_market_update, sizeof(MDPMarketUpdate));
+    return queue_orders_;
+  }
 
-    // Publish order information for each order in the limit order book for each instrument.
-    for (size_t ticker_id = 0; ticker_id < ticker_orders_.size(); ++ticker_id) {
-      const auto &orders = ticker_orders_.at(ticker_id);
+  /// Start a snapshot cycle of the channel by copying the live orders of its instruments, so the cycle stays consistent with last_inc_seq_num_
+  /// while the incremental updates which arrive during it keep being applied.
+  auto SnapshotSynthesizer::startSnapshot(SnapshotChannel *channel) -> void {
+    auto &cycle_updates = channel->cycle_updates_;
+    cycle_updates.clear();
+    channel->next_cycle_update_ = 0;
+    channel->cycle_start_time_ = getCurrentNanos();
+    channel->cycle_bytes_ = 0;
 
+    // The snapshot cycle starts with a SNAPSHOT_START message and order_id_ contains the last sequence number from the channel's incremental stream used to build this snapshot.
+    cycle_updates.push_back({cycle_updates.size(), {MarketUpdateType::SNAPSHOT_START, channel->last_inc_seq_num_, TickerId_INVALID, Side::INVALID,
+                                                     Price_INVALID, Qty_INVALID, Priority_INVALID}});
+
+    for (const auto ticker_id: channel->ticker_ids_) {
+      // We start order information for each instrument by first publishing a CLEAR message so the downstream consumer can clear the order book.
       MEMarketUpdate me_market_update;
       me_market_update.type_ = MarketUpdateType::CLEAR;
       me_market_update.ticker_id_ = ticker_id;
+      cycle_updates.push_back({cycle_updates.size(), me_market_update});
 
-      // We start order information for each instrument by first publishing a CLEAR message so the downstream consumer can clear the order book.
-      const MDPMarketUpdate clear_market_update{snapshot_size++, me_market_update};
-      logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), clear_market_update.toString());
-      snapshot_socket_.send(&clear_market_update, sizeof(MDPMarketUpdate));
-
-      // Publish each order.
-      for (const auto order: orders) {
-        if (order) {
-          const MDPMarketUpdate market_update{snapshot_size++, *order};
-          logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), market_update.toString());
-          snapshot_socket_.send(&market_update, sizeof(MDPMarketUpdate));
-          snapshot_socket_.sendAndRecv();
+      for (const auto &order: queueOrders(ticker_id))
+        cycle_updates.push_back({cycle_updates.size(), order});
+    }
+
+    // The snapshot cycle ends with a SNAPSHOT_END message and order_id_ contains the last sequence number from the channel's incremental stream used to build this snapshot.
+    cycle_updates.push_back({cycle_updates.size(), {MarketUpdateType::SNAPSHOT_END, channel->last_inc_seq_num_, TickerId_INVALID, Side::INVALID,
+                                                     Price_INVALID, Qty_INVALID, Priority_INVALID}});
+
+    logger_.log("%:% %() % Started snapshot of % orders at inc seq:% in % nanos.\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                cycle_updates.size() - 2 - channel->ticker_ids_.size(), channel->last_inc_seq_num_, getCurrentNanos() - channel->cycle_start_time_);
+  }
+
+  /// Publish the next messages of the channel's snapshot cycle in progress, as many as the pace allows since the cycle started.
+  /// Full packets go out as they fill up and the last one when the cycle is done, so the stream carries packets of many orders each.
+  /// Only the cycle is logged and not each order, formatting every order would take far longer than publishing it.
+  auto SnapshotSynthesizer::publishSnapshot(SnapshotChannel *channel) -> void {
+    const auto allowed_bytes = (snapshot_bytes_per_sec_ ?
+                                static_cast<size_t>(static_cast<double>(getCurrentNanos() - channel->cycle_start_time_) / NANOS_TO_SECS * snapshot_bytes_per_sec_) :
+                                std::numeric_limits<size_t>::max());
+
+    auto &socket = channel->socket_;
+    for (; channel->next_cycle_update_ < channel->cycle_updates_.size() && channel->cycle_bytes_ <= allowed_bytes; ++channel->next_cycle_update_) {
+      const auto &market_update = channel->cycle_updates_.at(channel->next_cycle_update_);
+      const auto send_index = socket.next_send_valid_index_;
+      encodeMarketUpdate(&channel->encoder_, &socket, market_update.seq_num_, market_update.me_market_update_);
+      channel->cycle_bytes_ += socket.next_send_valid_index_ - send_index;
+      socket.sendFullPackets();
+    }
+
+    if (channel->next_cycle_update_ == channel->cycle_updates_.size()) {
+      socket.sendAndRecv();
+      logger_.log("%:% %() % Published snapshot of % orders, % bytes in % nanos.\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                  channel->cycle_updates_.size() - 2 - channel->ticker_ids_.size(), channel->cycle_bytes_, getCurrentNanos() - channel->cycle_start_time_);
+      channel->cycle_updates_.clear();
+      channel->next_cycle_update_ = 0;
+    }
+  }
+
+  /// Callback when snapshot requests are read from a consumer's connection.
+  auto SnapshotSynthesizer::recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void {
+    logger_.log("%:% %() % Received socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), socket->socket_fd_,
+                socket->next_rcv_valid_index_, rx_time);
+
+    const auto consumed = decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [&](const WireFrameHeader *frame) {
+      forEachWireMessage(frame, MARKET_DATA_SCHEMA_ID, [&](size_t seq_num, const WireMessageHeader *message_header, const char *block) {
+        if (const auto request = wireMessage<WireSnapshotRequest>(message_header, block); LIKELY(request)) {
+          onSnapshotRequest(socket, *request);
+          return;
         }
+
+        logger_.log("%:% %() % Ignoring template:% block_length:% seq:%\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                    static_cast<int>(message_header->template_id_), static_cast<int>(message_header->block_length_), seq_num);
+      });
+      return true;
+    });
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+    socket->next_rcv_valid_index_ -= consumed;
+  }
+
+  /// Send the image of the tickers asked for, consistent with their channel's last_inc_seq_num_, followed by a WireSnapshotResponse.
+  /// This thread applies the incremental updates in order, so the image taken between two of them is consistent without copying the whole book first,
+  /// and it is encoded straight into the connection's send buffer as frames of many updates each.
+  auto SnapshotSynthesizer::onSnapshotRequest(TCPSocket *socket, const WireSnapshotRequest &request) noexcept -> void {
+    const auto start_time = getCurrentNanos();
+    const auto ticker_id = widenFromWire(request.ticker_id_, TickerId_INVALID);
+    const auto channel = (request.channel_id_ < channels_.size() ? &channels_.at(request.channel_id_) : nullptr);
+    WireSnapshotResponse response{request.request_id_, request.channel_id_, SnapshotStatus::UNKNOWN_TICKER, request.ticker_id_,
+                                  (channel ? channel->last_inc_seq_num_ : 0), 0};
+
+    if (LIKELY(channel && (ticker_id == TickerId_INVALID || (ticker_id < ticker_channels_.size() && ticker_channels_.at(ticker_id) == channel)))) {
+      const auto single_ticker = std::vector<TickerId>{ticker_id};
+      const auto &ticker_ids = (ticker_id == TickerId_INVALID ? channel->ticker_ids_ : single_ticker);
+
+      size_t num_updates = 0;
+      for (const auto id: ticker_ids)
+        num_updates += 1 + ticker_orders_.at(id).num_live_;
+
+      // Sizes are rounded up to cover the frame headers, like the replay service does.
+      constexpr size_t response_size = sizeof(WireFrameHeader) + sizeof(WireMessageHeader) + sizeof(WireSnapshotResponse);
+      const auto free_space = socket->outbound_data_.size() - socket->next_send_valid_index_;
+      if (UNLIKELY(free_space < response_size)) { // the consumer is not reading what it asked for, it times out and recovers from the snapshot stream.
+        logger_.log("%:% %() % Dropping % on socket:% with a full send buffer.\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                    request.toString(), socket->socket_fd_);
+        return;
+      }
+
+      response.status_ = SnapshotStatus::UNAVAILABLE;
+      if (LIKELY(num_updates * (MD_MAX_WIRE_UPDATE_SIZE + 1) <= free_space - response_size)) {
+        size_t seq_num = 0;
+        for (const auto id: ticker_ids) {
+          // Each ticker's image starts with a CLEAR so the consumer clears its order book before the orders.
+          MEMarketUpdate clear;
+          clear.type_ = MarketUpdateType::CLEAR;
+          clear.ticker_id_ = id;
+          encodeMarketUpdate(&snapshot_service_encoder_, socket, seq_num++, clear);
+
+          for (const auto &order: queueOrders(id))
+            encodeMarketUpdate(&snapshot_service_encoder_, socket, seq_num++, order);
+        }
+
+        response.status_ = SnapshotStatus::OK;
+        response.num_updates_ = seq_num;
       }
     }
 
-    // The snapshot cycle ends with a SNAPSHOT_END message and order_id_ contains the last sequence number from the incremental market data stream used to build this snapshot.
-    const MDPMarketUpdate end_market_update{snapshot_size++, {MarketUpdateType::SNAPSHOT_END, last_inc_seq_num_}};
-    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), end_market_update.toString());
-    snapshot_socket_.send(&end_market_update, sizeof(MDPMarketUpdate));
-    snapshot_socket_.sendAndRecv();
+    *snapshot_service_encoder_.append<WireSnapshotResponse>(socket, MD_SESSION_SEQ_NUM) = response;
 
-    logger_.log("%:% %() % Published snapshot of % orders.\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), snapshot_size - 1);
+    logger_.log("%:% %() % socket:% % => % in % nanos\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), socket->socket_fd_,
+                request.toString(), response.toString(), getCurrentNanos() - start_time);
   }
 
-  /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot and publishes the snapshot periodically.
+  /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot, publishes the snapshot periodically
+  /// and serves snapshot requests.
+  /// A snapshot cycle is published a slice at a time between draining the incremental updates, at the configured pace.
   void SnapshotSynthesizer::run() {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_));
     while (run_) {
@@ -123,10 +278,18 @@ namespace Exchange {
         snapshot_md_updates_->updateReadIndex();
       }
 
-      if (getCurrentNanos() - last_snapshot_time_ > 60 * NANOS_TO_SECS) {
-        last_snapshot_time_ = getCurrentNanos();
-        publishSnapshot();
+      for (auto &channel: channels_) {
+        if (channel.cycle_updates_.empty() && getCurrentNanos() - channel.last_snapshot_time_ > snapshot_interval_) {
+          channel.last_snapshot_time_ = getCurrentNanos();
+          startSnapshot(&channel);
+        }
+        if (!channel.cycle_updates_.empty())
+          publishSnapshot(&channel);
       }
+
+      snapshot_service_server_.poll();
+
+      snapshot_service_server_.sendAndRecv();
     }
   }
 }
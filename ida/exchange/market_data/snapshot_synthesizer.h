@@ -1,23 +1,32 @@
 #pragma once
 
+#include <deque>
+
 #include "common/types.h"
 #include "common/thread_utils.h"
 #include "common/lf_queue.h"
 #include "common/macros.h"
 #include "common/mcast_socket.h"
-#include "common/mem_pool.h"
+#include "common/tcp_server.h"
 #include "common/logging.h"
+#include "common/instrument_registry.h"
 
 #include "market_data/market_update.h"
+#include "market_data/market_data_protocol.h"
+#include "market_data/market_data_channel.h"
 #include "matcher/me_order.h"
 
 using namespace Common;
 
 namespace Exchange {
+  /// Keeps the limit order book of every instrument from the incremental updates, publishes the books of each channel periodically on the channel's
+  /// snapshot multicast stream and serves them on demand over TCP on snapshot_service_port, so a consumer joining mid-session does not have to wait
+  /// for the next cycle.
   class SnapshotSynthesizer {
   public:
-    SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface,
-                        const std::string &snapshot_ip, int snapshot_port);
+    SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const InstrumentRegistry *instruments, const std::string &iface,
+                        const MarketDataChannels &channels, size_t max_packet_size, Nanos snapshot_interval,
+                        size_t snapshot_bytes_per_sec, int snapshot_service_port);
 
     ~SnapshotSynthesizer();
 
@@ -29,10 +38,9 @@ namespace Exchange {
     /// Process an incremental market update and update the limit order book snapshot.
     auto addToSnapshot(const MDPMarketUpdate *market_update);
 
-    /// Publish a full snapshot cycle on the snapshot multicast stream.
-    auto publishSnapshot();
 
-    /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot and publishes the snapshot periodically.
+    /// Main method for this thread - processes incremental updates from the market data publisher, updates the snapshot, publishes the snapshot periodically
+    /// and serves snapshot requests.
     auto run() -> void;
 
     /// Deleted default, copy & move constructors and assignment-operators.
@@ -47,6 +55,39 @@ namespace Exchange {
     SnapshotSynthesizer &operator=(const SnapshotSynthesizer &&) = delete;
 
   private:
+    /// Snapshot stream of one market data channel - its multicast socket and the encoder for its frames, the instruments on the channel
+    /// and the last sequence number applied from the channel's incremental stream.
+    struct SnapshotChannel {
+      SnapshotChannel(Logger &logger, size_t max_packet_size)
+          : socket_(logger), encoder_(MARKET_DATA_SCHEMA_ID, MARKET_DATA_SCHEMA_VERSION, mcastMaxFrameSize(max_packet_size)) {
+      }
+
+      McastSocket socket_;
+      WireFrameEncoder encoder_;
+      std::vector<TickerId> ticker_ids_;
+      size_t last_inc_seq_num_ = 0;
+      Nanos last_snapshot_time_ = 0;
+
+      /// Messages of the snapshot cycle in progress, the next one to publish, when the cycle started and how many bytes it has encoded so far.
+      std::vector<MDPMarketUpdate> cycle_updates_;
+      size_t next_cycle_update_ = 0;
+      Nanos cycle_start_time_ = 0;
+      size_t cycle_bytes_ = 0;
+    };
+
+    /// Start a snapshot cycle of the channel by copying the live orders of its instruments, so the cycle stays consistent with last_inc_seq_num_
+    /// while the incremental updates which arrive during it keep being applied.
+    auto startSnapshot(SnapshotChannel *channel) -> void;
+
+    /// Publish the next messages of the channel's snapshot cycle in progress, as many as the pace allows since the cycle started.
+    auto publishSnapshot(SnapshotChannel *channel) -> void;
+
+    /// Callback when snapshot requests are read from a consumer's connection.
+    auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void;
+
+    /// Send the image of the tickers asked for, consistent with last_inc_seq_num_, followed by a WireSnapshotResponse.
+    auto onSnapshotRequest(TCPSocket *socket, const WireSnapshotRequest &request) noexcept -> void;
+
     /// Lock free queue containing incremental market data updates coming in from the market data publisher.
     MDPMarketUpdateLFQueue *snapshot_md_updates_ = nullptr;
 
@@ -56,15 +97,44 @@ namespace Exchange {
 
     std::string time_str_;
 
-    /// Multicast socket for the snapshot multicast stream.
-    McastSocket snapshot_socket_;
+    /// Snapshot stream of every channel indexed by ChannelId, and the channel of every listed instrument indexed by TickerId.
+    /// The encoders put the messages of a cycle in shared frames and packets of up to max_packet_size bytes.
+    std::deque<SnapshotChannel> channels_;
+    std::vector<SnapshotChannel *> ticker_channels_;
+
+    /// Live orders of one instrument, densely stored and sorted by market order id.
+    /// Cancelled orders are left in place with type_ INVALID and compacted away once they outnumber the live ones,
+    /// so lookups are a binary search, adds an append and a snapshot cycle only visits entries which are mostly live.
+    struct SnapshotOrders {
+      std::vector<MEMarketUpdate> orders_;
+      size_t num_live_ = 0;
+    };
+
+    /// Returns the live order with this market order id, or nullptr.
+    auto findOrder(SnapshotOrders *orders, OrderId order_id) noexcept -> MEMarketUpdate *;
+
+    /// Hash map from TickerId -> Full limit order book snapshot containing information for every live order, one entry per listed instrument.
+    std::vector<SnapshotOrders> ticker_orders_;
+
+    /// Fill queue_orders_ with the live orders of the ticker sorted by side, price and priority, the order consumers queue them in at each price.
+    /// It is not the market order id order, a cancel-replace keeps its market order id but goes to the back of its new price with a new priority.
+    auto queueOrders(TickerId ticker_id) noexcept -> const std::vector<MEMarketUpdate> &;
+
+    /// Scratch space for the orders of the ticker being put in a snapshot, sized for the instrument with the most orders.
+    std::vector<MEMarketUpdate> queue_orders_;
+
+    /// Time between the starts of two snapshot cycles of a channel, and the rate in bytes per second at which a channel's cycle is published,
+    /// 0 for no pacing.
+    const Nanos snapshot_interval_;
+    const size_t snapshot_bytes_per_sec_;
+
+    const std::string iface_;
+    const int snapshot_service_port_;
 
-    /// Hash map from TickerId -> Full limit order book snapshot containing information for every live order.
-    std::array<std::array<MEMarketUpdate *, ME_MAX_ORDER_IDS>, ME_MAX_TICKERS> ticker_orders_;
-    size_t last_inc_seq_num_ = 0;
-    Nanos last_snapshot_time_ = 0;
+    /// Encodes the images sent by the snapshot service and its session messages into market data protocol frames.
+    WireFrameEncoder snapshot_service_encoder_;
 
-    /// Memory pool to manage MEMarketUpdate messages for the orders in the snapshot limit order books.
-    MemPool<MEMarketUpdate> order_pool_;
+    /// TCP server which accepts the consumers' snapshot service connections.
+    TCPServer snapshot_service_server_;
   };
 }
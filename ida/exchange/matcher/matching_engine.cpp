@@ -2,11 +2,20 @@
 
 namespace Exchange {
   MatchingEngine::MatchingEngine(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses,
-                                 MEMarketUpdateLFQueue *market_updates)
+                                 MEMarketUpdateLFQueue *market_updates, MEPriceLevelUpdateLFQueue *price_level_updates,
+                                 const InstrumentRegistry *instruments, MECheckpointWriter *checkpoint_writer)
       : incoming_requests_(client_requests), outgoing_ogw_responses_(client_responses), outgoing_md_updates_(market_updates),
-        logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_matching_engine.log") {
-    for(size_t i = 0; i < ticker_order_book_.size(); ++i) {
-      ticker_order_book_[i] = new MEOrderBook(i, &logger_, this);
+        outgoing_price_level_updates_(price_level_updates),
+        checkpoint_writer_(checkpoint_writer), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_matching_engine.log") {
+    cid_num_requests_.fill(0);
+    cid_num_responses_.fill(0);
+
+    // Order books are only created for listed instruments and each is sized for that instrument's max_orders_.
+    ticker_order_book_.resize(instruments->size(), nullptr);
+    for(TickerId ticker_id = 0; ticker_id < ticker_order_book_.size(); ++ticker_id) {
+      const auto &instrument = instruments->at(ticker_id);
+      ticker_order_book_[ticker_id] = new MEOrderBook(ticker_id, instrument.max_orders_, &logger_, this);
+      logger_.log("%:% %() % Listed %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), instrument.toString());
     }
   }
 
@@ -19,6 +28,7 @@ namespace Exchange {
     incoming_requests_ = nullptr;
     outgoing_ogw_responses_ = nullptr;
     outgoing_md_updates_ = nullptr;
+    outgoing_price_level_updates_ = nullptr;
 
     for(auto& order_book : ticker_order_book_) {
       delete order_book;
@@ -35,4 +45,118 @@ namespace Exchange {
   auto MatchingEngine::stop() -> void {
     run_ = false;
   }
+
+  /// Run synthetic add, match, modify and cancel traffic for a shadow client through every order book before the exchange opens, so the code paths,
+  /// memory pools and price levels are hot for the first real client request. Nothing is published and the order books and client sequence numbers
+  /// are reset afterwards, must be called on empty order books before restore() and start().
+  auto MatchingEngine::warmup(size_t num_iterations) noexcept -> void {
+    ASSERT(!num_requests_, "Warmup must run before any client request is processed.");
+
+    // The shadow client uses the reserved ClientId_WARMUP, every order it sends is cancelled or filled against itself by the end of an iteration.
+    constexpr ClientId shadow_client_id = ClientId_WARMUP;
+    constexpr size_t num_warmup_price_levels = 16;
+    constexpr OrderId num_warmup_order_ids = 1024;
+
+    const auto start_time = Common::getCurrentNanos();
+    auto process = [this](const MEClientRequest &client_request) {
+      processClientRequest(&client_request);
+      num_batch_client_responses_ = num_batch_market_updates_ = num_batch_price_level_updates_ = 0;
+    };
+
+    OrderId order_id = 0;
+    for (size_t i = 0; i < num_iterations; ++i) {
+      const Price price = 100 + static_cast<Price>(i % num_warmup_price_levels);
+      for (TickerId ticker_id = 0; ticker_id < ticker_order_book_.size(); ++ticker_id) {
+        const auto buy_id = order_id++ % num_warmup_order_ids, sell_id = order_id++ % num_warmup_order_ids, aggressor_id = order_id++ % num_warmup_order_ids;
+
+        // Rest a bid and an ask, shrink the bid in place, sweep the bid with an aggressive sell which rests its remainder, then cancel what is left.
+        process({ClientRequestType::NEW, shadow_client_id, ticker_id, buy_id, Side::BUY, price, 20, OrderType::LIMIT, TimeInForce::GTC});
+        process({ClientRequestType::NEW, shadow_client_id, ticker_id, sell_id, Side::SELL, price + 1, 20, OrderType::LIMIT, TimeInForce::GTC});
+        process({ClientRequestType::MODIFY, shadow_client_id, ticker_id, buy_id, Side::BUY, price, 10, OrderType::LIMIT, TimeInForce::GTC});
+        process({ClientRequestType::NEW, shadow_client_id, ticker_id, aggressor_id, Side::SELL, price, 15, OrderType::LIMIT, TimeInForce::GTC});
+        process({ClientRequestType::CANCEL, shadow_client_id, ticker_id, sell_id, Side::SELL, price + 1, 0, OrderType::LIMIT, TimeInForce::GTC});
+        process({ClientRequestType::MASS_CANCEL, shadow_client_id, ticker_id, OrderId_INVALID, Side::INVALID, Price_INVALID, Qty_INVALID,
+                 OrderType::LIMIT, TimeInForce::GTC});
+      }
+    }
+
+    // Forget the warmup traffic, the first real order gets market order id 1 and the shadow client starts from sequence number 0.
+    for (auto order_book : ticker_order_book_) {
+      order_book->restore(1, nullptr, 0);
+    }
+    num_requests_ = 0;
+    output_digest_ = ME_OUTPUT_DIGEST_SEED;
+    cid_num_requests_[shadow_client_id] = 0;
+    cid_num_responses_[shadow_client_id] = 0;
+
+    logger_.log("%:% %() % Warmed up % order books with % iterations in % ns.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                ticker_order_book_.size(), num_iterations, Common::getCurrentNanos() - start_time);
+  }
+
+  /// Capture the state of all the order books and client sequence numbers and hand it over to the checkpoint writer.
+  auto MatchingEngine::checkpoint() noexcept -> void {
+    if (!checkpoint_writer_)
+      return;
+
+    auto checkpoint = checkpoint_writer_->beginCapture();
+    if (UNLIKELY(!checkpoint)) {
+      logger_.log("%:% %() % Skipping checkpoint, previous one is still being written.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_));
+      return;
+    }
+
+    checkpoint->header_.journal_records_ = num_requests_;
+    checkpoint->header_.output_digest_ = output_digest_;
+    checkpoint->header_.publish_trade_summaries_ = publish_trade_summaries_;
+    for (size_t client_id = 0; client_id < cid_num_requests_.size(); ++client_id) {
+      checkpoint->clients_.push_back({cid_num_requests_[client_id], cid_num_responses_[client_id]});
+    }
+    for (const auto order_book : ticker_order_book_) {
+      const auto num_orders = checkpoint->orders_.size();
+      order_book->checkpoint(&checkpoint->orders_);
+      checkpoint->books_.push_back({static_cast<TickerId>(checkpoint->books_.size()), order_book->getNextMarketOrderId(),
+                                    checkpoint->orders_.size() - num_orders});
+    }
+
+    checkpoint_writer_->endCapture();
+    logger_.log("%:% %() % Captured checkpoint requests:% orders:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                num_requests_, checkpoint->orders_.size());
+  }
+
+  /// Rebuild the order books and client sequence numbers from a checkpoint, must be called before the matching engine is started.
+  auto MatchingEngine::restore(const MECheckpoint &checkpoint) noexcept -> void {
+    ASSERT(checkpoint.header_.num_clients_ == cid_num_requests_.size(), "Checkpoint was written with a different ME_MAX_NUM_CLIENTS limit.");
+
+    num_requests_ = checkpoint.header_.journal_records_;
+    output_digest_ = checkpoint.header_.output_digest_;
+    for (size_t client_id = 0; client_id < checkpoint.clients_.size(); ++client_id) {
+      cid_num_requests_[client_id] = checkpoint.clients_[client_id].num_requests_;
+      cid_num_responses_[client_id] = checkpoint.clients_[client_id].num_responses_;
+    }
+
+    auto orders = checkpoint.orders_.data();
+    for (const auto &book : checkpoint.books_) {
+      ASSERT(book.ticker_id_ < ticker_order_book_.size(), "Checkpoint has orders for ticker:" + tickerIdToString(book.ticker_id_) + " which is not listed.");
+      ticker_order_book_[book.ticker_id_]->restore(book.next_market_order_id_, orders, book.num_orders_);
+      orders += book.num_orders_;
+    }
+
+    logger_.log("%:% %() % Restored checkpoint requests:% orders:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                num_requests_, checkpoint.orders_.size());
+  }
+
+  /// Publish every resting order of the restored order books as an ADD market update and every price level on the market by price stream,
+  /// one batch per order book so consumers never act on a partially published book.
+  auto MatchingEngine::publishBooks() noexcept -> void {
+    // These updates only repeat the recovered state, they are not generated by a journal record and are left out of the output digest.
+    const auto output_digest = output_digest_;
+    for (auto order_book : ticker_order_book_) {
+      order_book->publishBook();
+      publishBatch();
+    }
+    output_digest_ = output_digest;
+
+    logger_.log("%:% %() % Published % order books\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                ticker_order_book_.size());
+  }
 }
@@ -3,19 +3,26 @@
 #include "common/thread_utils.h"
 #include "common/lf_queue.h"
 #include "common/macros.h"
+#include "common/instrument_registry.h"
 
 #include "order_server/client_request.h"
 #include "order_server/client_response.h"
 #include "market_data/market_update.h"
 
 #include "me_order_book.h"
+#include "me_checkpoint.h"
 
 namespace Exchange {
   class MatchingEngine final {
   public:
+    /// An order book is created for each instrument listed in instruments. checkpoint_writer can be nullptr to disable checkpoints
+    /// and price_level_updates can be nullptr to disable the market by price stream.
     MatchingEngine(ClientRequestLFQueue *client_requests,
                    ClientResponseLFQueue *client_responses,
-                   MEMarketUpdateLFQueue *market_updates);
+                   MEMarketUpdateLFQueue *market_updates,
+                   MEPriceLevelUpdateLFQueue *price_level_updates,
+                   const InstrumentRegistry *instruments,
+                   MECheckpointWriter *checkpoint_writer);
 
     ~MatchingEngine();
 
@@ -26,23 +33,92 @@ namespace Exchange {
 
     /// Called to process a client request read from the lock free queue sent by the order server.
     auto processClientRequest(const MEClientRequest *client_request) noexcept {
-      auto order_book = ticker_order_book_[client_request->ticker_id_];
+      ++num_requests_;
+      // A CANCEL_ON_DISCONNECT is generated by the order server itself and does not use up a client sequence number.
+      if (LIKELY(client_request->client_id_ < cid_num_requests_.size() && client_request->type_ != ClientRequestType::CANCEL_ON_DISCONNECT))
+        ++cid_num_requests_[client_request->client_id_];
+
+      // TickerIds are dense so the order book lookup is a single index, order_book is nullptr for instruments which are not listed.
+      // Only a MASS_CANCEL or CANCEL_ON_DISCONNECT can be sent for TickerId_INVALID, meaning all order books.
+      // A MASS_CANCEL always gets a terminal response, a CANCEL_REJECTED for a ticker which is not listed or a MASS_CANCELED otherwise.
+      // A NEW whose order type, time in force and price do not go together is rejected before it reaches the book, as is a MODIFY with Price_INVALID,
+      // that is what a price equal to the largest value of the wire type decodes to. Only a MARKET order is sent without a price.
+      auto order_book = (LIKELY(client_request->ticker_id_ < ticker_order_book_.size()) ? ticker_order_book_[client_request->ticker_id_] : nullptr);
       switch (client_request->type_) {
         case ClientRequestType::NEW: {
+          if (UNLIKELY(!order_book || halted_ || !isValidNewOrder(client_request->order_type_, client_request->tif_, client_request->price_))) {
+            rejectClientRequest(client_request, ClientResponseType::CANCELED);
+            break;
+          }
           START_MEASURE(Exchange_MEOrderBook_add);
           order_book->add(client_request->client_id_, client_request->order_id_, client_request->ticker_id_,
-                           client_request->side_, client_request->price_, client_request->qty_);
+                           client_request->side_, client_request->price_, client_request->qty_,
+                           client_request->order_type_, client_request->tif_);
           END_MEASURE(Exchange_MEOrderBook_add, logger_);
         }
           break;
 
         case ClientRequestType::CANCEL: {
+          if (UNLIKELY(!order_book)) {
+            rejectClientRequest(client_request, ClientResponseType::CANCEL_REJECTED);
+            break;
+          }
           START_MEASURE(Exchange_MEOrderBook_cancel);
           order_book->cancel(client_request->client_id_, client_request->order_id_, client_request->ticker_id_);
           END_MEASURE(Exchange_MEOrderBook_cancel, logger_);
         }
           break;
 
+        case ClientRequestType::MODIFY: {
+          if (UNLIKELY(!order_book || halted_ || client_request->price_ == Price_INVALID)) {
+            rejectClientRequest(client_request, ClientResponseType::MODIFY_REJECTED);
+            break;
+          }
+          START_MEASURE(Exchange_MEOrderBook_modify);
+          order_book->modify(client_request->client_id_, client_request->order_id_, client_request->ticker_id_,
+                             client_request->price_, client_request->qty_);
+          END_MEASURE(Exchange_MEOrderBook_modify, logger_);
+        }
+          break;
+
+        case ClientRequestType::MASS_CANCEL:
+        case ClientRequestType::CANCEL_ON_DISCONNECT: {
+          if (UNLIKELY(!order_book && client_request->ticker_id_ != TickerId_INVALID)) {
+            if (client_request->type_ == ClientRequestType::MASS_CANCEL)
+              rejectClientRequest(client_request, ClientResponseType::CANCEL_REJECTED);
+            break;
+          }
+          START_MEASURE(Exchange_MEOrderBook_massCancel);
+          size_t num_cancelled = 0;
+          if (order_book) {
+            num_cancelled = order_book->massCancel(client_request->client_id_, client_request->side_);
+          } else {
+            for (auto book : ticker_order_book_) {
+              num_cancelled += book->massCancel(client_request->client_id_, client_request->side_);
+            }
+          }
+          END_MEASURE(Exchange_MEOrderBook_massCancel, logger_);
+
+          // The client is gone after a CANCEL_ON_DISCONNECT, its orders' CANCELED responses are only kept for when it reconnects.
+          if (client_request->type_ == ClientRequestType::MASS_CANCEL) {
+            const MEClientResponse client_response{ClientResponseType::MASS_CANCELED, client_request->client_id_, client_request->ticker_id_,
+                                                   client_request->order_id_, OrderId_INVALID, client_request->side_, Price_INVALID,
+                                                   static_cast<Qty>(num_cancelled), Qty_INVALID};
+            sendClientResponse(&client_response);
+          }
+        }
+          break;
+
+        case ClientRequestType::HALT: {
+          // Only honoured from the order server, one sent by a client uses up its sequence number and is ignored.
+          if (client_request->client_id_ == ClientId_INVALID) {
+            logger_.log("%:% %() % Halted, rejecting NEW and MODIFY requests from now on.\n", __FILE__, __LINE__, __FUNCTION__,
+                        Common::getCurrentTimeStr(&time_str_));
+            halted_ = true;
+          }
+        }
+          break;
+
         default: {
           FATAL("Received invalid client-request-type:" + clientRequestTypeToString(client_request->type_));
         }
@@ -50,22 +126,172 @@ namespace Exchange {
       }
     }
 
-    /// Write client responses to the lock free queue for the order server to consume.
-    auto sendClientResponse(const MEClientResponse *client_response) noexcept {
-      logger_.log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), client_response->toString());
-      auto next_write = outgoing_ogw_responses_->getNextToWriteTo();
-      *next_write = std::move(*client_response);
-      outgoing_ogw_responses_->updateWriteIndex();
+    /// Write all buffered client responses to the lock free queue for the order server to consume and publish them with a single write index update.
+    /// The last response is flagged as the end of the batch if end_of_batch is set.
+    auto publishClientResponses(bool end_of_batch) noexcept -> void {
+      if (!num_batch_client_responses_)
+        return;
+
+      batch_client_responses_[num_batch_client_responses_ - 1].last_in_batch_ = end_of_batch;
+      for (size_t i = 0; i < num_batch_client_responses_; ++i) {
+        *outgoing_ogw_responses_->getNextToWriteTo(i) = batch_client_responses_[i];
+      }
+      outgoing_ogw_responses_->updateWriteIndex(num_batch_client_responses_);
       TTT_MEASURE(T4t_MatchingEngine_LFQueue_write, logger_);
+
+      num_batch_client_responses_ = 0;
     }
 
-    /// Write market data update to the lock free queue for the market data publisher to consume.
-    auto sendMarketUpdate(const MEMarketUpdate *market_update) noexcept {
-      logger_.log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), market_update->toString());
-      auto next_write = outgoing_md_updates_->getNextToWriteTo();
-      *next_write = *market_update;
-      outgoing_md_updates_->updateWriteIndex();
+    /// Write all buffered market updates to the lock free queue for the market data publisher to consume and publish them with a single write index update.
+    /// The last update is flagged as the end of the batch if end_of_batch is set, so consumers never act on a partially updated book.
+    auto publishMarketUpdates(bool end_of_batch) noexcept -> void {
+      if (!num_batch_market_updates_)
+        return;
+
+      // Only publishing the restored order books on startup can outrun the market data publisher, wait for it rather than overwrite unread updates.
+      while (UNLIKELY(outgoing_md_updates_->size() + num_batch_market_updates_ > outgoing_md_updates_->capacity()));
+
+      batch_market_updates_[num_batch_market_updates_ - 1].last_in_batch_ = end_of_batch;
+      for (size_t i = 0; i < num_batch_market_updates_; ++i) {
+        *outgoing_md_updates_->getNextToWriteTo(i) = batch_market_updates_[i];
+      }
+      outgoing_md_updates_->updateWriteIndex(num_batch_market_updates_);
       TTT_MEASURE(T4_MatchingEngine_LFQueue_write, logger_);
+
+      num_batch_market_updates_ = 0;
+    }
+
+    /// Write all buffered price level updates to the lock free queue for the market data publisher to consume and publish them with a single write index update.
+    auto publishPriceLevelUpdates(bool end_of_batch) noexcept -> void {
+      if (!num_batch_price_level_updates_)
+        return;
+
+      while (UNLIKELY(outgoing_price_level_updates_->size() + num_batch_price_level_updates_ > outgoing_price_level_updates_->capacity()));
+
+      batch_price_level_updates_[num_batch_price_level_updates_ - 1].last_in_batch_ = end_of_batch;
+      for (size_t i = 0; i < num_batch_price_level_updates_; ++i) {
+        *outgoing_price_level_updates_->getNextToWriteTo(i) = batch_price_level_updates_[i];
+      }
+      outgoing_price_level_updates_->updateWriteIndex(num_batch_price_level_updates_);
+
+      num_batch_price_level_updates_ = 0;
+    }
+
+    /// Buffer a client response generated while processing the current client request, published to the order server by publishBatch().
+    auto sendClientResponse(const MEClientResponse *client_response) noexcept -> void {
+      if (UNLIKELY(num_batch_client_responses_ == batch_client_responses_.size())) { // very large sweep, publish what we have so far without a batch boundary.
+        publishClientResponses(false);
+      }
+      batch_client_responses_[num_batch_client_responses_++] = *client_response;
+      digestOutput(*client_response);
+
+      if (LIKELY(client_response->client_id_ < cid_num_responses_.size()))
+        ++cid_num_responses_[client_response->client_id_];
+    }
+
+    /// Buffer a market update generated while processing the current client request, published to the market data publisher by publishBatch().
+    auto sendMarketUpdate(const MEMarketUpdate *market_update) noexcept {
+      if (UNLIKELY(num_batch_market_updates_ == batch_market_updates_.size())) {
+        publishMarketUpdates(false);
+      }
+      batch_market_updates_[num_batch_market_updates_++] = *market_update;
+      digestOutput(*market_update);
+    }
+
+    /// Buffer a price level update generated while processing the current client request, published to the market data publisher by publishBatch().
+    /// Consecutive updates for the same price level, e.g. an aggressive order sweeping all the orders at a level, are conflated into the last one.
+    auto sendPriceLevelUpdate(const MEPriceLevelUpdate *price_level_update) noexcept {
+      if (!outgoing_price_level_updates_)
+        return;
+
+      if (num_batch_price_level_updates_) {
+        auto &last_update = batch_price_level_updates_[num_batch_price_level_updates_ - 1];
+        if (last_update.price_ == price_level_update->price_ && last_update.side_ == price_level_update->side_ &&
+            last_update.ticker_id_ == price_level_update->ticker_id_) {
+          last_update = *price_level_update;
+          return;
+        }
+      }
+
+      if (UNLIKELY(num_batch_price_level_updates_ == batch_price_level_updates_.size())) {
+        publishPriceLevelUpdates(false);
+      }
+      batch_price_level_updates_[num_batch_price_level_updates_++] = *price_level_update;
+    }
+
+    /// Respond to a client request for an instrument which is not listed, with an invalid price, order type or time in force or received after a HALT,
+    /// a NEW order is CANCELED right away without resting or matching and a MASS_CANCEL is CANCEL_REJECTED.
+    auto rejectClientRequest(const MEClientRequest *client_request, ClientResponseType type) noexcept -> void {
+      logger_.log("%:% %() % Rejecting % halted:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  client_request->toString(), halted_);
+      const MEClientResponse client_response{type, client_request->client_id_, client_request->ticker_id_, client_request->order_id_, OrderId_INVALID,
+                                             client_request->side_, client_request->price_, Qty_INVALID, client_request->qty_};
+      sendClientResponse(&client_response);
+    }
+
+    /// Publish all client responses, market updates and price level updates generated by a single client request as one batch.
+    auto publishBatch() noexcept {
+      logger_.log("%:% %() % Publishing responses:% updates:% levels:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  num_batch_client_responses_, num_batch_market_updates_, num_batch_price_level_updates_);
+      publishClientResponses(true);
+      publishMarketUpdates(true);
+      publishPriceLevelUpdates(true);
+    }
+
+    /// Process a client request read from the journal on startup, the responses and updates were already published before the restart so they are dropped.
+    auto replayClientRequest(const MEClientRequest *client_request) noexcept {
+      processClientRequest(client_request);
+      num_batch_client_responses_ = num_batch_market_updates_ = num_batch_price_level_updates_ = 0;
+    }
+
+    /// Publish a TRADE_SUMMARY ahead of the per order updates for every aggressive order which matches, disabled by default and must be set before start().
+    auto setPublishTradeSummaries(bool publish_trade_summaries) noexcept {
+      publish_trade_summaries_ = publish_trade_summaries;
+    }
+
+    auto publishTradeSummaries() const noexcept {
+      return publish_trade_summaries_;
+    }
+
+    /// Ask the matching engine thread to capture a checkpoint after the client request it is currently processing.
+    auto requestCheckpoint() noexcept {
+      checkpoint_requested_ = true;
+    }
+
+    /// Capture the state of all the order books and client sequence numbers and hand it over to the checkpoint writer.
+    /// Copies every resting order, the matching engine thread does not match anything meanwhile - see checkpoint_benchmark.
+    auto checkpoint() noexcept -> void;
+
+    /// Rebuild the order books and client sequence numbers from a checkpoint, must be called before the matching engine is started.
+    auto restore(const MECheckpoint &checkpoint) noexcept -> void;
+
+    /// Publish every resting order of the restored order books as an ADD market update and every price level on the market by price stream,
+    /// so the snapshot synthesizer, the book publishers and consumers start from the recovered books rather than empty ones.
+    /// Must be called after restore() and the journal replay, once the market data publisher is running and before start().
+    auto publishBooks() noexcept -> void;
+
+    /// Run synthetic add, match, modify and cancel traffic for a shadow client through every order book before the exchange opens, so the code paths,
+    /// memory pools and price levels are hot for the first real client request. Nothing is published and the order books and client sequence numbers
+    /// are reset afterwards, must be called on empty order books before restore() and start().
+    auto warmup(size_t num_iterations) noexcept -> void;
+
+    /// Number of client requests processed so far, which is also the number of journal records covered by the current state.
+    auto getNumRequests() const noexcept {
+      return num_requests_;
+    }
+
+    /// Digest of all the client responses and market updates generated for the client requests processed so far, the same journal always gives the same digest.
+    auto getOutputDigest() const noexcept {
+      return output_digest_;
+    }
+
+    /// Number of client requests processed for and client responses generated for the client, used to resume the order server sequence numbers.
+    auto getNumClientRequests(ClientId client_id) const noexcept {
+      return cid_num_requests_.at(client_id);
+    }
+
+    auto getNumClientResponses(ClientId client_id) const noexcept {
+      return cid_num_responses_.at(client_id);
     }
 
     /// Main loop for this thread - processes incoming client requests which in turn generates client responses and market updates.
@@ -81,6 +307,17 @@ namespace Exchange {
           START_MEASURE(Exchange_MatchingEngine_processClientRequest);
           processClientRequest(me_client_request);
           END_MEASURE(Exchange_MatchingEngine_processClientRequest, logger_);
+
+          START_MEASURE(Exchange_MatchingEngine_publishBatch);
+          publishBatch();
+          END_MEASURE(Exchange_MatchingEngine_publishBatch, logger_);
+
+          if (UNLIKELY(checkpoint_requested_)) { // between two client requests, so the order books are a consistent cut.
+            checkpoint_requested_ = false;
+            START_MEASURE(Exchange_MatchingEngine_checkpoint);
+            checkpoint();
+            END_MEASURE(Exchange_MatchingEngine_checkpoint, logger_);
+          }
           incoming_requests_->updateReadIndex();
         }
       }
@@ -98,7 +335,7 @@ namespace Exchange {
     MatchingEngine &operator=(const MatchingEngine &&) = delete;
 
   private:
-    /// Hash map container from TickerId -> MEOrderBook.
+    /// Hash map container from TickerId -> MEOrderBook, one order book per listed instrument.
     OrderBookHashMap ticker_order_book_;
 
     /// Lock free queues.
@@ -109,6 +346,47 @@ namespace Exchange {
     ClientResponseLFQueue *outgoing_ogw_responses_ = nullptr;
     MEMarketUpdateLFQueue *outgoing_md_updates_ = nullptr;
 
+    /// Publishes outgoing price level updates for the market by price stream, nullptr if the stream is disabled.
+    MEPriceLevelUpdateLFQueue *outgoing_price_level_updates_ = nullptr;
+
+    /// Client responses and market updates generated by the client request currently being processed, waiting to be published as one batch.
+    std::array<MEClientResponse, ME_MAX_BATCH_EVENTS> batch_client_responses_;
+    size_t num_batch_client_responses_ = 0;
+    std::array<MEMarketUpdate, ME_MAX_BATCH_EVENTS> batch_market_updates_;
+    size_t num_batch_market_updates_ = 0;
+    std::array<MEPriceLevelUpdate, ME_MAX_BATCH_EVENTS> batch_price_level_updates_;
+    size_t num_batch_price_level_updates_ = 0;
+
+    /// Set if aggressive orders also publish a TRADE_SUMMARY market update.
+    bool publish_trade_summaries_ = false;
+
+    /// Set by a HALT from the order server, NEW and MODIFY requests are rejected from then on.
+    bool halted_ = false;
+
+    /// Running digest of every client response and market update generated, see digestOutput().
+    uint64_t output_digest_ = ME_OUTPUT_DIGEST_SEED;
+
+    /// Fold a client response or market update into output_digest_ 8 bytes at a time, FNV-1a over words instead of bytes to keep it cheap on the hot path.
+    /// The structures are packed so there is no padding with unspecified contents, and last_in_batch_ is still unset when they are generated.
+    template<typename T>
+    auto digestOutput(const T &output) noexcept -> void {
+      const auto bytes = reinterpret_cast<const char *>(&output);
+      for (size_t i = 0; i < sizeof(T); i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        memcpy(&word, bytes + i, std::min(sizeof(uint64_t), sizeof(T) - i));
+        output_digest_ = (output_digest_ ^ word) * 1099511628211ull;
+      }
+    }
+
+    /// Counts of client requests processed in total and per client, and client responses generated per client.
+    size_t num_requests_ = 0;
+    std::array<size_t, ME_MAX_NUM_CLIENTS> cid_num_requests_;
+    std::array<size_t, ME_MAX_NUM_CLIENTS> cid_num_responses_;
+
+    /// Writes checkpoints captured by this thread to disk, nullptr if checkpoints are disabled.
+    MECheckpointWriter *checkpoint_writer_ = nullptr;
+    volatile bool checkpoint_requested_ = false;
+
     volatile bool run_ = false;
 
     std::string time_str_;
@@ -0,0 +1,123 @@
+#include "me_checkpoint.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace Exchange {
+  /// Read exactly len bytes or fail.
+  static auto readAll(int fd, void *data, size_t len) {
+    auto ptr = reinterpret_cast<char *>(data);
+    while (len) {
+      const auto n = read(fd, ptr, len);
+      if (n <= 0)
+        return false;
+      ptr += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  /// Write exactly len bytes or fail.
+  static auto writeAll(int fd, const void *data, size_t len) {
+    auto ptr = reinterpret_cast<const char *>(data);
+    while (len) {
+      const auto n = ::write(fd, ptr, len);
+      if (n <= 0)
+        return false;
+      ptr += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  /// Read the checkpoint file into the provided checkpoint, returns false if there is no checkpoint file.
+  auto readCheckpoint(const std::string &file_name, MECheckpoint *checkpoint) -> bool {
+    const auto fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    auto &header = checkpoint->header_;
+    ASSERT(readAll(fd, &header, sizeof(header)) && header.magic_ == ME_CHECKPOINT_MAGIC, "Not a checkpoint file:" + file_name);
+
+    checkpoint->clients_.resize(header.num_clients_);
+    checkpoint->books_.resize(header.num_tickers_);
+    checkpoint->orders_.resize(header.num_orders_);
+    ASSERT(readAll(fd, checkpoint->clients_.data(), header.num_clients_ * sizeof(MECheckpointClient)) &&
+           readAll(fd, checkpoint->books_.data(), header.num_tickers_ * sizeof(MECheckpointBook)) &&
+           readAll(fd, checkpoint->orders_.data(), header.num_orders_ * sizeof(MECheckpointOrder)), "Truncated checkpoint file:" + file_name);
+
+    close(fd);
+    return true;
+  }
+
+  MECheckpointWriter::MECheckpointWriter(const std::string &file_name, const MEJournal *journal)
+      : file_name_(file_name), journal_(journal), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_checkpoint.log") {
+    // Reserve enough up front that capturing a typical book on the matching engine thread does not reallocate.
+    checkpoint_.clients_.reserve(ME_MAX_NUM_CLIENTS);
+    checkpoint_.books_.reserve(ME_DEFAULT_NUM_TICKERS);
+    checkpoint_.orders_.reserve(ME_MAX_ORDER_IDS);
+  }
+
+  MECheckpointWriter::~MECheckpointWriter() {
+    stop();
+    if (writer_thread_) {
+      writer_thread_->join();
+      delete writer_thread_;
+      writer_thread_ = nullptr;
+    }
+  }
+
+  /// Start and stop the checkpoint writer thread.
+  auto MECheckpointWriter::start() -> void {
+    run_ = true;
+    writer_thread_ = Common::createAndStartThread(-1, "Exchange/MECheckpointWriter", [this]() { run(); });
+    ASSERT(writer_thread_ != nullptr, "Failed to start MECheckpointWriter thread.");
+  }
+
+  auto MECheckpointWriter::stop() -> void {
+    run_ = false;
+  }
+
+  auto MECheckpointWriter::write() noexcept -> void {
+    const auto start = Common::getCurrentNanos();
+    const auto tmp_file_name = file_name_ + ".tmp";
+
+    const auto fd = open(tmp_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      logger_.log("%:% %() % Unable to open:% error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  tmp_file_name, std::strerror(errno));
+      return;
+    }
+
+    const auto &header = checkpoint_.header_;
+    const auto written = writeAll(fd, &header, sizeof(header)) &&
+                         writeAll(fd, checkpoint_.clients_.data(), header.num_clients_ * sizeof(MECheckpointClient)) &&
+                         writeAll(fd, checkpoint_.books_.data(), header.num_tickers_ * sizeof(MECheckpointBook)) &&
+                         writeAll(fd, checkpoint_.orders_.data(), header.num_orders_ * sizeof(MECheckpointOrder)) &&
+                         fsync(fd) == 0;
+    close(fd);
+
+    if (!written || rename(tmp_file_name.c_str(), file_name_.c_str()) != 0) {
+      logger_.log("%:% %() % Unable to write:% error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  file_name_, std::strerror(errno));
+      return;
+    }
+
+    logger_.log("%:% %() % Wrote checkpoint:% journal_records:% orders:% in % nanos\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), file_name_, header.journal_records_, header.num_orders_, Common::getCurrentNanos() - start);
+  }
+
+  /// Main loop for the writer thread - writes out the checkpoint whenever one has been captured and the journal has synced the records it covers.
+  auto MECheckpointWriter::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+    while (run_) {
+      if (pending_ && (!journal_ || journal_->getNumSynced() >= checkpoint_.header_.journal_records_)) {
+        write();
+        pending_ = false;
+      }
+
+      using namespace std::literals::chrono_literals;
+      std::this_thread::sleep_for(10ms);
+    }
+  }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/thread_utils.h"
+#include "common/macros.h"
+#include "common/logging.h"
+#include "common/types.h"
+
+#include "order_server/me_journal.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Identifies a valid checkpoint file, and the version of the layout it was written with.
+  constexpr uint64_t ME_CHECKPOINT_MAGIC = 0x544e50434b454d32; // "2MEKCPNT"
+
+  /// Initial value of the digest of all the client responses and market updates generated by the matching engine.
+  constexpr uint64_t ME_OUTPUT_DIGEST_SEED = 14695981039346656037ull;
+
+  /// These structures are written to disk, so the binary structures are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+  /// Header at the start of the checkpoint file, followed by num_clients_ MECheckpointClient, num_tickers_ MECheckpointBook and num_orders_ MECheckpointOrder.
+  struct MECheckpointHeader {
+    uint64_t magic_ = ME_CHECKPOINT_MAGIC;
+
+    /// Number of journal records, i.e. sequenced client requests, which had been processed by the matching engine when this checkpoint was taken.
+    uint64_t journal_records_ = 0;
+
+    /// Digest of all the client responses and market updates generated for those journal records, which a replay of the journal has to reproduce.
+    uint64_t output_digest_ = ME_OUTPUT_DIGEST_SEED;
+
+    /// Whether the matching engine published TRADE_SUMMARY market updates, which is part of the outputs the digest covers.
+    uint8_t publish_trade_summaries_ = 0;
+
+    uint64_t num_clients_ = 0;
+    uint64_t num_tickers_ = 0;
+    uint64_t num_orders_ = 0;
+  };
+
+  /// Per client counts, which are the last used sequence numbers on the order server connection.
+  struct MECheckpointClient {
+    uint64_t num_requests_ = 0;
+    uint64_t num_responses_ = 0;
+  };
+
+  /// Per order book state, its orders follow the previous book's orders.
+  struct MECheckpointBook {
+    TickerId ticker_id_ = TickerId_INVALID;
+    OrderId next_market_order_id_ = OrderId_INVALID;
+    uint64_t num_orders_ = 0;
+  };
+
+  /// A single resting order. Orders of a book are stored bids then asks, from the best price level to the worst and in FIFO order within a level.
+  struct MECheckpointOrder {
+    ClientId client_id_ = ClientId_INVALID;
+    OrderId client_order_id_ = OrderId_INVALID;
+    OrderId market_order_id_ = OrderId_INVALID;
+    Side side_ = Side::INVALID;
+    Price price_ = Price_INVALID;
+    Qty qty_ = Qty_INVALID;
+    Priority priority_ = Priority_INVALID;
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  /// In memory representation of a checkpoint.
+  struct MECheckpoint {
+    MECheckpointHeader header_;
+    std::vector<MECheckpointClient> clients_;
+    std::vector<MECheckpointBook> books_;
+    std::vector<MECheckpointOrder> orders_;
+  };
+
+  /// Read the checkpoint file into the provided checkpoint, returns false if there is no checkpoint file.
+  auto readCheckpoint(const std::string &file_name, MECheckpoint *checkpoint) -> bool;
+
+  /// Writes checkpoints captured by the matching engine to disk on a background thread.
+  /// The matching engine fills in the checkpoint returned by beginCapture() between two client requests, which makes it a consistent cut,
+  /// and hands it over with endCapture(). The file is written to a temporary file and renamed so a crash never leaves a partial checkpoint.
+  /// A checkpoint is only written once the journal has synced every record it covers, so it is never ahead of the journal a restart replays.
+  class MECheckpointWriter final {
+  public:
+    /// journal can be nullptr if client requests are not journaled.
+    MECheckpointWriter(const std::string &file_name, const MEJournal *journal);
+
+    ~MECheckpointWriter();
+
+    /// Start and stop the checkpoint writer thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Returns the checkpoint to fill in, or nullptr if the previous checkpoint is still being written.
+    auto beginCapture() noexcept -> MECheckpoint * {
+      if (UNLIKELY(pending_))
+        return nullptr;
+
+      checkpoint_.clients_.clear();
+      checkpoint_.books_.clear();
+      checkpoint_.orders_.clear();
+      return &checkpoint_;
+    }
+
+    /// Hand over the checkpoint filled in since beginCapture() to the writer thread.
+    auto endCapture() noexcept {
+      checkpoint_.header_.num_clients_ = checkpoint_.clients_.size();
+      checkpoint_.header_.num_tickers_ = checkpoint_.books_.size();
+      checkpoint_.header_.num_orders_ = checkpoint_.orders_.size();
+      pending_ = true;
+    }
+
+    /// Main loop for the writer thread - writes out the checkpoint whenever one has been captured and the journal has synced the records it covers.
+    auto run() noexcept -> void;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    MECheckpointWriter() = delete;
+
+    MECheckpointWriter(const MECheckpointWriter &) = delete;
+
+    MECheckpointWriter(const MECheckpointWriter &&) = delete;
+
+    MECheckpointWriter &operator=(const MECheckpointWriter &) = delete;
+
+    MECheckpointWriter &operator=(const MECheckpointWriter &&) = delete;
+
+  private:
+    const std::string file_name_;
+    const MEJournal *journal_ = nullptr;
+
+    /// Checkpoint being captured or written, owned by the matching engine thread while pending_ is false and by the writer thread otherwise.
+    MECheckpoint checkpoint_;
+    std::atomic<bool> pending_ = {false};
+
+    volatile bool run_ = false;
+    std::thread *writer_thread_ = nullptr;
+
+    std::string time_str_;
+    Logger logger_;
+
+    auto write() noexcept -> void;
+  };
+}
@@ -22,6 +22,10 @@ namespace Exchange {
     MEOrder *prev_order_ = nullptr;
     MEOrder *next_order_ = nullptr;
 
+    /// MEOrder is also a node in a null terminated doubly linked list of all orders for this client and side in the order book, used by mass cancels.
+    MEOrder *prev_client_order_ = nullptr;
+    MEOrder *next_client_order_ = nullptr;
+
     /// Only needed for use with MemPool.
     MEOrder() = default;
 
@@ -39,6 +43,9 @@ namespace Exchange {
   /// Hash map from ClientId -> OrderId -> MEOrder.
   typedef std::array<OrderHashMap, ME_MAX_NUM_CLIENTS> ClientOrderHashMap;
 
+  /// Hash map from ClientId -> Side -> first MEOrder in the list of the client's orders on that side.
+  typedef std::array<std::array<MEOrder *, sideToIndex(Side::MAX) + 1>, ME_MAX_NUM_CLIENTS> ClientSideOrdersHashMap;
+
   /// Used by the matching engine to represent a price level in the limit order book.
   /// Internally maintains a list of MEOrder objects arranged in FIFO order.
   struct MEOrdersAtPrice {
@@ -47,6 +54,12 @@ namespace Exchange {
 
     MEOrder *first_me_order_ = nullptr;
 
+    /// Total quantity across all orders at this price level, lets us check available liquidity without walking the orders.
+    Qty qty_ = 0;
+
+    /// Number of orders at this price level, published with qty_ on the market by price stream.
+    uint32_t num_orders_ = 0;
+
     /// MEOrdersAtPrice also serves as a node in a doubly linked list of price levels arranged in order from most aggressive to least aggressive price.
     MEOrdersAtPrice *prev_entry_ = nullptr;
     MEOrdersAtPrice *next_entry_ = nullptr;
@@ -63,6 +76,8 @@ namespace Exchange {
          << "side:" << sideToString(side_) << " "
          << "price:" << priceToString(price_) << " "
          << "first_me_order:" << (first_me_order_ ? first_me_order_->toString() : "null") << " "
+         << "qty:" << qtyToString(qty_) << " "
+         << "orders:" << num_orders_ << " "
          << "prev:" << priceToString(prev_entry_ ? prev_entry_->price_ : Price_INVALID) << " "
          << "next:" << priceToString(next_entry_ ? next_entry_->price_ : Price_INVALID) << "]";
 
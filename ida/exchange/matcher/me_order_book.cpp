@@ -3,18 +3,26 @@
 #include "matcher/matching_engine.h"
 
 namespace Exchange {
-  MEOrderBook::MEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine)
-      : ticker_id_(ticker_id), matching_engine_(matching_engine), orders_at_price_pool_(ME_MAX_PRICE_LEVELS), order_pool_(ME_MAX_ORDER_IDS),
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::BasicMEOrderBook(TickerId ticker_id, size_t max_orders, Logger *logger,
+                                                                     MatchingEngine *matching_engine)
+      : ticker_id_(ticker_id), matching_engine_(matching_engine), cid_oid_to_order_(max_orders), orders_at_price_pool_(ME_MAX_PRICE_LEVELS), order_pool_(max_orders),
         logger_(logger) {
+    for (auto &itr: cid_side_orders_) {
+      itr.fill(nullptr);
+    }
   }
 
-  MEOrderBook::~MEOrderBook() {
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::~BasicMEOrderBook() {
     logger_->log("%:% %() % OrderBook\n%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                 toString(false, true));
 
     matching_engine_ = nullptr;
     bids_by_price_ = asks_by_price_ = nullptr;
-    for (auto &itr: cid_oid_to_order_) {
+    cid_oid_to_order_.clear();
+    price_orders_at_price_.clear();
+    for (auto &itr: cid_side_orders_) {
       itr.fill(nullptr);
     }
   }
@@ -22,13 +30,15 @@ namespace Exchange {
   /// Match a new aggressive order with the provided parameters against a passive order held in the bid_itr object and generate client responses and market updates for the match.
   /// It will update the passive order (bid_itr) based on the match and possibly remove it if fully matched.
   /// It will return remaining quantity on the aggressive order in the leaves_qty parameter.
-  auto MEOrderBook::match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, MEOrder* itr, Qty* leaves_qty) noexcept {
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id, OrderId new_market_order_id, MEOrder* itr, Qty* leaves_qty) noexcept {
     const auto order = itr;
     const auto order_qty = order->qty_;
     const auto fill_qty = std::min(*leaves_qty, order_qty);
 
     *leaves_qty -= fill_qty;
     order->qty_ -= fill_qty;
+    getOrdersAtPrice(order->price_)->qty_ -= fill_qty;
 
     client_response_ = {ClientResponseType::FILLED, client_id, ticker_id, client_order_id,
                         new_market_order_id, side, itr->price_, fill_qty, *leaves_qty};
@@ -41,6 +51,8 @@ namespace Exchange {
     market_update_ = {MarketUpdateType::TRADE, OrderId_INVALID, ticker_id, side, itr->price_, fill_qty, Priority_INVALID};
     matching_engine_->sendMarketUpdate(&market_update_);
 
+    const auto order_side = order->side_;
+    const auto order_price = order->price_;
     if (!order->qty_) {
       market_update_ = {MarketUpdateType::CANCEL, order->market_order_id_, ticker_id, order->side_,
                         order->price_, order_qty, Priority_INVALID};
@@ -54,17 +66,36 @@ namespace Exchange {
                         order->price_, order->qty_, order->priority_};
       matching_engine_->sendMarketUpdate(&market_update_);
     }
+    sendPriceLevelUpdate(order_side, order_price);
   }
 
   /// Check if a new order with the provided attributes would match against existing passive orders on the other side of the order book.
   /// This will call the match() method to perform the match if there is a match to be made and return the quantity remaining if any on this new order.
-  auto MEOrderBook::checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty, Qty new_market_order_id) noexcept {
+  /// MARKET, POST_ONLY, IOC and FOK orders are fully handled here and never return a quantity to be inserted in the book, any unmatched quantity is cancelled.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty, Qty new_market_order_id,
+                                OrderType order_type, TimeInForce tif) noexcept {
     auto leaves_qty = qty;
 
+    // A POST_ONLY order never takes liquidity and a FOK order matches its full quantity or nothing at all.
+    const auto must_cancel = (order_type == OrderType::POST_ONLY ? isAggressive(side, price) :
+                              (tif == TimeInForce::FOK && !canMatchFully(side, price, qty, order_type)));
+    if (UNLIKELY(must_cancel)) {
+      client_response_ = {ClientResponseType::CANCELED, client_id, ticker_id, client_order_id, new_market_order_id,
+                          side, price, Qty_INVALID, leaves_qty};
+      matching_engine_->sendClientResponse(&client_response_);
+      return Qty{0};
+    }
+
+    const auto is_market = (order_type == OrderType::MARKET);
+    if (UNLIKELY(matching_engine_->publishTradeSummaries())) {
+      sendTradeSummary(side, price, leaves_qty, is_market, !is_market && tif == TimeInForce::GTC);
+    }
+
     if (side == Side::BUY) {
       while (leaves_qty && asks_by_price_) {
         const auto ask_itr = asks_by_price_->first_me_order_;
-        if (LIKELY(price < ask_itr->price_)) {
+        if (LIKELY(!is_market && price < ask_itr->price_)) {
           break;
         }
 
@@ -76,7 +107,7 @@ namespace Exchange {
     if (side == Side::SELL) {
       while (leaves_qty && bids_by_price_) {
         const auto bid_itr = bids_by_price_->first_me_order_;
-        if (LIKELY(price > bid_itr->price_)) {
+        if (LIKELY(!is_market && price > bid_itr->price_)) {
           break;
         }
 
@@ -86,18 +117,84 @@ namespace Exchange {
       }
     }
 
+    if (UNLIKELY(leaves_qty && (is_market || tif != TimeInForce::GTC))) { // MARKET and IOC orders never rest, cancel the unmatched quantity.
+      client_response_ = {ClientResponseType::CANCELED, client_id, ticker_id, client_order_id, new_market_order_id,
+                          side, price, Qty_INVALID, leaves_qty};
+      matching_engine_->sendClientResponse(&client_response_);
+      leaves_qty = 0;
+    }
+
     return leaves_qty;
   }
 
+  /// Publish the total quantity and number of orders at the price level on the market by price stream, called after every change to the price level.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::sendPriceLevelUpdate(Side side, Price price) noexcept -> void {
+    const auto orders_at_price = getOrdersAtPrice(price);
+    if (orders_at_price && orders_at_price->price_ == price) {
+      price_level_update_ = {ticker_id_, side, price, orders_at_price->qty_, orders_at_price->num_orders_};
+    } else { // the last order at this price was removed.
+      price_level_update_ = {ticker_id_, side, price, 0, 0};
+    }
+    matching_engine_->sendPriceLevelUpdate(&price_level_update_);
+  }
+
+  /// Publish a TRADE_SUMMARY for an aggressive order about to match, computed from the price level totals before any passive order is touched.
+  /// Matching takes every price level in turn until the order is filled or the price no longer crosses, so walking the levels gives the exact result.
+  /// rests is set if the quantity left unmatched is added to the book.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::sendTradeSummary(Side side, Price price, Qty qty, bool is_market, bool rests) noexcept -> void {
+    const auto best_orders_by_price = (side == Side::BUY ? asks_by_price_ : bids_by_price_);
+    Qty traded_qty = 0;
+    uint64_t notional = 0;
+    uint64_t num_levels = 0;
+    auto new_best_price = Price_INVALID;
+    for (auto orders_at_price = best_orders_by_price; orders_at_price; ) {
+      if (!is_market && (side == Side::BUY ? price < orders_at_price->price_ : price > orders_at_price->price_)) {
+        new_best_price = orders_at_price->price_;
+        break;
+      }
+
+      const auto level_qty = std::min(orders_at_price->qty_, static_cast<Qty>(qty - traded_qty));
+      traded_qty += level_qty;
+      notional += static_cast<uint64_t>(orders_at_price->price_) * level_qty;
+      ++num_levels;
+
+      const auto next_orders_at_price = (orders_at_price->next_entry_ == best_orders_by_price ? nullptr : orders_at_price->next_entry_);
+      if (traded_qty == qty) { // the rest of this level, or the next one if it was taken completely, is the new best price.
+        if (level_qty < orders_at_price->qty_)
+          new_best_price = orders_at_price->price_;
+        else if (next_orders_at_price)
+          new_best_price = next_orders_at_price->price_;
+        break;
+      }
+      orders_at_price = next_orders_at_price;
+    }
+
+    if (!traded_qty)
+      return;
+
+    // A remainder which rests crossed the whole passive side up to its price, so it is better than every order on its own side.
+    const auto aggressor_orders_by_price = (side == Side::BUY ? bids_by_price_ : asks_by_price_);
+    const auto aggressor_best_price = (rests && traded_qty < qty ? price :
+                                       (aggressor_orders_by_price ? aggressor_orders_by_price->price_ : Price_INVALID));
+
+    market_update_ = {MarketUpdateType::TRADE_SUMMARY, num_levels, ticker_id_, side, new_best_price, traded_qty, notional, false, aggressor_best_price};
+    matching_engine_->sendMarketUpdate(&market_update_);
+  }
+
   /// Create and add a new order in the order book with provided attributes.
   /// It will check to see if this new order matches an existing passive order with opposite side, and perform the matching if that is the case.
-  auto MEOrderBook::add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty) noexcept -> void {
+  /// The order type and time in force decide what happens to any quantity which is not matched immediately.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty,
+                          OrderType order_type, TimeInForce tif) noexcept -> void {
     const auto new_market_order_id = generateNewMarketOrderId();
     client_response_ = {ClientResponseType::ACCEPTED, client_id, ticker_id, client_order_id, new_market_order_id, side, price, 0, qty};
     matching_engine_->sendClientResponse(&client_response_);
 
     START_MEASURE(Exchange_MEOrderBook_checkForMatch);
-    const auto leaves_qty = checkForMatch(client_id, client_order_id, ticker_id, side, price, qty, new_market_order_id);
+    const auto leaves_qty = checkForMatch(client_id, client_order_id, ticker_id, side, price, qty, new_market_order_id, order_type, tif);
     END_MEASURE(Exchange_MEOrderBook_checkForMatch, (*logger_));
 
     if (LIKELY(leaves_qty)) {
@@ -111,18 +208,15 @@ namespace Exchange {
 
       market_update_ = {MarketUpdateType::ADD, new_market_order_id, ticker_id, side, price, leaves_qty, priority};
       matching_engine_->sendMarketUpdate(&market_update_);
+      sendPriceLevelUpdate(side, price);
     }
   }
 
   /// Attempt to cancel an order in the order book, issue a cancel-rejection if order does not exist.
-  auto MEOrderBook::cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void {
-    auto is_cancelable = (client_id < cid_oid_to_order_.size());
-    MEOrder *exchange_order = nullptr;
-    if (LIKELY(is_cancelable)) {
-      auto &co_itr = cid_oid_to_order_.at(client_id);
-      exchange_order = co_itr.at(order_id);
-      is_cancelable = (exchange_order != nullptr);
-    }
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void {
+    const auto exchange_order = cid_oid_to_order_.find(client_id, order_id);
+    const auto is_cancelable = (exchange_order != nullptr);
 
     if (UNLIKELY(!is_cancelable)) {
       client_response_ = {ClientResponseType::CANCEL_REJECTED, client_id, ticker_id, order_id, OrderId_INVALID,
@@ -138,12 +232,160 @@ namespace Exchange {
       END_MEASURE(Exchange_MEOrderBook_removeOrder, (*logger_));
 
       matching_engine_->sendMarketUpdate(&market_update_);
+      sendPriceLevelUpdate(market_update_.side_, market_update_.price_);
+    }
+
+    matching_engine_->sendClientResponse(&client_response_);
+  }
+
+  /// Cancel all of the client's orders in the order book, only on the provided side unless it is Side::INVALID.
+  /// Walks the client's own order list so the cost is proportional to the number of orders cancelled.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::massCancel(ClientId client_id, Side side) noexcept -> size_t {
+    if (UNLIKELY(client_id >= cid_side_orders_.size()))
+      return 0;
+
+    size_t num_cancelled = 0;
+    for (const auto order_side : {Side::BUY, Side::SELL}) {
+      if (side != Side::INVALID && side != order_side)
+        continue;
+
+      auto &client_orders = cid_side_orders_.at(client_id).at(sideToIndex(order_side));
+      while (client_orders) {
+        const auto exchange_order = client_orders;
+        client_response_ = {ClientResponseType::CANCELED, client_id, ticker_id_, exchange_order->client_order_id_, exchange_order->market_order_id_,
+                            exchange_order->side_, exchange_order->price_, Qty_INVALID, exchange_order->qty_};
+        market_update_ = {MarketUpdateType::CANCEL, exchange_order->market_order_id_, ticker_id_, exchange_order->side_, exchange_order->price_, 0,
+                          exchange_order->priority_};
+
+        removeOrder(exchange_order); // also advances client_orders to the next order.
+
+        matching_engine_->sendMarketUpdate(&market_update_);
+        sendPriceLevelUpdate(market_update_.side_, market_update_.price_);
+        matching_engine_->sendClientResponse(&client_response_);
+        ++num_cancelled;
+      }
+    }
+
+    return num_cancelled;
+  }
+
+  /// Attempt to modify the price and / or quantity of an order in the order book, issue a modify-rejection if order does not exist.
+  /// A quantity reduction at the same price keeps the order's queue priority, any other change re-inserts the order at the back of the queue at the new price and may match.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::modify(ClientId client_id, OrderId order_id, TickerId ticker_id, Price price, Qty qty) noexcept -> void {
+    const auto exchange_order = cid_oid_to_order_.find(client_id, order_id);
+    const auto is_modifiable = (exchange_order != nullptr && price != Price_INVALID && qty && qty != Qty_INVALID);
+
+    if (UNLIKELY(!is_modifiable)) {
+      client_response_ = {ClientResponseType::MODIFY_REJECTED, client_id, ticker_id, order_id, OrderId_INVALID,
+                          Side::INVALID, price, Qty_INVALID, qty};
+      matching_engine_->sendClientResponse(&client_response_);
+      return;
     }
 
+    const auto market_order_id = exchange_order->market_order_id_;
+    const auto side = exchange_order->side_;
+
+    client_response_ = {ClientResponseType::MODIFIED, client_id, ticker_id, order_id, market_order_id, side, price, 0, qty};
     matching_engine_->sendClientResponse(&client_response_);
+
+    if (LIKELY(price == exchange_order->price_ && qty <= exchange_order->qty_)) { // quantity reduction, order keeps its place in the FIFO queue.
+      getOrdersAtPrice(price)->qty_ -= (exchange_order->qty_ - qty);
+      exchange_order->qty_ = qty;
+
+      market_update_ = {MarketUpdateType::MODIFY, market_order_id, ticker_id, side, price, qty, exchange_order->priority_};
+      matching_engine_->sendMarketUpdate(&market_update_);
+      sendPriceLevelUpdate(side, price);
+      return;
+    }
+
+    const auto old_price = exchange_order->price_;
+    const auto old_priority = exchange_order->priority_;
+    const auto is_aggressive = isAggressive(side, price);
+
+    START_MEASURE(Exchange_MEOrderBook_removeOrder);
+    removeOrder(exchange_order);
+    END_MEASURE(Exchange_MEOrderBook_removeOrder, (*logger_));
+    sendPriceLevelUpdate(side, old_price);
+
+    auto leaves_qty = qty;
+    if (UNLIKELY(is_aggressive)) { // pull the order from the published book before it trades against the other side.
+      market_update_ = {MarketUpdateType::CANCEL, market_order_id, ticker_id, side, old_price, 0, old_priority};
+      matching_engine_->sendMarketUpdate(&market_update_);
+
+      START_MEASURE(Exchange_MEOrderBook_checkForMatch);
+      leaves_qty = checkForMatch(client_id, order_id, ticker_id, side, price, qty, market_order_id, OrderType::LIMIT, TimeInForce::GTC);
+      END_MEASURE(Exchange_MEOrderBook_checkForMatch, (*logger_));
+    }
+
+    if (LIKELY(leaves_qty)) {
+      const auto priority = getNextPriority(price);
+
+      auto order = order_pool_.allocate(ticker_id, client_id, order_id, market_order_id, side, price, leaves_qty, priority, nullptr, nullptr);
+      START_MEASURE(Exchange_MEOrderBook_addOrder);
+      addOrder(order);
+      END_MEASURE(Exchange_MEOrderBook_addOrder, (*logger_));
+
+      market_update_ = {(is_aggressive ? MarketUpdateType::ADD : MarketUpdateType::MODIFY), market_order_id, ticker_id, side, price, leaves_qty, priority};
+      matching_engine_->sendMarketUpdate(&market_update_);
+      sendPriceLevelUpdate(side, price);
+    }
   }
 
-  auto MEOrderBook::toString(bool detailed, bool validity_check) const -> std::string {
+  /// Append all resting orders to the checkpoint, bids then asks, from the best price level to the worst and in FIFO order within a level.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::checkpoint(std::vector<MECheckpointOrder> *orders) const noexcept -> void {
+    for (const auto best_orders_by_price : {bids_by_price_, asks_by_price_}) {
+      for (auto orders_at_price = best_orders_by_price; orders_at_price; ) {
+        for (auto order = orders_at_price->first_me_order_;; order = order->next_order_) {
+          orders->push_back({order->client_id_, order->client_order_id_, order->market_order_id_, order->side_, order->price_, order->qty_,
+                             order->priority_});
+          if (order->next_order_ == orders_at_price->first_me_order_)
+            break;
+        }
+
+        orders_at_price = (orders_at_price->next_entry_ == best_orders_by_price ? nullptr : orders_at_price->next_entry_);
+      }
+    }
+  }
+
+  /// Rebuild the order book from orders written by checkpoint(), must be called on an empty order book.
+  /// Orders are added in checkpoint order, which appends each order to the back of its price level's FIFO queue and keeps the original priorities.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::restore(OrderId next_market_order_id, const MECheckpointOrder *orders, size_t num_orders) noexcept -> void {
+    ASSERT(!bids_by_price_ && !asks_by_price_, "Restoring into a non-empty order book for ticker:" + tickerIdToString(ticker_id_));
+
+    next_market_order_id_ = next_market_order_id;
+    for (size_t i = 0; i < num_orders; ++i) {
+      const auto &cp_order = orders[i];
+      auto order = order_pool_.allocate(ticker_id_, cp_order.client_id_, cp_order.client_order_id_, cp_order.market_order_id_, cp_order.side_,
+                                        cp_order.price_, cp_order.qty_, cp_order.priority_, nullptr, nullptr);
+      addOrder(order);
+    }
+  }
+
+  /// Publish an ADD for every resting order in the same order as checkpoint() and a price level update for every price level,
+  /// used to announce the orders of a restored order book on the market data streams.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::publishBook() noexcept -> void {
+    for (const auto best_orders_by_price : {bids_by_price_, asks_by_price_}) {
+      for (auto orders_at_price = best_orders_by_price; orders_at_price; ) {
+        for (auto order = orders_at_price->first_me_order_;; order = order->next_order_) {
+          market_update_ = {MarketUpdateType::ADD, order->market_order_id_, ticker_id_, order->side_, order->price_, order->qty_, order->priority_};
+          matching_engine_->sendMarketUpdate(&market_update_);
+          if (order->next_order_ == orders_at_price->first_me_order_)
+            break;
+        }
+        sendPriceLevelUpdate(orders_at_price->side_, orders_at_price->price_);
+
+        orders_at_price = (orders_at_price->next_entry_ == best_orders_by_price ? nullptr : orders_at_price->next_entry_);
+      }
+    }
+  }
+
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  auto BasicMEOrderBook<OrderIndex, PriceLevelIndex, Allocator>::toString(bool detailed, bool validity_check) const -> std::string {
     std::stringstream ss;
     std::string time_str;
 
@@ -177,6 +419,9 @@ namespace Exchange {
       ss << std::endl;
 
       if (sanity_check) {
+        if (qty != itr->qty_) {
+          FATAL("Price level quantity:" + qtyToString(itr->qty_) + " does not match orders quantity:" + qtyToString(qty) + " itr:" + itr->toString());
+        }
         if ((side == Side::SELL && last_price >= itr->price_) || (side == Side::BUY && last_price <= itr->price_)) {
           FATAL("Bids/Asks not sorted by ascending/descending prices last:" + priceToString(last_price) + " itr:" + itr->toString());
         }
@@ -211,4 +456,18 @@ namespace Exchange {
 
     return ss.str();
   }
+
+  /// The supported layouts, add a line here to benchmark a new combination of policies.
+  template class BasicMEOrderBook<HashOrderIndex, ArrayPriceLevelIndex, MemPoolAllocator>;
+  template class BasicMEOrderBook<HashOrderIndex, ArrayPriceLevelIndex, NewDeleteAllocator>;
+  template class BasicMEOrderBook<HashOrderIndex, UnorderedMapPriceLevelIndex, MemPoolAllocator>;
+  template class BasicMEOrderBook<HashOrderIndex, UnorderedMapPriceLevelIndex, NewDeleteAllocator>;
+  template class BasicMEOrderBook<ArrayOrderIndex, ArrayPriceLevelIndex, MemPoolAllocator>;
+  template class BasicMEOrderBook<ArrayOrderIndex, ArrayPriceLevelIndex, NewDeleteAllocator>;
+  template class BasicMEOrderBook<ArrayOrderIndex, UnorderedMapPriceLevelIndex, MemPoolAllocator>;
+  template class BasicMEOrderBook<ArrayOrderIndex, UnorderedMapPriceLevelIndex, NewDeleteAllocator>;
+  template class BasicMEOrderBook<UnorderedMapOrderIndex, ArrayPriceLevelIndex, MemPoolAllocator>;
+  template class BasicMEOrderBook<UnorderedMapOrderIndex, ArrayPriceLevelIndex, NewDeleteAllocator>;
+  template class BasicMEOrderBook<UnorderedMapOrderIndex, UnorderedMapPriceLevelIndex, MemPoolAllocator>;
+  template class BasicMEOrderBook<UnorderedMapOrderIndex, UnorderedMapPriceLevelIndex, NewDeleteAllocator>;
 }
@@ -3,41 +3,73 @@
 #include "common/types.h"
 #include "common/mem_pool.h"
 #include "common/logging.h"
+#include "order_server/client_request.h"
 #include "order_server/client_response.h"
 #include "market_data/market_update.h"
 
 #include "me_order.h"
+#include "me_order_book_policies.h"
+#include "me_checkpoint.h"
 
 using namespace Common;
 
 namespace Exchange {
   class MatchingEngine;
 
-  class MEOrderBook final {
+  /// Limit order book for a single instrument, parameterized by the containers it uses:
+  /// OrderIndex maps ClientId -> OrderId -> MEOrder, PriceLevelIndex maps Price -> MEOrdersAtPrice and Allocator provides MEOrder and MEOrdersAtPrice objects.
+  /// See me_order_book_policies.h for the available policies. The member functions are defined in me_order_book.cpp, which explicitly instantiates the supported layouts.
+  template<typename OrderIndex, typename PriceLevelIndex, template<typename> class Allocator>
+  class BasicMEOrderBook final {
   public:
-    explicit MEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine);
+    /// max_orders is the maximum number of orders resting in the book at the same time, it sizes the order memory pool.
+    explicit BasicMEOrderBook(TickerId ticker_id, size_t max_orders, Logger *logger, MatchingEngine *matching_engine);
 
-    ~MEOrderBook();
+    ~BasicMEOrderBook();
 
     /// Create and add a new order in the order book with provided attributes.
     /// It will check to see if this new order matches an existing passive order with opposite side, and perform the matching if that is the case.
-    auto add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty) noexcept -> void;
+    /// The order type and time in force decide what happens to any quantity which is not matched immediately.
+    auto add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty,
+             OrderType order_type, TimeInForce tif) noexcept -> void;
 
     /// Attempt to cancel an order in the order book, issue a cancel-rejection if order does not exist.
     auto cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void;
 
+    /// Cancel all of the client's orders in the order book, only on the provided side unless it is Side::INVALID, and return how many were cancelled.
+    /// Walks the client's own order list so the cost is proportional to the number of orders cancelled.
+    auto massCancel(ClientId client_id, Side side) noexcept -> size_t;
+
+    /// Attempt to modify the price and / or quantity of an order in the order book, issue a modify-rejection if order does not exist.
+    /// A quantity reduction at the same price keeps the order's queue priority, any other change re-inserts the order at the back of the queue at the new price and may match.
+    auto modify(ClientId client_id, OrderId order_id, TickerId ticker_id, Price price, Qty qty) noexcept -> void;
+
+    /// Append all resting orders to the checkpoint, bids then asks, from the best price level to the worst and in FIFO order within a level.
+    auto checkpoint(std::vector<MECheckpointOrder> *orders) const noexcept -> void;
+
+    /// Rebuild the order book from orders written by checkpoint(), must be called on an empty order book.
+    auto restore(OrderId next_market_order_id, const MECheckpointOrder *orders, size_t num_orders) noexcept -> void;
+
+    /// Publish an ADD for every resting order in the same order as checkpoint() and a price level update for every price level,
+    /// used to announce the orders of a restored order book on the market data streams.
+    auto publishBook() noexcept -> void;
+
+    auto getNextMarketOrderId() const noexcept {
+      return next_market_order_id_;
+    }
+
     auto toString(bool detailed, bool validity_check) const -> std::string;
 
     /// Deleted default, copy & move constructors and assignment-operators.
-    MEOrderBook() = delete;
+    BasicMEOrderBook() = delete;
 
-    MEOrderBook(const MEOrderBook &) = delete;
+    BasicMEOrderBook(const BasicMEOrderBook &) = delete;
 
-    MEOrderBook(const MEOrderBook &&) = delete;
+    BasicMEOrderBook(const BasicMEOrderBook &&) = delete;
 
-    MEOrderBook &operator=(const MEOrderBook &) = delete;
+    BasicMEOrderBook &operator=(const BasicMEOrderBook &) = delete;
 
-    MEOrderBook &operator=(const MEOrderBook &&) = delete;
+    BasicMEOrderBook &operator=(const BasicMEOrderBook &&) = delete;
 
   private:
     TickerId ticker_id_ = TickerId_INVALID;
@@ -45,25 +77,29 @@ namespace Exchange {
     /// The parent matching engine instance, used to publish market data and client responses.
     MatchingEngine *matching_engine_ = nullptr;
 
-    /// Hash map from ClientId -> OrderId -> MEOrder.
-    ClientOrderHashMap cid_oid_to_order_;
+    /// Index from ClientId -> OrderId -> MEOrder.
+    OrderIndex cid_oid_to_order_;
 
-    /// Memory pool to manage MEOrdersAtPrice objects.
-    MemPool<MEOrdersAtPrice> orders_at_price_pool_;
+    /// Hash map from ClientId -> Side -> list of the client's orders on that side.
+    ClientSideOrdersHashMap cid_side_orders_;
+
+    /// Allocator to manage MEOrdersAtPrice objects.
+    Allocator<MEOrdersAtPrice> orders_at_price_pool_;
 
     /// Pointers to beginning / best prices / top of book of buy and sell price levels.
     MEOrdersAtPrice *bids_by_price_ = nullptr;
     MEOrdersAtPrice *asks_by_price_ = nullptr;
 
-    /// Hash map from Price -> MEOrdersAtPrice.
-    OrdersAtPriceHashMap price_orders_at_price_;
+    /// Index from Price -> MEOrdersAtPrice.
+    PriceLevelIndex price_orders_at_price_;
 
-    /// Memory pool to manage MEOrder objects.
-    MemPool<MEOrder> order_pool_;
+    /// Allocator to manage MEOrder objects.
+    Allocator<MEOrder> order_pool_;
 
     /// These are used to publish client responses and market updates.
     MEClientResponse client_response_;
     MEMarketUpdate market_update_;
+    MEPriceLevelUpdate price_level_update_;
 
     OrderId next_market_order_id_ = 1;
 
@@ -75,18 +111,21 @@ namespace Exchange {
       return next_market_order_id_++;
     }
 
-    auto priceToIndex(Price price) const noexcept {
-      return (price % ME_MAX_PRICE_LEVELS);
-    }
-
     /// Fetch and return the MEOrdersAtPrice corresponding to the provided price.
     auto getOrdersAtPrice(Price price) const noexcept -> MEOrdersAtPrice * {
-      return price_orders_at_price_.at(priceToIndex(price));
+      return price_orders_at_price_.find(price);
     }
 
+    /// Publish the total quantity and number of orders at the price level on the market by price stream, called after every change to the price level.
+    auto sendPriceLevelUpdate(Side side, Price price) noexcept -> void;
+
+    /// Publish a TRADE_SUMMARY for an aggressive order about to match, computed from the price level totals before any passive order is touched.
+    /// rests is set if the quantity left unmatched is added to the book.
+    auto sendTradeSummary(Side side, Price price, Qty qty, bool is_market, bool rests) noexcept -> void;
+
     /// Add a new MEOrdersAtPrice at the correct price into the containers - the hash map and the doubly linked list of price levels.
     auto addOrdersAtPrice(MEOrdersAtPrice *new_orders_at_price) noexcept {
-      price_orders_at_price_.at(priceToIndex(new_orders_at_price->price_)) = new_orders_at_price;
+      price_orders_at_price_.insert(new_orders_at_price->price_, new_orders_at_price);
 
       const auto best_orders_by_price = (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_);
       if (UNLIKELY(!best_orders_by_price)) {
@@ -149,7 +188,7 @@ namespace Exchange {
         orders_at_price->prev_entry_ = orders_at_price->next_entry_ = nullptr;
       }
 
-      price_orders_at_price_.at(priceToIndex(price)) = nullptr;
+      price_orders_at_price_.erase(price);
 
       orders_at_price_pool_.deallocate(orders_at_price);
     }
@@ -169,7 +208,37 @@ namespace Exchange {
 
     /// Check if a new order with the provided attributes would match against existing passive orders on the other side of the order book.
     /// This will call the match() method to perform the match if there is a match to be made and return the quantity remaining if any on this new order.
-    auto checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty, Qty new_market_order_id) noexcept;
+    /// MARKET, POST_ONLY, IOC and FOK orders are fully handled here and never return a quantity to be inserted in the book, any unmatched quantity is cancelled.
+    auto checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price, Qty qty, Qty new_market_order_id,
+                       OrderType order_type, TimeInForce tif) noexcept;
+
+    /// Check if a new order with the provided attributes would match against the best price on the other side of the order book.
+    auto isAggressive(Side side, Price price) const noexcept {
+      return (side == Side::BUY ? (asks_by_price_ && price >= asks_by_price_->price_) :
+              (bids_by_price_ && price <= bids_by_price_->price_));
+    }
+
+    /// Check if there is enough passive quantity on the other side of the order book at or better than the provided price to match the full quantity.
+    /// A MARKET order is not limited by price. Only walks price levels, not individual orders.
+    auto canMatchFully(Side side, Price price, Qty qty, OrderType order_type) const noexcept {
+      const auto best_orders_by_price = (side == Side::BUY ? asks_by_price_ : bids_by_price_);
+      uint64_t available_qty = 0;
+      for (auto orders_at_price = best_orders_by_price; orders_at_price; ) {
+        if (order_type != OrderType::MARKET &&
+            (side == Side::BUY ? price < orders_at_price->price_ : price > orders_at_price->price_)) {
+          break;
+        }
+
+        available_qty += orders_at_price->qty_;
+        if (available_qty >= qty) {
+          return true;
+        }
+
+        orders_at_price = (orders_at_price->next_entry_ == best_orders_by_price ? nullptr : orders_at_price->next_entry_);
+      }
+
+      return false;
+    }
 
     /// Remove and de-allocate provided order from the containers.
     auto removeOrder(MEOrder *order) noexcept {
@@ -186,11 +255,24 @@ namespace Exchange {
         if (orders_at_price->first_me_order_ == order) {
           orders_at_price->first_me_order_ = order_after;
         }
+        orders_at_price->qty_ -= order->qty_;
+        --orders_at_price->num_orders_;
 
         order->prev_order_ = order->next_order_ = nullptr;
       }
 
-      cid_oid_to_order_.at(order->client_id_).at(order->client_order_id_) = nullptr;
+      auto &client_orders = cid_side_orders_.at(order->client_id_).at(sideToIndex(order->side_));
+      if (order->prev_client_order_) {
+        order->prev_client_order_->next_client_order_ = order->next_client_order_;
+      } else {
+        client_orders = order->next_client_order_;
+      }
+      if (order->next_client_order_) {
+        order->next_client_order_->prev_client_order_ = order->prev_client_order_;
+      }
+      order->prev_client_order_ = order->next_client_order_ = nullptr;
+
+      cid_oid_to_order_.erase(order->client_id_, order->client_order_id_);
       order_pool_.deallocate(order);
     }
 
@@ -202,6 +284,8 @@ namespace Exchange {
         order->next_order_ = order->prev_order_ = order;
 
         auto new_orders_at_price = orders_at_price_pool_.allocate(order->side_, order->price_, order, nullptr, nullptr);
+        new_orders_at_price->qty_ = order->qty_;
+        new_orders_at_price->num_orders_ = 1;
         addOrdersAtPrice(new_orders_at_price);
       } else {
         auto first_order = (orders_at_price ? orders_at_price->first_me_order_ : nullptr);
@@ -210,12 +294,26 @@ namespace Exchange {
         order->prev_order_ = first_order->prev_order_;
         order->next_order_ = first_order;
         first_order->prev_order_ = order;
+        orders_at_price->qty_ += order->qty_;
+        ++orders_at_price->num_orders_;
       }
 
-      cid_oid_to_order_.at(order->client_id_).at(order->client_order_id_) = order;
+      auto &client_orders = cid_side_orders_.at(order->client_id_).at(sideToIndex(order->side_));
+      order->prev_client_order_ = nullptr;
+      order->next_client_order_ = client_orders;
+      if (client_orders) {
+        client_orders->prev_client_order_ = order;
+      }
+      client_orders = order;
+
+      cid_oid_to_order_.insert(order->client_id_, order->client_order_id_, order);
     }
   };
 
-  /// A hash map from TickerId -> MEOrderBook.
-  typedef std::array<MEOrderBook *, ME_MAX_TICKERS> OrderBookHashMap;
+  /// The order book layout used by the matching engine - an order id index sized for the book's max_orders, a flat array of price levels
+  /// and pre-allocated memory pools, so the memory of each listed instrument is proportional to its max_orders.
+  typedef BasicMEOrderBook<HashOrderIndex, ArrayPriceLevelIndex, MemPoolAllocator> MEOrderBook;
+
+  /// A hash map from TickerId -> MEOrderBook, sized to the listed instruments.
+  typedef std::vector<MEOrderBook *> OrderBookHashMap;
 }
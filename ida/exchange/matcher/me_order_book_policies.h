@@ -0,0 +1,234 @@
+#pragma once
+
+#include <bit>
+#include <unordered_map>
+#include <vector>
+
+#include "common/types.h"
+#include "common/mem_pool.h"
+#include "common/macros.h"
+
+#include "me_order.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Policies which select the containers used by BasicMEOrderBook.
+  /// Each policy is held by value and all of its methods are inline, so the order book compiles to the same code as if the container was used directly.
+
+  /// Order id index policy using a flat array per client: ClientId -> OrderId -> MEOrder.
+  /// Constant time lookups without hashing, at the cost of ME_MAX_NUM_CLIENTS * ME_MAX_ORDER_IDS pointers (2GB) of mostly untouched virtual memory
+  /// per order book whatever its max_orders, and clear() touches all of it. Only suited to benchmarking a handful of books.
+  class ArrayOrderIndex final {
+  public:
+    explicit ArrayOrderIndex(size_t) {
+    }
+
+    auto find(ClientId client_id, OrderId order_id) const noexcept -> MEOrder * {
+      return (LIKELY(client_id < orders_.size() && order_id < ME_MAX_ORDER_IDS) ? orders_[client_id][order_id] : nullptr);
+    }
+
+    auto insert(ClientId client_id, OrderId order_id, MEOrder *order) noexcept {
+      orders_.at(client_id).at(order_id) = order;
+    }
+
+    auto erase(ClientId client_id, OrderId order_id) noexcept {
+      orders_.at(client_id).at(order_id) = nullptr;
+    }
+
+    auto clear() noexcept {
+      for (auto &itr: orders_) {
+        itr.fill(nullptr);
+      }
+    }
+
+  private:
+    /// Not value-initialized on purpose, that would touch every page of this very large array up front.
+    ClientOrderHashMap orders_;
+  };
+
+  /// Order id index policy using an open addressing hash table sized for the order book's max_orders: (ClientId, OrderId) -> MEOrder.
+  /// Memory is proportional to max_orders, and with at least twice as many slots as orders resting in the book the linear probes stay short.
+  /// Erased entries are backfilled by the later entries of their probe sequence instead of leaving tombstones, so lookups never degrade over a session.
+  class HashOrderIndex final {
+  public:
+    explicit HashOrderIndex(size_t max_orders)
+        : slots_(std::bit_ceil(std::max<size_t>(2 * max_orders, 2))), mask_(slots_.size() - 1), shift_(64 - std::countr_zero(slots_.size())) {
+    }
+
+    auto find(ClientId client_id, OrderId order_id) const noexcept -> MEOrder * {
+      for (auto slot = homeSlot(client_id, order_id); slots_[slot].order_; slot = (slot + 1) & mask_) {
+        if (slots_[slot].client_id_ == client_id && slots_[slot].order_id_ == order_id)
+          return slots_[slot].order_;
+      }
+      return nullptr;
+    }
+
+    auto insert(ClientId client_id, OrderId order_id, MEOrder *order) noexcept {
+      auto slot = homeSlot(client_id, order_id);
+      while (slots_[slot].order_ && (slots_[slot].client_id_ != client_id || slots_[slot].order_id_ != order_id))
+        slot = (slot + 1) & mask_;
+      slots_[slot] = {client_id, order_id, order};
+    }
+
+    auto erase(ClientId client_id, OrderId order_id) noexcept {
+      auto slot = homeSlot(client_id, order_id);
+      while (slots_[slot].order_ && (slots_[slot].client_id_ != client_id || slots_[slot].order_id_ != order_id))
+        slot = (slot + 1) & mask_;
+      if (!slots_[slot].order_)
+        return;
+
+      // An entry after the hole moves into it unless its home slot lies cyclically after the hole, where a lookup for it would never pass the hole.
+      for (auto next = (slot + 1) & mask_; slots_[next].order_; next = (next + 1) & mask_) {
+        const auto home = homeSlot(slots_[next].client_id_, slots_[next].order_id_);
+        if (((next - home) & mask_) >= ((next - slot) & mask_)) {
+          slots_[slot] = slots_[next];
+          slot = next;
+        }
+      }
+      slots_[slot] = {};
+    }
+
+    auto clear() noexcept {
+      std::fill(slots_.begin(), slots_.end(), Slot{});
+    }
+
+  private:
+    struct Slot {
+      ClientId client_id_ = ClientId_INVALID;
+      OrderId order_id_ = OrderId_INVALID;
+      MEOrder *order_ = nullptr;
+    };
+
+    std::vector<Slot> slots_;
+    const size_t mask_;
+    const int shift_;
+
+    /// Fibonacci hashing, the top bits of the product spread consecutive order ids of a client across the table.
+    auto homeSlot(ClientId client_id, OrderId order_id) const noexcept -> size_t {
+      return (((static_cast<uint64_t>(client_id) << 48) ^ order_id) * 0x9E3779B97F4A7C15ULL) >> shift_;
+    }
+  };
+
+  /// Order id index policy using std::unordered_map per client: ClientId -> OrderId -> MEOrder.
+  /// Memory grows with the number of live orders, but every lookup hashes and may allocate on insert.
+  class UnorderedMapOrderIndex final {
+  public:
+    explicit UnorderedMapOrderIndex(size_t) {
+    }
+
+    auto find(ClientId client_id, OrderId order_id) const noexcept -> MEOrder * {
+      const auto client_itr = orders_.find(client_id);
+      if (client_itr == orders_.end())
+        return nullptr;
+
+      const auto order_itr = client_itr->second.find(order_id);
+      return (order_itr == client_itr->second.end() ? nullptr : order_itr->second);
+    }
+
+    auto insert(ClientId client_id, OrderId order_id, MEOrder *order) noexcept {
+      orders_[client_id][order_id] = order;
+    }
+
+    auto erase(ClientId client_id, OrderId order_id) noexcept {
+      orders_[client_id].erase(order_id);
+    }
+
+    auto clear() noexcept {
+      orders_.clear();
+    }
+
+  private:
+    std::unordered_map<ClientId, std::unordered_map<OrderId, MEOrder *>> orders_;
+  };
+
+  /// Price level index policy using a flat array indexed by price modulo ME_MAX_PRICE_LEVELS: Price -> MEOrdersAtPrice.
+  /// Assumes the live prices on a side of the book span fewer than ME_MAX_PRICE_LEVELS ticks.
+  class ArrayPriceLevelIndex final {
+  public:
+    auto find(Price price) const noexcept -> MEOrdersAtPrice * {
+      return levels_.at(priceToIndex(price));
+    }
+
+    auto insert(Price price, MEOrdersAtPrice *orders_at_price) noexcept {
+      levels_.at(priceToIndex(price)) = orders_at_price;
+    }
+
+    auto erase(Price price) noexcept {
+      levels_.at(priceToIndex(price)) = nullptr;
+    }
+
+    auto clear() noexcept {
+      levels_.fill(nullptr);
+    }
+
+  private:
+    OrdersAtPriceHashMap levels_ = {};
+
+    static auto priceToIndex(Price price) noexcept -> size_t {
+      return (price % ME_MAX_PRICE_LEVELS);
+    }
+  };
+
+  /// Price level index policy using std::unordered_map keyed by the actual price: Price -> MEOrdersAtPrice.
+  /// Has no limit on the range of live prices.
+  class UnorderedMapPriceLevelIndex final {
+  public:
+    auto find(Price price) const noexcept -> MEOrdersAtPrice * {
+      const auto itr = levels_.find(price);
+      return (itr == levels_.end() ? nullptr : itr->second);
+    }
+
+    auto insert(Price price, MEOrdersAtPrice *orders_at_price) noexcept {
+      levels_[price] = orders_at_price;
+    }
+
+    auto erase(Price price) noexcept {
+      levels_.erase(price);
+    }
+
+    auto clear() noexcept {
+      levels_.clear();
+    }
+
+  private:
+    std::unordered_map<Price, MEOrdersAtPrice *> levels_;
+  };
+
+  /// Allocator policy which pre-allocates num_elems objects in a MemPool, allocations never go to the heap.
+  template<typename T>
+  class MemPoolAllocator final {
+  public:
+    explicit MemPoolAllocator(size_t num_elems) : pool_(num_elems) {
+    }
+
+    template<typename... Args>
+    auto allocate(Args... args) noexcept -> T * {
+      return pool_.allocate(args...);
+    }
+
+    auto deallocate(const T *elem) noexcept {
+      pool_.deallocate(elem);
+    }
+
+  private:
+    MemPool<T> pool_;
+  };
+
+  /// Allocator policy which allocates every object with new and delete, num_elems is only a hint and is ignored.
+  template<typename T>
+  class NewDeleteAllocator final {
+  public:
+    explicit NewDeleteAllocator(size_t) {
+    }
+
+    template<typename... Args>
+    auto allocate(Args... args) noexcept -> T * {
+      return new T(args...);
+    }
+
+    auto deallocate(const T *elem) noexcept {
+      delete elem;
+    }
+  };
+}
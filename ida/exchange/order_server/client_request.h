@@ -9,10 +9,20 @@ using namespace Common;
 
 namespace Exchange {
   /// Type of the order request sent by the trading client to the exchange.
+  /// MASS_CANCEL cancels all of the client's orders, limited to ticker_id_ and / or side_ unless they are TickerId_INVALID / Side::INVALID,
+  /// and is always answered with a MASS_CANCELED after the orders' CANCELED responses, or a CANCEL_REJECTED for a ticker which is not listed.
+  /// CANCEL_ON_DISCONNECT is a MASS_CANCEL of all of the client's orders generated by the order server when the client's connection closes,
+  /// it is reserved for the order server and does not use up a client sequence number.
+  /// HALT is generated by the order server with ClientId_INVALID when its journal is nearly full, the matching engine rejects every NEW and MODIFY
+  /// after it so the remaining journal records are kept for cancels.
   enum class ClientRequestType : uint8_t {
     INVALID = 0,
     NEW = 1,
-    CANCEL = 2
+    CANCEL = 2,
+    MODIFY = 3,
+    MASS_CANCEL = 4,
+    CANCEL_ON_DISCONNECT = 5,
+    HALT = 6
   };
 
   inline std::string clientRequestTypeToString(ClientRequestType type) {
@@ -21,12 +31,83 @@ namespace Exchange {
         return "NEW";
       case ClientRequestType::CANCEL:
         return "CANCEL";
+      case ClientRequestType::MODIFY:
+        return "MODIFY";
+      case ClientRequestType::MASS_CANCEL:
+        return "MASS_CANCEL";
+      case ClientRequestType::CANCEL_ON_DISCONNECT:
+        return "CANCEL_ON_DISCONNECT";
+      case ClientRequestType::HALT:
+        return "HALT";
       case ClientRequestType::INVALID:
         return "INVALID";
     }
     return "UNKNOWN";
   }
 
+  /// Type of a new order - a LIMIT order can rest in the book, a MARKET order matches at any price and never rests,
+  /// a POST_ONLY order is a limit order which is cancelled instead of matching if it would take liquidity.
+  enum class OrderType : uint8_t {
+    INVALID = 0,
+    LIMIT = 1,
+    MARKET = 2,
+    POST_ONLY = 3
+  };
+
+  inline std::string orderTypeToString(OrderType type) {
+    switch (type) {
+      case OrderType::LIMIT:
+        return "LIMIT";
+      case OrderType::MARKET:
+        return "MARKET";
+      case OrderType::POST_ONLY:
+        return "POST_ONLY";
+      case OrderType::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Time in force of a new order - GTC rests any unmatched quantity, IOC cancels any unmatched quantity,
+  /// FOK is only matched if the full quantity can be matched immediately and is cancelled otherwise.
+  enum class TimeInForce : uint8_t {
+    INVALID = 0,
+    GTC = 1,
+    IOC = 2,
+    FOK = 3
+  };
+
+  inline std::string timeInForceToString(TimeInForce tif) {
+    switch (tif) {
+      case TimeInForce::GTC:
+        return "GTC";
+      case TimeInForce::IOC:
+        return "IOC";
+      case TimeInForce::FOK:
+        return "FOK";
+      case TimeInForce::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Whether a new order's type, time in force and price go together - a MARKET order carries no price and every other order a valid one,
+  /// and a POST_ONLY order has to be able to rest so it is GTC. Values outside of the enums, as decoded off the wire, are not valid.
+  inline auto isValidNewOrder(OrderType order_type, TimeInForce tif, Price price) noexcept {
+    const auto valid_tif = (tif == TimeInForce::GTC || tif == TimeInForce::IOC || tif == TimeInForce::FOK);
+    switch (order_type) {
+      case OrderType::LIMIT:
+        return (valid_tif && price != Price_INVALID);
+      case OrderType::MARKET:
+        return (valid_tif && price == Price_INVALID);
+      case OrderType::POST_ONLY:
+        return (tif == TimeInForce::GTC && price != Price_INVALID);
+      case OrderType::INVALID:
+        break;
+    }
+    return false;
+  }
+
   /// These structures go over the wire / network, so the binary structures are packed to remove system dependent extra padding.
 #pragma pack(push, 1)
 
@@ -40,6 +121,8 @@ namespace Exchange {
     Side side_ = Side::INVALID;
     Price price_ = Price_INVALID;
     Qty qty_ = Qty_INVALID;
+    OrderType order_type_ = OrderType::LIMIT;
+    TimeInForce tif_ = TimeInForce::GTC;
 
     auto toString() const {
       std::stringstream ss;
@@ -52,6 +135,8 @@ namespace Exchange {
          << " side:" << sideToString(side_)
          << " qty:" << qtyToString(qty_)
          << " price:" << priceToString(price_)
+         << " ord_type:" << orderTypeToString(order_type_)
+         << " tif:" << timeInForceToString(tif_)
          << "]";
       return ss.str();
     }
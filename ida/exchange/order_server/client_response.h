@@ -9,12 +9,17 @@ using namespace Common;
 
 namespace Exchange {
   /// Type of the order response sent by the exchange to the trading client.
+  /// MASS_CANCELED completes a MASS_CANCEL, after the CANCELED of every order it cancelled. It echoes the request's ticker_id_ and side_
+  /// and carries the number of orders cancelled, possibly 0, in exec_qty_. A MASS_CANCEL for a ticker which is not listed gets a CANCEL_REJECTED instead.
   enum class ClientResponseType : uint8_t {
     INVALID = 0,
     ACCEPTED = 1,
     CANCELED = 2,
     FILLED = 3,
-    CANCEL_REJECTED = 4
+    CANCEL_REJECTED = 4,
+    MODIFIED = 5,
+    MODIFY_REJECTED = 6,
+    MASS_CANCELED = 7
   };
 
   inline std::string clientResponseTypeToString(ClientResponseType type) {
@@ -27,6 +32,12 @@ namespace Exchange {
         return "FILLED";
       case ClientResponseType::CANCEL_REJECTED:
         return "CANCEL_REJECTED";
+      case ClientResponseType::MODIFIED:
+        return "MODIFIED";
+      case ClientResponseType::MODIFY_REJECTED:
+        return "MODIFY_REJECTED";
+      case ClientResponseType::MASS_CANCELED:
+        return "MASS_CANCELED";
       case ClientResponseType::INVALID:
         return "INVALID";
     }
@@ -48,6 +59,9 @@ namespace Exchange {
     Qty exec_qty_ = Qty_INVALID;
     Qty leaves_qty_ = Qty_INVALID;
 
+    /// Set on the last client response generated by a single client request.
+    bool last_in_batch_ = false;
+
     auto toString() const {
       std::stringstream ss;
       ss << "MEClientResponse"
@@ -61,6 +75,7 @@ namespace Exchange {
          << " exec_qty:" << qtyToString(exec_qty_)
          << " leaves_qty:" << qtyToString(leaves_qty_)
          << " price:" << priceToString(price_)
+         << " last:" << last_in_batch_
          << "]";
       return ss.str();
     }
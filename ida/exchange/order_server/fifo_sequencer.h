@@ -1,50 +1,97 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include "common/thread_utils.h"
 #include "common/macros.h"
 
 #include "order_server/client_request.h"
+#include "order_server/me_journal.h"
 
 namespace Exchange {
-  /// Maximum number of unprocessed client request messages across all TCP connections in the order server / FIFO sequencer.
-  constexpr size_t ME_MAX_PENDING_REQUESTS = 1024;
+  /// Default maximum number of unprocessed client request messages across all TCP connections in the order server / FIFO sequencer.
+  constexpr size_t ME_MAX_PENDING_REQUESTS = 64 * 1024;
 
   class FIFOSequencer {
   public:
-    FIFOSequencer(ClientRequestLFQueue *client_requests, Logger *logger)
-        : incoming_requests_(client_requests), logger_(logger) {
+    /// At most max_pending_requests client requests can be pending between calls to sequenceAndPublish(), the storage is allocated here up front.
+    FIFOSequencer(ClientRequestLFQueue *client_requests, MEJournal *journal, size_t max_pending_requests, Logger *logger)
+        : incoming_requests_(client_requests), journal_(journal), logger_(logger),
+          pending_client_requests_(max_pending_requests) {
+      ASSERT(max_pending_requests, "FIFOSequencer needs room for at least one pending request.");
+      pending_runs_.reserve(max_pending_requests);
     }
 
     ~FIFOSequencer() {
     }
 
+    /// Number of client requests which can still be added before sequenceAndPublish() has to be called, callers must check this before adding.
+    auto freeCapacity() const noexcept {
+      return pending_client_requests_.size() - pending_size_;
+    }
+
+    /// Whether another client request can be added and still be journaled, the last records are kept for a cancel-on-disconnect of every client.
+    auto canJournal() const noexcept {
+      return (!journal_ || journal_->freeRecords() > pending_size_ + ME_MAX_NUM_CLIENTS);
+    }
+
+    /// Whether a cancel-on-disconnect can be added and still be journaled.
+    auto canJournalCancelOnDisconnect() const noexcept {
+      return (!journal_ || journal_->freeRecords() > pending_size_);
+    }
+
     /// Queue up a client request, not processed immediately, processed when sequenceAndPublish() is called.
     auto addClientRequest(Nanos rx_time, const MEClientRequest &request) {
-      if (pending_size_ >= pending_client_requests_.size()) {
-        FATAL("Too many pending requests");
+      if (UNLIKELY(pending_size_ >= pending_client_requests_.size())) {
+        FATAL("Too many pending requests, callers must check freeCapacity()");
       }
-      pending_client_requests_.at(pending_size_++) = std::move(RecvTimeClientRequest{rx_time, request});
+      pending_client_requests_[pending_size_++] = RecvTimeClientRequest{rx_time, request};
     }
 
-    /// Sort pending client requests in ascending receive time order and then write them to the lock free queue for the matching engine to consume from.
+    /// Write pending client requests to the lock free queue for the matching engine to consume from in ascending receive time order, ties are
+    /// broken by the order in which they were added. Requests from one TCP connection are added in receive time order, so the pending requests
+    /// are a few sorted runs which are k-way merged with a heap of run heads in O(n log k) instead of being sorted.
+    /// Each request is appended to the journal, if there is one, in the same order so it can be replayed deterministically.
     auto sequenceAndPublish() {
       if (UNLIKELY(!pending_size_))
         return;
 
       logger_->log("%:% %() % Processing % requests.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), pending_size_);
 
-      std::sort(pending_client_requests_.begin(), pending_client_requests_.begin() + pending_size_);
-
-      for (size_t i = 0; i < pending_size_; ++i) {
-        const auto &client_request = pending_client_requests_.at(i);
-
-        logger_->log("%:% %() % Writing RX:% Req:% to FIFO.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
-                     client_request.recv_time_, client_request.request_.toString());
-
-        auto next_write = incoming_requests_->getNextToWriteTo();
-        *next_write = std::move(client_request.request_);
-        incoming_requests_->updateWriteIndex();
-        TTT_MEASURE(T2_OrderServer_LFQueue_write, (*logger_));
+      // Split the pending requests into maximal runs of non-decreasing receive time.
+      pending_runs_.clear();
+      size_t run_start = 0;
+      for (size_t i = 1; i < pending_size_; ++i) {
+        if (pending_client_requests_[i].recv_time_ < pending_client_requests_[i - 1].recv_time_) {
+          pending_runs_.push_back({run_start, i});
+          run_start = i;
+        }
+      }
+      pending_runs_.push_back({run_start, pending_size_});
+
+      if (LIKELY(pending_runs_.size() == 1)) { // already in order, usually a single connection had data.
+        for (size_t i = 0; i < pending_size_; ++i) {
+          publish(pending_client_requests_[i]);
+        }
+      } else {
+        // std::push_heap / std::pop_heap build a max-heap, so the comparison is inverted to keep the earliest run head on top.
+        auto later = [this](const PendingRun &lhs, const PendingRun &rhs) {
+          const auto lhs_time = pending_client_requests_[lhs.next_].recv_time_, rhs_time = pending_client_requests_[rhs.next_].recv_time_;
+          return (lhs_time > rhs_time || (lhs_time == rhs_time && lhs.next_ > rhs.next_));
+        };
+        std::make_heap(pending_runs_.begin(), pending_runs_.end(), later);
+
+        while (!pending_runs_.empty()) {
+          std::pop_heap(pending_runs_.begin(), pending_runs_.end(), later);
+          auto &run = pending_runs_.back();
+          publish(pending_client_requests_[run.next_++]);
+
+          if (run.next_ == run.end_)
+            pending_runs_.pop_back();
+          else
+            std::push_heap(pending_runs_.begin(), pending_runs_.end(), later);
+        }
       }
 
       pending_size_ = 0;
@@ -65,6 +112,12 @@ namespace Exchange {
     /// Lock free queue used to publish client requests to, so that the matching engine can consume them.
     ClientRequestLFQueue *incoming_requests_ = nullptr;
 
+    /// Journal of sequenced client requests, nullptr if journaling is disabled.
+    MEJournal *journal_ = nullptr;
+
+    /// Set once a HALT has been published because the journal is nearly full.
+    bool halted_ = false;
+
     std::string time_str_;
     Logger *logger_ = nullptr;
 
@@ -72,14 +125,53 @@ namespace Exchange {
     struct RecvTimeClientRequest {
       Nanos recv_time_ = 0;
       MEClientRequest request_;
+    };
 
-      auto operator<(const RecvTimeClientRequest &rhs) const {
-        return (recv_time_ < rhs.recv_time_);
-      }
+    /// A sorted run of pending client requests, [next_, end_) are the indices which have not been published yet.
+    struct PendingRun {
+      size_t next_ = 0;
+      size_t end_ = 0;
     };
 
-    /// Queue of pending client requests, not sorted.
-    std::array<RecvTimeClientRequest, ME_MAX_PENDING_REQUESTS> pending_client_requests_;
+    /// Journal and write a single client request to the lock free queue for the matching engine.
+    auto publish(const RecvTimeClientRequest &client_request) noexcept -> void {
+      logger_->log("%:% %() % Writing RX:% Req:% to FIFO.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                   client_request.recv_time_, client_request.request_.toString());
+
+      if (journal_) {
+        if (UNLIKELY(!halted_ && journal_->nearlyFull()))
+          halt(client_request.recv_time_);
+
+        START_MEASURE(Exchange_MEJournal_append);
+        journal_->append(client_request.recv_time_, client_request.request_);
+        END_MEASURE(Exchange_MEJournal_append, (*logger_));
+      }
+
+      auto next_write = incoming_requests_->getNextToWriteTo();
+      *next_write = client_request.request_;
+      incoming_requests_->updateWriteIndex();
+      TTT_MEASURE(T2_OrderServer_LFQueue_write, (*logger_));
+    }
+
+    /// Journal and publish a HALT ahead of the next client request, so the matching engine rejects new orders while cancels can still be journaled.
+    /// After a restart with a nearly full journal it is sent again, before any other client request.
+    auto halt(Nanos recv_time) noexcept -> void {
+      logger_->log("%:% %() % Journal has % free records, halting new orders.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                   journal_->freeRecords());
+      halted_ = true;
+
+      const MEClientRequest halt{ClientRequestType::HALT, ClientId_INVALID, TickerId_INVALID, OrderId_INVALID, Side::INVALID, Price_INVALID, Qty_INVALID};
+      journal_->append(recv_time, halt);
+      auto next_write = incoming_requests_->getNextToWriteTo();
+      *next_write = halt;
+      incoming_requests_->updateWriteIndex();
+    }
+
+    /// Queue of pending client requests in the order they were added, sized at construction.
+    std::vector<RecvTimeClientRequest> pending_client_requests_;
     size_t pending_size_ = 0;
+
+    /// Heap of sorted runs being merged in sequenceAndPublish(), reserved up front so merging does not allocate.
+    std::vector<PendingRun> pending_runs_;
   };
 }
@@ -0,0 +1,179 @@
+#include "me_journal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Exchange {
+  MEJournal::MEJournal(const std::string &file_name, size_t max_records, JournalSyncPolicy sync_policy)
+      : file_name_(file_name), sync_policy_(sync_policy), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_journal.log") {
+    file_size_ = sizeof(MEJournalHeader) + max_records * sizeof(MEJournalRecord);
+
+    fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    ASSERT(fd_ >= 0, "Unable to open journal file:" + file_name_ + " error:" + std::string(std::strerror(errno)));
+
+    struct stat file_stat;
+    ASSERT(fstat(fd_, &file_stat) == 0, "Unable to stat journal file:" + file_name_ + " error:" + std::string(std::strerror(errno)));
+    const auto is_new_file = (file_stat.st_size == 0);
+
+    // Preallocate the blocks on disk so append() never extends the file, only a window of the mapping ahead of it is faulted in by prefault().
+    const auto rc = posix_fallocate(fd_, 0, file_size_);
+    ASSERT(rc == 0, "Unable to preallocate journal file:" + file_name_ + " error:" + std::string(std::strerror(rc)));
+
+    auto data = mmap(nullptr, file_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    ASSERT(data != MAP_FAILED, "Unable to mmap journal file:" + file_name_ + " error:" + std::string(std::strerror(errno)));
+
+    // An existing journal is appended to after its last synced record, so a restarted exchange keeps a single journal to recover from.
+    if (is_new_file) {
+      header_ = new(data) MEJournalHeader{ME_JOURNAL_MAGIC, max_records, 0};
+    } else {
+      header_ = reinterpret_cast<MEJournalHeader *>(data);
+      ASSERT(header_->magic_ == ME_JOURNAL_MAGIC && header_->max_records_ == max_records && header_->num_records_ <= max_records,
+             "Existing journal file:" + file_name_ + " is corrupt or was created with a different capacity.");
+    }
+    records_ = reinterpret_cast<MEJournalRecord *>(reinterpret_cast<char *>(data) + sizeof(MEJournalHeader));
+    next_record_ = header_->num_records_;
+    num_synced_ = num_appended_ = num_prefaulted_ = next_record_;
+    prefault(next_record_ + ME_JOURNAL_PREFAULT_RECORDS);
+
+    logger_.log("%:% %() % Opened journal:% max_records:% size:% sync:% existing_records:%\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), file_name_, max_records, file_size_, journalSyncPolicyToString(sync_policy_), next_record_);
+  }
+
+  MEJournal::~MEJournal() {
+    stop();
+    if (writer_thread_) {
+      writer_thread_->join();
+      delete writer_thread_;
+      writer_thread_ = nullptr;
+    }
+
+    // Make sure everything appended so far is accounted for in the header before closing.
+    sync();
+
+    munmap(header_, file_size_);
+    close(fd_);
+    header_ = nullptr;
+    records_ = nullptr;
+  }
+
+  /// Start and stop the journal writer thread.
+  auto MEJournal::start() -> void {
+    run_ = true;
+    writer_thread_ = Common::createAndStartThread(-1, "Exchange/MEJournal", [this]() { run(); });
+    ASSERT(writer_thread_ != nullptr, "Failed to start MEJournal thread.");
+  }
+
+  auto MEJournal::stop() -> void {
+    run_ = false;
+  }
+
+  /// Continue the journal at record num_records, past the records synced so far, when the matching engine was restored from a checkpoint taken
+  /// after the last synced record. Records up to num_records are covered by that checkpoint and are never replayed, must be called before start().
+  auto MEJournal::resumeAt(size_t num_records) noexcept -> void {
+    ASSERT(!run_ && num_records >= next_record_ && num_records <= header_->max_records_,
+           "Cannot resume journal:" + file_name_ + " at record:" + std::to_string(num_records));
+
+    logger_.log("%:% %() % Resuming journal:% at record:% skipping records from:%\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), file_name_, num_records, next_record_);
+    next_record_ = num_records;
+    num_synced_ = num_appended_ = next_record_;
+    num_prefaulted_ = std::max(num_prefaulted_, next_record_);
+    prefault(next_record_ + ME_JOURNAL_PREFAULT_RECORDS);
+    header_->num_records_ = next_record_;
+    if (sync_policy_ != JournalSyncPolicy::NONE) {
+      msync(header_, sizeof(MEJournalHeader), (sync_policy_ == JournalSyncPolicy::SYNC ? MS_SYNC : MS_ASYNC));
+    }
+  }
+
+  /// Sync records [num_synced_, num_appended_) and then the header according to the sync policy.
+  auto MEJournal::sync() noexcept -> void {
+    const auto num_appended = num_appended_.load(std::memory_order_acquire);
+    const size_t num_synced = num_synced_;
+    if (num_appended == num_synced)
+      return;
+
+    if (sync_policy_ != JournalSyncPolicy::NONE) {
+      const auto flags = (sync_policy_ == JournalSyncPolicy::SYNC ? MS_SYNC : MS_ASYNC);
+      static const size_t page_size = sysconf(_SC_PAGESIZE);
+
+      // msync() needs a page aligned start address.
+      const auto begin = (sizeof(MEJournalHeader) + num_synced * sizeof(MEJournalRecord)) / page_size * page_size;
+      const auto end = sizeof(MEJournalHeader) + num_appended * sizeof(MEJournalRecord);
+      if (msync(reinterpret_cast<char *>(header_) + begin, end - begin, flags) != 0) {
+        logger_.log("%:% %() % msync failed journal:% error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    file_name_, std::strerror(errno));
+      }
+    }
+
+    // Only count the records in the header after they were synced. With SYNC they are on disk by now, with ASYNC their write-back has only been
+    // scheduled and with NONE it is left to the kernel, so with those a machine crash can still lose records counted here, a process crash cannot.
+    header_->num_records_ = num_appended;
+    if (sync_policy_ != JournalSyncPolicy::NONE) {
+      msync(header_, sizeof(MEJournalHeader), (sync_policy_ == JournalSyncPolicy::SYNC ? MS_SYNC : MS_ASYNC));
+    }
+
+    num_synced_.store(num_appended, std::memory_order_release);
+  }
+
+  /// Fault in the pages of the records up to num_records which are not yet, without changing their contents.
+  auto MEJournal::prefault(size_t num_records) noexcept -> void {
+    num_records = std::min(num_records, static_cast<size_t>(header_->max_records_));
+    if (num_records <= num_prefaulted_)
+      return;
+
+    // madvise() needs a page aligned start address, the page of the first record may already be faulted in which is harmless.
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    const auto begin = (sizeof(MEJournalHeader) + num_prefaulted_ * sizeof(MEJournalRecord)) / page_size * page_size;
+    const auto end = sizeof(MEJournalHeader) + num_records * sizeof(MEJournalRecord);
+    if (madvise(reinterpret_cast<char *>(header_) + begin, end - begin, MADV_POPULATE_WRITE) != 0) {
+      logger_.log("%:% %() % prefault failed journal:% records:% error:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  file_name_, num_records, std::strerror(errno));
+    }
+    num_prefaulted_ = num_records;
+  }
+
+  /// Main loop for the writer thread - syncs newly appended records according to the sync policy and then publishes them in the file header.
+  /// Also keeps ME_JOURNAL_PREFAULT_RECORDS past the last appended record faulted in.
+  auto MEJournal::run() noexcept -> void {
+    logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+    while (run_) {
+      sync();
+
+      const auto num_synced = num_synced_.load(std::memory_order_acquire);
+      if (num_synced + ME_JOURNAL_PREFAULT_RECORDS / 2 > num_prefaulted_)
+        prefault(num_synced + ME_JOURNAL_PREFAULT_RECORDS);
+
+      using namespace std::literals::chrono_literals;
+      std::this_thread::sleep_for(1ms);
+    }
+  }
+
+  MEJournalReader::MEJournalReader(const std::string &file_name) {
+    fd_ = open(file_name.c_str(), O_RDONLY);
+    ASSERT(fd_ >= 0, "Unable to open journal file:" + file_name + " error:" + std::string(std::strerror(errno)));
+
+    struct stat file_stat;
+    ASSERT(fstat(fd_, &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) >= sizeof(MEJournalHeader),
+           "Journal file too small:" + file_name);
+    file_size_ = file_stat.st_size;
+
+    data_ = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    ASSERT(data_ != MAP_FAILED, "Unable to mmap journal file:" + file_name + " error:" + std::string(std::strerror(errno)));
+
+    const auto header = reinterpret_cast<const MEJournalHeader *>(data_);
+    ASSERT(header->magic_ == ME_JOURNAL_MAGIC, "Not a journal file:" + file_name);
+    ASSERT(header->num_records_ <= header->max_records_ &&
+           sizeof(MEJournalHeader) + header->max_records_ * sizeof(MEJournalRecord) <= file_size_, "Corrupt journal file:" + file_name);
+
+    records_ = reinterpret_cast<const MEJournalRecord *>(reinterpret_cast<const char *>(data_) + sizeof(MEJournalHeader));
+    num_records_ = header->num_records_;
+  }
+
+  MEJournalReader::~MEJournalReader() {
+    munmap(data_, file_size_);
+    close(fd_);
+    data_ = nullptr;
+    records_ = nullptr;
+  }
+}
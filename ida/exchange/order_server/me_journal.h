@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <new>
+
+#include "common/thread_utils.h"
+#include "common/macros.h"
+#include "common/logging.h"
+
+#include "order_server/client_request.h"
+
+namespace Exchange {
+  /// Default capacity of the journal file in number of sequenced client requests, the file is preallocated on disk to hold this many records.
+  constexpr size_t ME_MAX_JOURNAL_RECORDS = 16 * 1024 * 1024;
+
+  /// Number of records past the last appended one whose pages are kept faulted in, so append() does not take a page fault while the rest of
+  /// the file stays out of memory. The writer thread extends the window once half of it was appended to.
+  constexpr size_t ME_JOURNAL_PREFAULT_RECORDS = 256 * 1024;
+
+  /// Identifies a valid journal file, and the version of the record layout it was written with.
+  constexpr uint64_t ME_JOURNAL_MAGIC = 0x4c4e524a454d4f31; // "1OMEJRNL"
+
+  /// How aggressively the journal writer thread pushes appended records to disk.
+  enum class JournalSyncPolicy : uint8_t {
+    INVALID = 0,
+    NONE = 1,  // leave write-back to the kernel, survives a process crash but not a machine crash.
+    ASYNC = 2, // schedule write-back with msync(MS_ASYNC).
+    SYNC = 3   // wait for write-back with msync(MS_SYNC) before records are counted in the header.
+  };
+
+  inline std::string journalSyncPolicyToString(JournalSyncPolicy policy) {
+    switch (policy) {
+      case JournalSyncPolicy::NONE:
+        return "NONE";
+      case JournalSyncPolicy::ASYNC:
+        return "ASYNC";
+      case JournalSyncPolicy::SYNC:
+        return "SYNC";
+      case JournalSyncPolicy::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// These structures are written to disk, so the binary structures are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+  /// Header at the start of the journal file.
+  struct MEJournalHeader {
+    uint64_t magic_ = ME_JOURNAL_MAGIC;
+
+    /// Number of records the file has space for.
+    uint64_t max_records_ = 0;
+
+    /// Number of records which have been synced to the file according to the sync policy, records past this are ignored on reading.
+    uint64_t num_records_ = 0;
+  };
+
+  /// A single sequenced client request, in the order in which it was published to the matching engine.
+  struct MEJournalRecord {
+    Nanos recv_time_ = 0;
+    MEClientRequest request_;
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  /// Memory-mapped, preallocated journal of every client request in the order the FIFO sequencer publishes it to the matching engine.
+  /// append() is called on the hot path and only copies the record into the mapping, a separate writer thread syncs it according to the sync policy.
+  class MEJournal final {
+  public:
+    MEJournal(const std::string &file_name, size_t max_records, JournalSyncPolicy sync_policy);
+
+    ~MEJournal();
+
+    /// Start and stop the journal writer thread.
+    auto start() -> void;
+
+    auto stop() -> void;
+
+    /// Number of records which can still be appended, only accessed by the thread calling append().
+    auto freeRecords() const noexcept {
+      return header_->max_records_ - next_record_;
+    }
+
+    /// Set once only the last 1/16th of the records are free, the order server halts new orders then and keeps the rest for cancels.
+    auto nearlyFull() const noexcept {
+      return freeRecords() <= header_->max_records_ / 16;
+    }
+
+    /// Copy the sequenced client request into the next record of the journal.
+    /// The order server stops sequencing client requests while there is room left, so this never runs out of records.
+    auto append(Nanos recv_time, const MEClientRequest &request) noexcept {
+      ASSERT(next_record_ < header_->max_records_, "Journal is full:" + file_name_ + " max_records:" + std::to_string(header_->max_records_));
+
+      records_[next_record_] = {recv_time, request};
+      num_appended_.store(++next_record_, std::memory_order_release);
+    }
+
+    /// Number of records synced according to the sync policy and counted in the file header, i.e. which a restart can replay.
+    auto getNumSynced() const noexcept {
+      return num_synced_.load(std::memory_order_acquire);
+    }
+
+    /// Continue the journal at record num_records, past the records synced so far, when the matching engine was restored from a checkpoint taken
+    /// after the last synced record. Records up to num_records are covered by that checkpoint and are never replayed, must be called before start().
+    auto resumeAt(size_t num_records) noexcept -> void;
+
+    /// Main loop for the writer thread - syncs newly appended records according to the sync policy and then publishes them in the file header.
+    auto run() noexcept -> void;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    MEJournal() = delete;
+
+    MEJournal(const MEJournal &) = delete;
+
+    MEJournal(const MEJournal &&) = delete;
+
+    MEJournal &operator=(const MEJournal &) = delete;
+
+    MEJournal &operator=(const MEJournal &&) = delete;
+
+  private:
+    const std::string file_name_;
+    const JournalSyncPolicy sync_policy_ = JournalSyncPolicy::INVALID;
+
+    int fd_ = -1;
+    size_t file_size_ = 0;
+
+    /// The memory mapped file, header followed by the records.
+    MEJournalHeader *header_ = nullptr;
+    MEJournalRecord *records_ = nullptr;
+
+    /// Index of the next record to be written, only accessed by the thread calling append().
+    size_t next_record_ = 0;
+
+    /// Number of records appended so far, published by append() for the writer thread.
+    std::atomic<size_t> num_appended_ = {0};
+
+    /// Number of records the writer thread has synced so far, read by the checkpoint writer.
+    std::atomic<size_t> num_synced_ = {0};
+
+    /// Number of records whose pages have been faulted in, only accessed by the writer thread once it is started.
+    size_t num_prefaulted_ = 0;
+
+    volatile bool run_ = false;
+    std::thread *writer_thread_ = nullptr;
+
+    std::string time_str_;
+    Logger logger_;
+
+    /// Sync records [num_synced_, num_appended_) and then the header according to the sync policy.
+    auto sync() noexcept -> void;
+
+    /// Fault in the pages of the records up to num_records which are not yet, without changing their contents.
+    auto prefault(size_t num_records) noexcept -> void;
+  };
+
+  /// Read-only view of a journal file written by MEJournal, used for replay.
+  class MEJournalReader final {
+  public:
+    explicit MEJournalReader(const std::string &file_name);
+
+    ~MEJournalReader();
+
+    auto size() const noexcept {
+      return num_records_;
+    }
+
+    auto at(size_t index) const noexcept -> const MEJournalRecord & {
+      return records_[index];
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    MEJournalReader() = delete;
+
+    MEJournalReader(const MEJournalReader &) = delete;
+
+    MEJournalReader(const MEJournalReader &&) = delete;
+
+    MEJournalReader &operator=(const MEJournalReader &) = delete;
+
+    MEJournalReader &operator=(const MEJournalReader &&) = delete;
+
+  private:
+    int fd_ = -1;
+    size_t file_size_ = 0;
+    void *data_ = nullptr;
+
+    const MEJournalRecord *records_ = nullptr;
+    size_t num_records_ = 0;
+  };
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "common/wire_protocol.h"
+
+#include "exchange/order_server/client_request.h"
+#include "exchange/order_server/client_response.h"
+
+namespace Exchange {
+  /// Order entry protocol spoken over TCP between the trading clients' order gateways and the order server.
+  /// Client requests and client responses are framed with the Common wire framing, sequence numbers are per client and per direction.
+  /// Session messages (rejects and resend requests) are not part of either sequenced stream, they are sent in frames of their own with sequence number 0.
+  /// Version 2 added the session messages, version 3 the MASS_CANCELED client response.
+  constexpr uint16_t ORDER_ENTRY_SCHEMA_ID = 1;
+  constexpr uint16_t ORDER_ENTRY_SCHEMA_VERSION = 3;
+
+  /// Sequence number of the frames carrying session messages.
+  constexpr uint64_t ORDER_SESSION_SEQ_NUM = 0;
+
+  /// Number of most recent messages each side of an order session keeps per client to retransmit on a resend request or a reject.
+  constexpr size_t ME_MAX_RETRANSMIT_MESSAGES = 1024;
+
+  /// Reason the order server rejected a client request or a resend request.
+  enum class SessionRejectReason : uint8_t {
+    INVALID = 0,
+    SEQ_NUM_GAP = 1,        // the request skipped ahead of the expected sequence number, resend from expected_seq_num_.
+    WRONG_SESSION = 2,      // the ClientId is already logged on over a different connection.
+    UNKNOWN_CLIENT = 3,     // the ClientId is not below ME_MAX_NUM_CLIENTS or is the reserved ClientId_WARMUP.
+    RESEND_UNAVAILABLE = 4, // the responses asked for are no longer kept for retransmission, expected_seq_num_ is the oldest one still available.
+    JOURNAL_FULL = 5        // the exchange's journal is full, the request was not sequenced and expected_seq_num_ is still expected.
+  };
+
+  inline std::string sessionRejectReasonToString(SessionRejectReason reason) {
+    switch (reason) {
+      case SessionRejectReason::SEQ_NUM_GAP:
+        return "SEQ_NUM_GAP";
+      case SessionRejectReason::WRONG_SESSION:
+        return "WRONG_SESSION";
+      case SessionRejectReason::UNKNOWN_CLIENT:
+        return "UNKNOWN_CLIENT";
+      case SessionRejectReason::RESEND_UNAVAILABLE:
+        return "RESEND_UNAVAILABLE";
+      case SessionRejectReason::JOURNAL_FULL:
+        return "JOURNAL_FULL";
+      case SessionRejectReason::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Fields are narrowed where the domain allows - ClientIds are below ME_MAX_NUM_CLIENTS, TickerIds index the InstrumentRegistry and prices are in ticks.
+  typedef uint16_t WireClientId;
+  typedef uint16_t WireTickerId;
+  typedef int32_t WirePrice;
+
+#pragma pack(push, 1)
+
+  /// Wire block of a client request.
+  struct WireClientRequest {
+    static constexpr uint8_t TEMPLATE_ID = 1;
+
+    ClientRequestType type_;
+    OrderType order_type_;
+    TimeInForce tif_;
+    Side side_;
+    WireClientId client_id_;
+    WireTickerId ticker_id_;
+    OrderId order_id_;
+    WirePrice price_;
+    Qty qty_;
+
+    auto encode(const MEClientRequest &request) noexcept {
+      type_ = request.type_;
+      order_type_ = request.order_type_;
+      tif_ = request.tif_;
+      side_ = request.side_;
+      client_id_ = narrowToWire<WireClientId>(request.client_id_, ClientId_INVALID);
+      ticker_id_ = narrowToWire<WireTickerId>(request.ticker_id_, TickerId_INVALID);
+      order_id_ = request.order_id_;
+      price_ = narrowToWire<WirePrice>(request.price_, Price_INVALID);
+      qty_ = request.qty_;
+    }
+
+    auto decode() const noexcept {
+      return MEClientRequest{type_, widenFromWire(client_id_, ClientId_INVALID), widenFromWire(ticker_id_, TickerId_INVALID), order_id_, side_,
+                             widenFromWire(price_, Price_INVALID), qty_, order_type_, tif_};
+    }
+  };
+
+  /// Wire block of a client response.
+  struct WireClientResponse {
+    static constexpr uint8_t TEMPLATE_ID = 2;
+
+    ClientResponseType type_;
+    Side side_;
+    bool last_in_batch_;
+    WireClientId client_id_;
+    WireTickerId ticker_id_;
+    OrderId client_order_id_;
+    OrderId market_order_id_;
+    WirePrice price_;
+    Qty exec_qty_;
+    Qty leaves_qty_;
+
+    auto encode(const MEClientResponse &response) noexcept {
+      type_ = response.type_;
+      side_ = response.side_;
+      last_in_batch_ = response.last_in_batch_;
+      client_id_ = narrowToWire<WireClientId>(response.client_id_, ClientId_INVALID);
+      ticker_id_ = narrowToWire<WireTickerId>(response.ticker_id_, TickerId_INVALID);
+      client_order_id_ = response.client_order_id_;
+      market_order_id_ = response.market_order_id_;
+      price_ = narrowToWire<WirePrice>(response.price_, Price_INVALID);
+      exec_qty_ = response.exec_qty_;
+      leaves_qty_ = response.leaves_qty_;
+    }
+
+    auto decode() const noexcept {
+      return MEClientResponse{type_, widenFromWire(client_id_, ClientId_INVALID), widenFromWire(ticker_id_, TickerId_INVALID), client_order_id_,
+                              market_order_id_, side_, widenFromWire(price_, Price_INVALID), exec_qty_, leaves_qty_, last_in_batch_};
+    }
+  };
+
+  /// Session message sent by the order server when it drops a client request or cannot serve a resend request.
+  struct WireSessionReject {
+    static constexpr uint8_t TEMPLATE_ID = 3;
+
+    SessionRejectReason reason_;
+    WireClientId client_id_;
+    uint64_t received_seq_num_;
+    uint64_t expected_seq_num_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireSessionReject"
+         << " ["
+         << "reason:" << sessionRejectReasonToString(reason_)
+         << " client:" << client_id_
+         << " received:" << received_seq_num_
+         << " expected:" << expected_seq_num_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Session message sent by the order gateway when it detects a gap in the client responses, asks for every response from from_seq_num_ onwards.
+  struct WireResendRequest {
+    static constexpr uint8_t TEMPLATE_ID = 4;
+
+    WireClientId client_id_;
+    uint64_t from_seq_num_;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "WireResendRequest"
+         << " ["
+         << "client:" << client_id_
+         << " from:" << from_seq_num_
+         << "]";
+      return ss.str();
+    }
+  };
+
+#pragma pack(pop) // Undo the packed binary structure directive moving forward.
+
+  static_assert(ME_MAX_NUM_CLIENTS <= std::numeric_limits<WireClientId>::max(), "ClientIds do not fit the order entry protocol.");
+
+  /// Largest number of client requests a single order entry frame can carry.
+  constexpr size_t ORDER_ENTRY_MAX_FRAME_REQUESTS = (WIRE_MAX_FRAME_SIZE - sizeof(WireFrameHeader)) / (sizeof(WireMessageHeader) + sizeof(WireClientRequest));
+}
@@ -1,15 +1,28 @@
 #include "order_server.h"
 
 namespace Exchange {
-  OrderServer::OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, const std::string &iface, int port)
-      : iface_(iface), port_(port), outgoing_responses_(client_responses), logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_order_server.log"),
-        tcp_server_(logger_), fifo_sequencer_(client_requests, &logger_) {
+  OrderServer::OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, MEJournal *journal, size_t max_pending_requests,
+                           bool split_rx_tx, int rx_core_id, int tx_core_id, Common::TCPBackend tcp_backend, const std::string &iface, int port)
+      : iface_(iface), port_(port), split_rx_tx_(split_rx_tx), rx_core_id_(rx_core_id), tx_core_id_(tx_core_id), outgoing_responses_(client_responses),
+        logger_("/home/praveen/omlaxmiquant/ida/logs/exchange_order_server.log"),
+        tx_logger_(split_rx_tx ? new Logger("/home/praveen/omlaxmiquant/ida/logs/exchange_order_server_tx.log") : &logger_),
+        session_events_(ME_MAX_SESSION_EVENTS), cid_sent_responses_(ME_MAX_NUM_CLIENTS * ME_MAX_RETRANSMIT_MESSAGES),
+        order_entry_encoder_(ORDER_ENTRY_SCHEMA_ID, ORDER_ENTRY_SCHEMA_VERSION, WIRE_MAX_FRAME_SIZE), tcp_server_(logger_, tcp_backend),
+        fifo_sequencer_(client_requests, journal, max_pending_requests, &logger_) {
+    ASSERT(max_pending_requests >= ORDER_ENTRY_MAX_FRAME_REQUESTS, "FIFOSequencer must have room for the largest order entry frame.");
+    ASSERT(!split_rx_tx || tcp_backend == Common::TCPBackend::EPOLL, "io_uring backends move all data on one thread and cannot split receiving and sending.");
+
     cid_next_outgoing_seq_num_.fill(1);
     cid_next_exp_seq_num_.fill(1);
+    cid_first_retransmit_seq_num_.fill(1);
+    cid_send_socket_.fill(nullptr);
     cid_tcp_socket_.fill(nullptr);
 
     tcp_server_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
     tcp_server_.recv_finished_callback_ = [this]() { recvFinishedCallback(); };
+    tcp_server_.disconnect_callback_ = [this](auto socket) { disconnectCallback(socket); };
+    if (split_rx_tx_)
+      tcp_server_.release_callback_ = [this](auto socket) { releaseCallback(socket); };
   }
 
   OrderServer::~OrderServer() {
@@ -17,14 +30,23 @@ namespace Exchange {
 
     using namespace std::literals::chrono_literals;
     std::this_thread::sleep_for(1s);
+
+    if (split_rx_tx_)
+      delete tx_logger_;
+    tx_logger_ = nullptr;
   }
 
-  /// Start and stop the order server main thread.
+  /// Start and stop the order server threads.
   auto OrderServer::start() -> void {
     run_ = true;
     tcp_server_.listen(iface_, port_);
 
-    ASSERT(Common::createAndStartThread(-1, "Exchange/OrderServer", [this]() { run(); }) != nullptr, "Failed to start OrderServer thread.");
+    if (split_rx_tx_) {
+      ASSERT(Common::createAndStartThread(tx_core_id_, "Exchange/OrderServerTx", [this]() { runTx(); }) != nullptr, "Failed to start OrderServer send thread.");
+      ASSERT(Common::createAndStartThread(rx_core_id_, "Exchange/OrderServerRx", [this]() { runRx(); }) != nullptr, "Failed to start OrderServer receive thread.");
+    } else {
+      ASSERT(Common::createAndStartThread(rx_core_id_, "Exchange/OrderServer", [this]() { run(); }) != nullptr, "Failed to start OrderServer thread.");
+    }
   }
 
   auto OrderServer::stop() -> void {
@@ -9,97 +9,391 @@
 #include "order_server/client_request.h"
 #include "order_server/client_response.h"
 #include "order_server/fifo_sequencer.h"
+#include "order_server/order_entry_protocol.h"
+#include "order_server/order_session_event.h"
 
 namespace Exchange {
   class OrderServer {
   public:
-    OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, const std::string &iface, int port);
+    /// Every sequenced client request is appended to journal before it is published to the matching engine, journal can be nullptr to disable journaling.
+    /// At most max_pending_requests client requests are read across all connections per poll, any more are left in the socket buffers until the next one,
+    /// it has to be at least ORDER_ENTRY_MAX_FRAME_REQUESTS so the largest frame fits.
+    /// With split_rx_tx client requests are received on a thread pinned to rx_core_id and client responses sent on another one pinned to tx_core_id,
+    /// otherwise a single thread pinned to rx_core_id does both.
+    /// tcp_backend selects how the client connections are accepted and their data moved, the io_uring backends need a single thread.
+    OrderServer(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses, MEJournal *journal, size_t max_pending_requests,
+                bool split_rx_tx, int rx_core_id, int tx_core_id, Common::TCPBackend tcp_backend, const std::string &iface, int port);
 
     ~OrderServer();
 
-    /// Start and stop the order server main thread.
+    /// Start and stop the order server threads.
     auto start() -> void;
 
     auto stop() -> void;
 
-    /// Main run loop for this thread - accepts new client connections, receives client requests from them and sends client responses to them.
+    /// Main run loop for the single thread - accepts new client connections, receives client requests from them and sends client responses to them.
     auto run() noexcept {
       logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
       while (run_) {
         tcp_server_.poll();
 
+        // Requests left behind when the FIFO sequencer was full are older than anything still to be read, so they go first.
+        if (UNLIKELY(!backlogged_sockets_.empty()))
+          resumeBackloggedSockets();
+
         tcp_server_.sendAndRecv();
 
-        for (auto client_response = outgoing_responses_->getNextToRead(); outgoing_responses_->size() && client_response; client_response = outgoing_responses_->getNextToRead()) {
-          TTT_MEASURE(T5t_OrderServer_LFQueue_read, logger_);
+        sendClientResponses();
+      }
+    }
+
+    /// Run loop of the receive thread - accepts new client connections, receives client requests from them and publishes them to the matching engine.
+    /// Never writes to the client connections, what the send thread needs to know about them is passed on as session events.
+    auto runRx() noexcept {
+      logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
+      while (run_) {
+        tcp_server_.poll();
 
-          auto &next_outgoing_seq_num = cid_next_outgoing_seq_num_[client_response->client_id_];
-          logger_.log("%:% %() % Processing cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
-                      client_response->client_id_, next_outgoing_seq_num, client_response->toString());
+        if (UNLIKELY(!backlogged_sockets_.empty()))
+          resumeBackloggedSockets();
 
-          ASSERT(cid_tcp_socket_[client_response->client_id_] != nullptr,
-                 "Dont have a TCPSocket for ClientId:" + std::to_string(client_response->client_id_));
-          START_MEASURE(Exchange_TCPSocket_send);
-          cid_tcp_socket_[client_response->client_id_]->send(&next_outgoing_seq_num, sizeof(next_outgoing_seq_num));
-          cid_tcp_socket_[client_response->client_id_]->send(client_response, sizeof(MEClientResponse));
-          END_MEASURE(Exchange_TCPSocket_send, logger_);
+        tcp_server_.recv();
+      }
+    }
 
-          outgoing_responses_->updateReadIndex();
-          TTT_MEASURE(T6t_OrderServer_TCP_write, logger_);
+    /// Run loop of the send thread - applies session events from the receive thread and sends client responses, so a burst of incoming
+    /// client requests does not hold back the responses and the other way around.
+    auto runTx() noexcept {
+      tx_logger_->log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&tx_time_str_));
+      while (run_) {
+        processSessionEvents();
 
-          ++next_outgoing_seq_num;
-        }
+        sendClientResponses();
+
+        flushSendSockets();
       }
     }
 
-    /// Read client request from the TCP receive buffer, check for sequence gaps and forward it to the FIFO sequencer.
-    auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept {
+    /// Resume the sequence numbers for a client after a restart, from the number of requests and responses already processed for it.
+    auto restoreSequenceNumbers(ClientId client_id, size_t num_requests, size_t num_responses) noexcept {
+      cid_next_exp_seq_num_.at(client_id) = num_requests + 1;
+      cid_next_outgoing_seq_num_.at(client_id) = num_responses + 1;
+      cid_first_retransmit_seq_num_.at(client_id) = num_responses + 1;
+    }
+
+    /// Decode client request and resend request frames from the TCP receive buffer.
+    /// If the FIFO sequencer cannot take a whole frame the rest of the frames are left in the receive buffer and the socket is paused until the sequencer has room again.
+    auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void {
       TTT_MEASURE(T1_OrderServer_TCP_read, logger_);
       logger_.log("%:% %() % Received socket:% len:% rx:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                   socket->socket_fd_, socket->next_rcv_valid_index_, rx_time);
 
-      if (socket->next_rcv_valid_index_ >= sizeof(OMClientRequest)) {
-        size_t i = 0;
-        for (; i + sizeof(OMClientRequest) <= socket->next_rcv_valid_index_; i += sizeof(OMClientRequest)) {
-          auto request = reinterpret_cast<const OMClientRequest *>(socket->inbound_data_.data() + i);
-          logger_.log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), request->toString());
+      const auto consumed = decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [&](const WireFrameHeader *frame) {
+        if (UNLIKELY(fifo_sequencer_.freeCapacity() < frame->num_messages_)) {
+          logger_.log("%:% %() % FIFOSequencer full, pausing socket:% with % bytes unread.\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), socket->socket_fd_, socket->next_rcv_valid_index_);
+          socket->recv_paused_ = true;
+          backlogged_sockets_.push_back({socket, rx_time});
+          return false;
+        }
 
-          if (UNLIKELY(cid_tcp_socket_[request->me_client_request_.client_id_] == nullptr)) { // first message from this ClientId.
-            cid_tcp_socket_[request->me_client_request_.client_id_] = socket;
+        forEachWireMessage(frame, ORDER_ENTRY_SCHEMA_ID, [&](size_t seq_num, const WireMessageHeader *message_header, const char *block) {
+          if (LIKELY(message_header->template_id_ == WireClientRequest::TEMPLATE_ID)) {
+            if (const auto wire_request = wireMessage<WireClientRequest>(message_header, block); LIKELY(wire_request)) {
+              onClientRequest(socket, rx_time, seq_num, wire_request->decode());
+              return;
+            }
+          } else if (const auto resend_request = wireMessage<WireResendRequest>(message_header, block); resend_request) {
+            onResendRequest(socket, resend_request);
+            return;
           }
 
-          if (cid_tcp_socket_[request->me_client_request_.client_id_] != socket) { // TODO - change this to send a reject back to the client.
-            logger_.log("%:% %() % Received ClientRequest from ClientId:% on different socket:% expected:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::getCurrentTimeStr(&time_str_), request->me_client_request_.client_id_, socket->socket_fd_,
-                        cid_tcp_socket_[request->me_client_request_.client_id_]->socket_fd_);
-            continue;
-          }
+          logger_.log("%:% %() % Ignoring template:% block_length:% seq:% on socket:%\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), static_cast<int>(message_header->template_id_),
+                      static_cast<int>(message_header->block_length_), seq_num, socket->socket_fd_);
+        });
+        return true;
+      });
 
-          auto &next_exp_seq_num = cid_next_exp_seq_num_[request->me_client_request_.client_id_];
-          if (request->seq_num_ != next_exp_seq_num) { // TODO - change this to send a reject back to the client.
-            logger_.log("%:% %() % Incorrect sequence number. ClientId:% SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::getCurrentTimeStr(&time_str_), request->me_client_request_.client_id_, next_exp_seq_num, request->seq_num_);
-            continue;
-          }
+      memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+      socket->next_rcv_valid_index_ -= consumed;
+    }
+
+    /// Check that a message for this ClientId can be accepted on this socket, the first message from a ClientId ties it to the socket.
+    /// Rejects the message and returns false if the ClientId is unknown, reserved for the matching engine or tied to a different socket.
+    auto checkSession(TCPSocket *socket, ClientId client_id, size_t seq_num) noexcept {
+      if (UNLIKELY(client_id >= cid_tcp_socket_.size() || client_id == ClientId_WARMUP)) {
+        sendSessionReject(socket, SessionRejectReason::UNKNOWN_CLIENT, client_id, seq_num, 0);
+        return false;
+      }
+
+      if (UNLIKELY(cid_tcp_socket_[client_id] == nullptr)) { // first message from this ClientId.
+        cid_tcp_socket_[client_id] = socket;
+        dispatchSessionEvent({OrderSessionEventType::BIND, socket, client_id});
+      }
 
-          ++next_exp_seq_num;
+      if (UNLIKELY(cid_tcp_socket_[client_id] != socket)) {
+        sendSessionReject(socket, SessionRejectReason::WRONG_SESSION, client_id, seq_num, cid_next_exp_seq_num_[client_id]);
+        return false;
+      }
+
+      return true;
+    }
+
+    /// Check a client request for sequence gaps and forward it to the FIFO sequencer.
+    /// A request ahead of the expected sequence number is rejected with the expected one so the client can resend from there,
+    /// a request behind it was already processed, e.g. the client resent more than was missing, and is dropped.
+    auto onClientRequest(TCPSocket *socket, Nanos rx_time, size_t seq_num, const MEClientRequest &request) noexcept -> void {
+      logger_.log("%:% %() % Received seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), seq_num, request.toString());
+
+      if (UNLIKELY(!checkSession(socket, request.client_id_, seq_num)))
+        return;
+
+      auto &next_exp_seq_num = cid_next_exp_seq_num_[request.client_id_];
+      if (UNLIKELY(seq_num != next_exp_seq_num)) {
+        if (seq_num > next_exp_seq_num)
+          sendSessionReject(socket, SessionRejectReason::SEQ_NUM_GAP, request.client_id_, seq_num, next_exp_seq_num);
+        else
+          logger_.log("%:% %() % Dropping duplicate ClientId:% SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), request.client_id_, next_exp_seq_num, seq_num);
+        return;
+      }
+
+      if (UNLIKELY(!fifo_sequencer_.canJournal())) { // the request would not fit in the journal, it is not sequenced.
+        sendSessionReject(socket, SessionRejectReason::JOURNAL_FULL, request.client_id_, seq_num, next_exp_seq_num);
+        return;
+      }
+
+      ++next_exp_seq_num;
+
+      // A price equal to the INVALID sentinel of the wire type cannot be told apart from a missing one, the request uses up its sequence number
+      // and is rejected by the matching engine so the client still gets a response for its order. Only a MARKET order is sent without a price.
+      if (UNLIKELY(((request.type_ == ClientRequestType::NEW && request.order_type_ != OrderType::MARKET) || request.type_ == ClientRequestType::MODIFY) &&
+                   request.price_ == Price_INVALID))
+        logger_.log("%:% %() % ERROR Price out of range, the request will be rejected. %\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), request.toString());
+
+      // CANCEL_ON_DISCONNECT is reserved for the order server, one sent by the client uses up its sequence number so it is sequenced as a MASS_CANCEL.
+      if (UNLIKELY(request.type_ == ClientRequestType::CANCEL_ON_DISCONNECT)) {
+        auto mass_cancel = request;
+        mass_cancel.type_ = ClientRequestType::MASS_CANCEL;
+        fifo_sequencer_.addClientRequest(rx_time, mass_cancel);
+        return;
+      }
+
+      START_MEASURE(Exchange_FIFOSequencer_addClientRequest);
+      fifo_sequencer_.addClientRequest(rx_time, request);
+      END_MEASURE(Exchange_FIFOSequencer_addClientRequest, logger_);
+    }
+
+    /// Ask for the client responses from the requested sequence number onwards to be retransmitted with their original sequence numbers.
+    auto onResendRequest(TCPSocket *socket, const WireResendRequest *resend_request) noexcept -> void {
+      logger_.log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), resend_request->toString());
 
-          START_MEASURE(Exchange_FIFOSequencer_addClientRequest);
-          fifo_sequencer_.addClientRequest(rx_time, request->me_client_request_);
-          END_MEASURE(Exchange_FIFOSequencer_addClientRequest, logger_);
+      const auto client_id = widenFromWire(resend_request->client_id_, ClientId_INVALID);
+      const size_t from_seq_num = resend_request->from_seq_num_;
+      if (UNLIKELY(!checkSession(socket, client_id, from_seq_num)))
+        return;
+
+      dispatchSessionEvent({OrderSessionEventType::RESEND, socket, client_id, SessionRejectReason::INVALID, 0, from_seq_num});
+    }
+
+    /// Ask for a session reject to be sent, in a frame of its own since it is not part of the sequenced client response stream.
+    auto sendSessionReject(TCPSocket *socket, SessionRejectReason reason, ClientId client_id, size_t received_seq_num, size_t expected_seq_num) noexcept -> void {
+      dispatchSessionEvent({OrderSessionEventType::REJECT, socket, client_id, reason, received_seq_num, expected_seq_num});
+    }
+
+    /// Hand a session event to the sending side, queued for the send thread with split_rx_tx and applied right away otherwise.
+    auto dispatchSessionEvent(const OrderSessionEvent &session_event) noexcept -> void {
+      if (!split_rx_tx_) {
+        processSessionEvent(session_event);
+        return;
+      }
+
+      logger_.log("%:% %() % Queueing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), session_event.toString());
+      auto next_write = session_events_.getNextToWriteTo();
+      *next_write = session_event;
+      session_events_.updateWriteIndex();
+    }
+
+    /// A client connection has been closed, cancel all the orders of every client on that connection so no stale orders are left resting.
+    /// The CANCEL_ON_DISCONNECT is sequenced like any other request, its type tells the matching engine it does not come from the client.
+    auto disconnectCallback(TCPSocket *socket) noexcept {
+      backlogged_sockets_.erase(std::remove_if(backlogged_sockets_.begin(), backlogged_sockets_.end(),
+                                               [socket](const auto &backlogged) { return backlogged.first == socket; }),
+                                backlogged_sockets_.end());
+
+      for (ClientId client_id = 0; client_id < cid_tcp_socket_.size(); ++client_id) {
+        if (cid_tcp_socket_[client_id] != socket)
+          continue;
+
+        logger_.log("%:% %() % ClientId:% disconnected socket:%, cancelling all orders.\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), client_id, socket->socket_fd_);
+        cid_tcp_socket_[client_id] = nullptr;
+        dispatchSessionEvent({OrderSessionEventType::UNBIND, socket, client_id});
+
+        const MEClientRequest cancel_on_disconnect{ClientRequestType::CANCEL_ON_DISCONNECT, client_id, TickerId_INVALID, OrderId_INVALID, Side::INVALID,
+                                                   Price_INVALID, Qty_INVALID};
+        if (UNLIKELY(!fifo_sequencer_.freeCapacity())) // a cancel-on-disconnect is never dropped, make room for it.
+          fifo_sequencer_.sequenceAndPublish();
+        if (UNLIKELY(!fifo_sequencer_.canJournalCancelOnDisconnect())) { // only once the records kept for these ran out.
+          logger_.log("%:% %() % ERROR Journal is full, the orders of ClientId:% are left resting.\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), client_id);
+          continue;
         }
-        memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
-        socket->next_rcv_valid_index_ -= i;
+        fifo_sequencer_.addClientRequest(getCurrentNanos(), cancel_on_disconnect);
       }
+
+      fifo_sequencer_.sequenceAndPublish();
+    }
+
+    /// With split_rx_tx the TCP server hands disconnected sockets over instead of destroying them, they are closed and destroyed by the send thread
+    /// once it has applied the UNBIND events before this so the socket file descriptor is not reused for a new connection while still being sent on.
+    auto releaseCallback(TCPSocket *socket) noexcept {
+      dispatchSessionEvent({OrderSessionEventType::CLOSE, socket, ClientId_INVALID});
     }
 
     /// End of reading incoming messages across all the TCP connections, sequence and publish the client requests to the matching engine.
-    auto recvFinishedCallback() noexcept {
+    auto recvFinishedCallback() noexcept -> void {
       START_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish);
       fifo_sequencer_.sequenceAndPublish();
       END_MEASURE(Exchange_FIFOSequencer_sequenceAndPublish, logger_);
     }
 
+    /// Hand the requests left in the receive buffers of paused sockets to the FIFO sequencer with their original receive times and publish them.
+    /// Sockets are resumed in the order they were paused, a socket is paused again if the sequencer fills up before its buffer is drained.
+    auto resumeBackloggedSockets() noexcept -> void {
+      const auto num_backlogged = backlogged_sockets_.size();
+      for (size_t i = 0; i < num_backlogged; ++i) {
+        const auto [socket, rx_time] = backlogged_sockets_[i];
+        socket->recv_paused_ = false;
+        recvCallback(socket, rx_time);
+      }
+      backlogged_sockets_.erase(backlogged_sockets_.begin(), backlogged_sockets_.begin() + num_backlogged);
+
+      recvFinishedCallback();
+    }
+
+    /// Apply the session events queued by the receive thread.
+    auto processSessionEvents() noexcept -> void {
+      for (auto session_event = session_events_.getNextToRead(); session_events_.size() && session_event; session_event = session_events_.getNextToRead()) {
+        processSessionEvent(*session_event);
+        session_events_.updateReadIndex();
+      }
+    }
+
+    /// Apply a session event to the sending side's per connection state.
+    auto processSessionEvent(const OrderSessionEvent &session_event) noexcept -> void {
+      tx_logger_->log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&tx_time_str_), session_event.toString());
+
+      switch (session_event.type_) {
+        case OrderSessionEventType::BIND:
+          cid_send_socket_[session_event.client_id_] = session_event.socket_;
+          break;
+        case OrderSessionEventType::UNBIND:
+          cid_send_socket_[session_event.client_id_] = nullptr;
+          break;
+        case OrderSessionEventType::REJECT: {
+          markForSend(session_event.socket_);
+          auto reject = order_entry_encoder_.append<WireSessionReject>(session_event.socket_, ORDER_SESSION_SEQ_NUM);
+          *reject = {session_event.reason_, narrowToWire<WireClientId>(session_event.client_id_, ClientId_INVALID), session_event.received_seq_num_,
+                     session_event.seq_num_};
+          tx_logger_->log("%:% %() % Sending % on socket:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&tx_time_str_),
+                          reject->toString(), session_event.socket_->socket_fd_);
+          break;
+        }
+        case OrderSessionEventType::RESEND:
+          retransmitClientResponses(session_event.socket_, session_event.client_id_, session_event.seq_num_);
+          break;
+        case OrderSessionEventType::CLOSE:
+          pending_send_sockets_.erase(std::remove(pending_send_sockets_.begin(), pending_send_sockets_.end(), session_event.socket_),
+                                      pending_send_sockets_.end());
+          close(session_event.socket_->socket_fd_);
+          delete session_event.socket_;
+          break;
+        case OrderSessionEventType::INVALID:
+          FATAL("Received invalid session event:" + session_event.toString());
+          break;
+      }
+    }
+
+    /// Retransmit the client responses from the requested sequence number onwards with their original sequence numbers, ahead of any new responses.
+    /// Rejected if some of them are no longer in the retransmit ring.
+    auto retransmitClientResponses(TCPSocket *socket, ClientId client_id, size_t from_seq_num) noexcept -> void {
+      const auto next_outgoing_seq_num = cid_next_outgoing_seq_num_[client_id];
+      const auto first_available_seq_num = std::max(cid_first_retransmit_seq_num_[client_id],
+                                                    next_outgoing_seq_num - std::min(next_outgoing_seq_num, ME_MAX_RETRANSMIT_MESSAGES));
+      if (UNLIKELY(from_seq_num < first_available_seq_num || from_seq_num > next_outgoing_seq_num)) {
+        processSessionEvent({OrderSessionEventType::REJECT, socket, client_id, SessionRejectReason::RESEND_UNAVAILABLE, from_seq_num, first_available_seq_num});
+        return;
+      }
+
+      markForSend(socket);
+      for (auto seq_num = from_seq_num; seq_num < next_outgoing_seq_num; ++seq_num) {
+        order_entry_encoder_.append<WireClientResponse>(socket, seq_num)->encode(cidSentResponse(client_id, seq_num));
+      }
+      tx_logger_->log("%:% %() % Retransmitted ClientId:% responses [%, %)\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&tx_time_str_),
+                      client_id, from_seq_num, next_outgoing_seq_num);
+    }
+
+    /// Slot of the retransmit ring holding the client response with this sequence number for this ClientId.
+    auto cidSentResponse(ClientId client_id, size_t seq_num) noexcept -> MEClientResponse & {
+      return cid_sent_responses_[client_id * ME_MAX_RETRANSMIT_MESSAGES + seq_num % ME_MAX_RETRANSMIT_MESSAGES];
+    }
+
+    /// Encode the client responses published by the matching engine into the send buffers of the client connections.
+    auto sendClientResponses() noexcept -> void {
+      // The matching engine publishes all responses for a client request as one batch, so this always drains whole batches and each
+      // client gets at most one TCP write per batch.
+      for (auto client_response = outgoing_responses_->getNextToRead(); outgoing_responses_->size() && client_response; client_response = outgoing_responses_->getNextToRead()) {
+        TTT_MEASURE(T5t_OrderServer_LFQueue_read, (*tx_logger_));
+
+        auto &next_outgoing_seq_num = cid_next_outgoing_seq_num_[client_response->client_id_];
+        tx_logger_->log("%:% %() % Processing cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&tx_time_str_),
+                        client_response->client_id_, next_outgoing_seq_num, client_response->toString());
+
+        // The BIND for the first request of a client is queued before the request is published, so it is visible by now even if it was not
+        // yet when the session events were last applied.
+        auto socket = cid_send_socket_[client_response->client_id_];
+        if (UNLIKELY(socket == nullptr && split_rx_tx_)) {
+          processSessionEvents();
+          socket = cid_send_socket_[client_response->client_id_];
+        }
+
+        // The client might have disconnected, e.g. responses to its cancel-on-disconnect, the sequence number is used up either way.
+        // Responses to the same client are batched into one frame until the send buffer is flushed.
+        if (LIKELY(socket != nullptr)) {
+          START_MEASURE(Exchange_TCPSocket_send);
+          markForSend(socket);
+          order_entry_encoder_.append<WireClientResponse>(socket, next_outgoing_seq_num)->encode(*client_response);
+          END_MEASURE(Exchange_TCPSocket_send, (*tx_logger_));
+        }
+
+        cidSentResponse(client_response->client_id_, next_outgoing_seq_num) = *client_response;
+
+        outgoing_responses_->updateReadIndex();
+        TTT_MEASURE(T6t_OrderServer_TCP_write, (*tx_logger_));
+
+        ++next_outgoing_seq_num;
+      }
+    }
+
+    /// Note that the socket is about to have data to send, with split_rx_tx the send thread flushes such sockets itself since the TCP server is not
+    /// sending on them, otherwise the next TCPServer::sendAndRecv() flushes every socket.
+    auto markForSend(TCPSocket *socket) noexcept -> void {
+      if (split_rx_tx_ && socket->next_send_valid_index_ == 0)
+        pending_send_sockets_.push_back(socket);
+    }
+
+    /// Publish the send buffers of the sockets written to since the last flush.
+    auto flushSendSockets() noexcept -> void {
+      for (auto socket: pending_send_sockets_) {
+        const auto n = socket->flush();
+        tx_logger_->log("%:% %() % send socket:% len:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&tx_time_str_), socket->socket_fd_, n);
+      }
+      pending_send_sockets_.clear();
+    }
+
     /// Deleted default, copy & move constructors and assignment-operators.
     OrderServer() = delete;
 
@@ -115,17 +409,49 @@ namespace Exchange {
     const std::string iface_;
     const int port_ = 0;
 
+    /// Whether client requests are received and client responses sent on separate threads, and the cores those threads are pinned to.
+    const bool split_rx_tx_ = false;
+    const int rx_core_id_ = -1;
+    const int tx_core_id_ = -1;
+
     /// Lock free queue of outgoing client responses to be sent out to connected clients.
     ClientResponseLFQueue *outgoing_responses_ = nullptr;
 
     volatile bool run_ = false;
 
+    /// Logger of the receive thread, or of the single thread without split_rx_tx.
     std::string time_str_;
     Logger logger_;
 
+    /// Logger of the send thread with split_rx_tx, the same as logger_ otherwise.
+    std::string tx_time_str_;
+    Logger *tx_logger_ = nullptr;
+
+    /// Session events from the receive thread to the send thread with split_rx_tx.
+    OrderSessionEventLFQueue session_events_;
+
+    /// State owned by the sending side.
+
     /// Hash map from ClientId -> the next sequence number to be sent on outgoing client responses.
     std::array<size_t, ME_MAX_NUM_CLIENTS> cid_next_outgoing_seq_num_;
 
+    /// Hash map from ClientId -> the first sequence number sent since the start, responses before it cannot be retransmitted.
+    std::array<size_t, ME_MAX_NUM_CLIENTS> cid_first_retransmit_seq_num_;
+
+    /// Hash map from ClientId -> ring of the last ME_MAX_RETRANSMIT_MESSAGES client responses sent, indexed by sequence number.
+    std::vector<MEClientResponse> cid_sent_responses_;
+
+    /// Hash map from ClientId -> TCP socket / client connection its client responses are sent on, kept in step with cid_tcp_socket_ by session events.
+    std::array<Common::TCPSocket *, ME_MAX_NUM_CLIENTS> cid_send_socket_;
+
+    /// Encodes client responses and session messages into order entry protocol frames in the send buffers of the client connections.
+    WireFrameEncoder order_entry_encoder_;
+
+    /// Sockets with data in their send buffers since the last flush with split_rx_tx.
+    std::vector<Common::TCPSocket *> pending_send_sockets_;
+
+    /// State owned by the receiving side.
+
     /// Hash map from ClientId -> the next sequence number expected on incoming client requests.
     std::array<size_t, ME_MAX_NUM_CLIENTS> cid_next_exp_seq_num_;
 
@@ -137,5 +463,8 @@ namespace Exchange {
 
     /// FIFO sequencer responsible for making sure incoming client requests are processed in the order in which they were received.
     FIFOSequencer fifo_sequencer_;
+
+    /// Sockets paused with unread requests because the FIFO sequencer was full, along with the receive time of that data, in the order they were paused.
+    std::vector<std::pair<Common::TCPSocket *, Nanos>> backlogged_sockets_;
   };
 }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <sstream>
+
+#include "common/types.h"
+#include "common/lf_queue.h"
+#include "common/tcp_socket.h"
+
+#include "order_server/order_entry_protocol.h"
+
+using namespace Common;
+
+namespace Exchange {
+  /// Maximum number of session events in flight from the order server's receive thread to its send thread.
+  constexpr size_t ME_MAX_SESSION_EVENTS = 64 * 1024;
+
+  /// Type of the change to a client connection made by the order server's receiving side which the sending side has to act on.
+  enum class OrderSessionEventType : uint8_t {
+    INVALID = 0,
+    BIND = 1,    // first message from the ClientId on the socket, its client responses are sent there from now on.
+    UNBIND = 2,  // the ClientId's socket disconnected, its client responses are not sent anywhere anymore.
+    REJECT = 3,  // send a session reject on the socket.
+    RESEND = 4,  // retransmit the ClientId's client responses from seq_num_ onwards on the socket.
+    CLOSE = 5    // the socket disconnected, close and destroy it since nothing will be sent on it anymore.
+  };
+
+  inline std::string orderSessionEventTypeToString(OrderSessionEventType type) {
+    switch (type) {
+      case OrderSessionEventType::BIND:
+        return "BIND";
+      case OrderSessionEventType::UNBIND:
+        return "UNBIND";
+      case OrderSessionEventType::REJECT:
+        return "REJECT";
+      case OrderSessionEventType::RESEND:
+        return "RESEND";
+      case OrderSessionEventType::CLOSE:
+        return "CLOSE";
+      case OrderSessionEventType::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Session event structure used internally by the order server, not sent over the network.
+  struct OrderSessionEvent {
+    OrderSessionEventType type_ = OrderSessionEventType::INVALID;
+    Common::TCPSocket *socket_ = nullptr;
+    ClientId client_id_ = ClientId_INVALID;
+
+    /// Only used by REJECT events.
+    SessionRejectReason reason_ = SessionRejectReason::INVALID;
+    size_t received_seq_num_ = 0;
+
+    /// Expected sequence number of REJECT events, first sequence number to retransmit of RESEND events.
+    size_t seq_num_ = 0;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "OrderSessionEvent"
+         << " ["
+         << "type:" << orderSessionEventTypeToString(type_)
+         << " socket:" << (socket_ ? socket_->socket_fd_ : -1)
+         << " client:" << clientIdToString(client_id_)
+         << " reason:" << sessionRejectReasonToString(reason_)
+         << " received:" << received_seq_num_
+         << " seq:" << seq_num_
+         << "]";
+      return ss.str();
+    }
+  };
+
+  /// Lock free queue of session events from the order server's receive thread to its send thread.
+  typedef LFQueue<OrderSessionEvent> OrderSessionEventLFQueue;
+}
@@ -0,0 +1,130 @@
+#include "common/tcp_server.h"
+#include "common/io_uring_tcp.h"
+
+/// Runs a TCPServer on the io_uring backend with two plain non-blocking clients. The server pauses the first connection while its client sends
+/// more than the whole provided buffer ring, then the second client has to keep getting its echoes, since the paused connection may only hold
+/// IO_URING_MAX_CONNECTION_BUFFERS of the buffers. Once resumed the paused connection has to receive everything its client sent, in order.
+
+static constexpr int port = 24430;
+
+/// Bytes the client of the paused connection sends, twice what the provided buffer ring holds.
+static constexpr size_t flood_size = 2 * Common::IO_URING_RECV_BUFFERS * Common::IO_URING_RECV_BUFFER_SIZE;
+
+/// Size of each message the client of the active connection sends and the server echoes back, and the number of them.
+static constexpr size_t message_size = 32;
+static constexpr size_t num_messages = 1000;
+
+/// The flooding client is considered blocked by flow control once it could not send anything for this long.
+static constexpr Common::Nanos blocked_timeout = Common::NANOS_TO_SECS / 2;
+
+/// Give up on an echo or on the rest of the flood not received this long after it was expected.
+static constexpr Common::Nanos timeout = 5 * Common::NANOS_TO_SECS;
+
+/// Byte at a position of the flood, a pattern which does not repeat at any power of 2 so out of order data is caught.
+static auto floodByte(size_t i) noexcept {
+  return static_cast<char>(i % 251);
+}
+
+static auto connectClient() {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT(fd >= 0 && !connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) && Common::setNonBlocking(fd) && Common::disableNagle(fd),
+         "Failed to connect to the server on port:" + std::to_string(port) + " error:" + std::string(std::strerror(errno)));
+  return fd;
+}
+
+int main(int, char **) {
+  Common::Logger logger("io_uring_paused_connection_test.log");
+  Common::TCPServer server(logger, Common::TCPBackend::IO_URING);
+
+  // The paused connection's data is checked against the flood pattern, the active connection's is echoed back.
+  Common::TCPSocket *paused_socket = nullptr;
+  size_t flood_received = 0;
+  server.recv_callback_ = [&](Common::TCPSocket *socket, Common::Nanos) {
+    if (socket == paused_socket) {
+      ASSERT(!socket->recv_paused_, "Called back for a paused socket.");
+      size_t i = 0;
+      while (i < socket->next_rcv_valid_index_ && socket->inbound_data_[i] == floodByte(flood_received + i))
+        ++i;
+      ASSERT(i == socket->next_rcv_valid_index_, "Flood data out of order at byte:" + std::to_string(flood_received + i));
+      flood_received += i;
+    } else {
+      socket->send(socket->inbound_data_.data(), socket->next_rcv_valid_index_);
+    }
+    socket->next_rcv_valid_index_ = 0;
+  };
+  server.recv_finished_callback_ = []() {};
+  server.listen("lo", port);
+
+  auto serverIteration = [&server]() {
+    server.poll();
+    server.sendAndRecv();
+  };
+
+  const auto flood_client = connectClient();
+  while (server.receive_sockets_.size() < 1)
+    serverIteration();
+  paused_socket = server.receive_sockets_.front();
+  paused_socket->recv_paused_ = true;
+
+  const auto active_client = connectClient();
+  while (server.receive_sockets_.size() < 2)
+    serverIteration();
+
+  // Send as much of the flood as the server takes while paused, the rest stays with the client once flow control pushes back on it.
+  std::vector<char> flood(flood_size);
+  for (size_t i = 0; i < flood_size; ++i)
+    flood[i] = floodByte(i);
+  size_t flood_sent = 0;
+  auto sendFlood = [&]() {
+    const auto n = ::send(flood_client, flood.data() + flood_sent, flood_size - flood_sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    ASSERT(n >= 0 || errno == EAGAIN || errno == EWOULDBLOCK, "Flood send failed error:" + std::string(std::strerror(errno)));
+    if (n > 0)
+      flood_sent += n;
+    return n > 0;
+  };
+  for (auto last_sent = Common::getCurrentNanos(); flood_sent < flood_size && Common::getCurrentNanos() - last_sent < blocked_timeout;) {
+    if (sendFlood())
+      last_sent = Common::getCurrentNanos();
+    serverIteration();
+  }
+  ASSERT(!flood_received, "Received " + std::to_string(flood_received) + " bytes on the paused connection.");
+
+  const char message[message_size] = {};
+  char echo[message_size * 4];
+  for (size_t i = 0; i < num_messages; ++i) {
+    ASSERT(::send(active_client, message, message_size, MSG_NOSIGNAL) == static_cast<ssize_t>(message_size), "Active client send failed.");
+    const auto start = Common::getCurrentNanos();
+    for (size_t received = 0; received < message_size;) {
+      ASSERT(Common::getCurrentNanos() - start < timeout, "Echo:" + std::to_string(i) + " not received in " + std::to_string(timeout) +
+                                                          " nanos with the paused connection holding " + std::to_string(flood_sent) + " bytes.");
+      serverIteration();
+      const auto n = ::recv(active_client, echo, sizeof(echo), MSG_DONTWAIT);
+      if (n > 0)
+        received += n;
+    }
+  }
+
+  std::cout << "Echoed " << num_messages << " messages on the active connection with " << flood_sent << " bytes sent to the paused one." << std::endl;
+
+  paused_socket->recv_paused_ = false;
+  for (auto last_progress = Common::getCurrentNanos(); flood_received < flood_size;) {
+    ASSERT(Common::getCurrentNanos() - last_progress < timeout, "Received " + std::to_string(flood_received) + " of " + std::to_string(flood_size) +
+                                                                " bytes on the resumed connection.");
+    const auto received = flood_received;
+    if (flood_sent < flood_size)
+      sendFlood();
+    serverIteration();
+    if (flood_received != received)
+      last_progress = Common::getCurrentNanos();
+  }
+
+  std::cout << "Received all " << flood_size << " bytes in order on the resumed connection." << std::endl;
+
+  close(flood_client);
+  close(active_client);
+  exit(EXIT_SUCCESS);
+}
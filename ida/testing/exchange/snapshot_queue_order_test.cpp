@@ -0,0 +1,122 @@
+#include <map>
+
+#include "matcher/matching_engine.h"
+#include "market_data/snapshot_synthesizer.h"
+
+/// Rests orders at a bid and an ask price, cancel-replaces some of them so they go to the back of their price level while keeping their
+/// market order ids, then rebuilds the book from an image of the snapshot service the way a consumer does, by appending each ADD to its price level.
+/// Every price level has to come back in the matching engine's queue order. Orders are told apart by their distinct quantities.
+
+static constexpr int snapshot_service_port = 24420;
+
+/// Give up on the image not received this long after asking for it.
+static constexpr Common::Nanos image_timeout = 5 * Common::NANOS_TO_SECS;
+
+int main(int, char **) {
+  Common::InstrumentRegistry instruments;
+  instruments.add("TEST", 64, 0);
+  const Exchange::MarketDataChannels channels = {{"233.252.14.3", 24422, "233.252.14.1", 24421}};
+
+  Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
+  Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
+  Exchange::MEMarketUpdateLFQueue market_updates(ME_MAX_MARKET_UPDATES);
+  Exchange::MDPMarketUpdateLFQueue snapshot_md_updates(ME_MAX_MARKET_UPDATES);
+  auto matching_engine = new Exchange::MatchingEngine(&client_requests, &client_responses, &market_updates, nullptr, &instruments, nullptr);
+
+  // Stands in for the market data publisher, sequences the matching engine's market updates on the instrument's channel for the snapshot synthesizer.
+  size_t inc_seq_num = 0;
+  auto process = [&](const Exchange::MEClientRequest &client_request) {
+    matching_engine->processClientRequest(&client_request);
+    matching_engine->publishBatch();
+
+    for (auto client_response = client_responses.getNextToRead(); client_response; client_response = client_responses.getNextToRead())
+      client_responses.updateReadIndex();
+    for (auto market_update = market_updates.getNextToRead(); market_update; market_update = market_updates.getNextToRead()) {
+      *snapshot_md_updates.getNextToWriteTo() = {++inc_seq_num, *market_update};
+      snapshot_md_updates.updateWriteIndex();
+      market_updates.updateReadIndex();
+    }
+  };
+
+  using Exchange::ClientRequestType;
+  using Common::Side;
+  process({ClientRequestType::NEW, 1, 0, 1, Side::BUY, 100, 10});
+  process({ClientRequestType::NEW, 1, 0, 2, Side::BUY, 100, 11});
+  process({ClientRequestType::NEW, 1, 0, 3, Side::BUY, 100, 12});
+  process({ClientRequestType::MODIFY, 1, 0, 1, Side::BUY, 100, 20}); // a quantity increase loses its priority.
+  process({ClientRequestType::MODIFY, 1, 0, 2, Side::BUY, 99, 11});  // a price change and back loses its priority.
+  process({ClientRequestType::MODIFY, 1, 0, 2, Side::BUY, 100, 11});
+  process({ClientRequestType::MODIFY, 1, 0, 3, Side::BUY, 100, 9});  // a quantity reduction keeps its priority.
+  process({ClientRequestType::NEW, 1, 0, 4, Side::SELL, 105, 30});
+  process({ClientRequestType::NEW, 1, 0, 5, Side::SELL, 105, 31});
+  process({ClientRequestType::MODIFY, 1, 0, 4, Side::SELL, 106, 30}); // not aggressive, published as a MODIFY of the same market order id.
+  process({ClientRequestType::MODIFY, 1, 0, 4, Side::SELL, 105, 30});
+
+  const std::map<std::pair<Side, Common::Price>, std::vector<Common::Qty>> expected_levels = {{{Side::BUY, 100}, {9, 20, 11}},
+                                                                                              {{Side::SELL, 105}, {31, 30}}};
+
+  // The updates are queued before the synthesizer starts, so its first loop iteration applies all of them before serving the request.
+  auto snapshot_synthesizer = new Exchange::SnapshotSynthesizer(&snapshot_md_updates, &instruments, "lo", channels, Common::MCAST_MTU_PACKET_SIZE,
+                                                                Common::NANOS_TO_SECS, 0, snapshot_service_port);
+  snapshot_synthesizer->start();
+
+  Common::Logger logger("snapshot_queue_order_test.log");
+  Common::TCPSocket socket(logger);
+  ASSERT(socket.connect("127.0.0.1", "lo", snapshot_service_port, false) >= 0,
+         "Failed to connect to the snapshot service on port:" + std::to_string(snapshot_service_port));
+
+  // Rebuild each price level by appending the image's ADDs to it, like the trading order book does.
+  std::map<std::pair<Side, Common::Price>, std::vector<Common::Qty>> levels;
+  size_t num_updates = 0;
+  bool received = false;
+  socket.recv_callback_ = [&](Common::TCPSocket *s, Common::Nanos) {
+    const auto consumed = Common::decodeWireFrames(s->inbound_data_.data(), s->next_rcv_valid_index_, [&](const Common::WireFrameHeader *frame) {
+      Common::forEachWireMessage(frame, Exchange::MARKET_DATA_SCHEMA_ID, [&](size_t, const Common::WireMessageHeader *message_header, const char *block) {
+        if (const auto response = Common::wireMessage<Exchange::WireSnapshotResponse>(message_header, block); response) {
+          ASSERT(response->status_ == Exchange::SnapshotStatus::OK && response->num_updates_ == num_updates, "Unexpected " + response->toString());
+          received = true;
+          return;
+        }
+
+        Exchange::MEMarketUpdate market_update;
+        ASSERT(Exchange::decodeMarketUpdate(message_header, block, &market_update),
+               "Unexpected template:" + std::to_string(static_cast<int>(message_header->template_id_)));
+        ++num_updates;
+        if (market_update.type_ == Exchange::MarketUpdateType::ADD)
+          levels[{market_update.side_, market_update.price_}].push_back(market_update.qty_);
+      });
+      return true;
+    });
+    memmove(s->inbound_data_.data(), s->inbound_data_.data() + consumed, s->next_rcv_valid_index_ - consumed);
+    s->next_rcv_valid_index_ -= consumed;
+  };
+
+  Common::WireFrameEncoder encoder(Exchange::MARKET_DATA_SCHEMA_ID, Exchange::MARKET_DATA_SCHEMA_VERSION, Common::WIRE_MAX_FRAME_SIZE);
+  *encoder.append<Exchange::WireSnapshotRequest>(&socket, Exchange::MD_SESSION_SEQ_NUM) =
+      {1, 0, Common::narrowToWire<Exchange::WireMDTickerId>(Common::TickerId_INVALID, Common::TickerId_INVALID)};
+
+  const auto request_time = Common::getCurrentNanos();
+  while (!received && Common::getCurrentNanos() - request_time < image_timeout)
+    socket.sendAndRecv();
+  ASSERT(received, "No snapshot image received in " + std::to_string(image_timeout) + " nanos.");
+
+  for (const auto &[level, qtys]: expected_levels) {
+    std::string rebuilt, expected;
+    for (const auto qty: levels[level])
+      rebuilt += Common::qtyToString(qty) + " ";
+    for (const auto qty: qtys)
+      expected += Common::qtyToString(qty) + " ";
+    ASSERT(levels[level] == qtys, Common::sideToString(level.first) + " " + Common::priceToString(level.second) + " rebuilt as [ " + rebuilt +
+                                  "] expected [ " + expected + "]");
+  }
+  ASSERT(levels.size() == expected_levels.size(), "Rebuilt " + std::to_string(levels.size()) + " price levels, expected " +
+                                                  std::to_string(expected_levels.size()));
+
+  std::cout << "Rebuilt every price level in queue order from the snapshot image." << std::endl;
+
+  // Not destroyed, its thread is not joined and could still be in its last loop iteration.
+  snapshot_synthesizer->stop();
+  delete matching_engine;
+
+  exit(EXIT_SUCCESS);
+}
@@ -141,7 +141,7 @@ std::string BinanceHttpClient::sendRequest(http::verb method,
         // Log the response status and body
         logger_.log("%:% %() % HTTP response: % % - Body: %\n", 
                   __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), 
-                  res.result_int(), res.reason(), res.body());
+                  res.result_int(), std::string(res.reason()), res.body());
         
         // Don't check shutdown errors - just log them
         beast::error_code ec;
@@ -157,7 +157,7 @@ std::string BinanceHttpClient::sendRequest(http::verb method,
         if (res.result() != http::status::ok) {
             logger_.log("%:% %() % HTTP request failed: % % %\n", 
                       __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), 
-                      res.result_int(), res.reason(), res.body());
+                      res.result_int(), std::string(res.reason()), res.body());
             throw std::runtime_error("HTTP error: " + std::to_string(res.result_int()) + " " + std::string(res.reason()));
         }
         
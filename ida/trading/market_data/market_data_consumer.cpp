@@ -3,172 +3,349 @@
 namespace Trading {
   MarketDataConsumer::MarketDataConsumer(Common::ClientId client_id, Exchange::MEMarketUpdateLFQueue *market_updates,
                                          const std::string &iface,
-                                         const std::string &snapshot_ip, int snapshot_port,
-                                         const std::string &incremental_ip, int incremental_port)
+                                         const Exchange::MarketDataChannels &channels, const std::vector<Common::ChannelId> &subscribed_channels,
+                                         const std::string &replay_ip, int replay_port,
+                                         const std::string &snapshot_service_ip, int snapshot_service_port)
       : incoming_md_updates_(market_updates), run_(false),
         logger_("/home/praveen/omlaxmiquant/ida/logs/trading_market_data_consumer_" + std::to_string(client_id) + ".log"),
-        incremental_mcast_socket_(logger_), snapshot_mcast_socket_(logger_),
-        iface_(iface), snapshot_ip_(snapshot_ip), snapshot_port_(snapshot_port) {
-    auto recv_callback = [this](auto socket) {
-      recvCallback(socket);
-    };
-
-    incremental_mcast_socket_.recv_callback_ = recv_callback;
-    ASSERT(incremental_mcast_socket_.init(incremental_ip, iface, incremental_port, /*is_listening*/ true) >= 0,
-           "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
-
-    ASSERT(incremental_mcast_socket_.join(incremental_ip),
-           "Join failed on:" + std::to_string(incremental_mcast_socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+        iface_(iface), replay_ip_(replay_ip), replay_port_(replay_port), replay_socket_(logger_),
+        snapshot_service_ip_(snapshot_service_ip), snapshot_service_port_(snapshot_service_port), snapshot_service_socket_(logger_),
+        session_encoder_(Exchange::MARKET_DATA_SCHEMA_ID, Exchange::MARKET_DATA_SCHEMA_VERSION, Common::WIRE_MAX_FRAME_SIZE),
+        subscribed_channels_(channels.size(), nullptr) {
+    for (const auto channel_id: subscribed_channels) {
+      ASSERT(channel_id < channels.size(), "Subscribed to unknown market data channel:" + Common::channelIdToString(channel_id));
+      ASSERT(!subscribed_channels_.at(channel_id), "Subscribed twice to market data channel:" + Common::channelIdToString(channel_id));
+
+      const auto &channel_info = channels.at(channel_id);
+      auto channel = subscribed_channels_.at(channel_id) = &channel_states_.emplace_back(channel_id, channel_info, logger_);
+      auto recv_callback = [this, channel](auto socket) {
+        recvCallback(channel, socket);
+      };
+
+      channel->incremental_mcast_socket_.recv_callback_ = recv_callback;
+      ASSERT(channel->incremental_mcast_socket_.init(channel_info.incremental_ip_, iface, channel_info.incremental_port_, /*is_listening*/ true) >= 0,
+             "Unable to create incremental mcast socket. error:" + std::string(std::strerror(errno)));
+
+      ASSERT(channel->incremental_mcast_socket_.join(channel_info.incremental_ip_),
+             "Join failed on:" + std::to_string(channel->incremental_mcast_socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+
+      channel->snapshot_mcast_socket_.recv_callback_ = recv_callback;
+    }
 
-    snapshot_mcast_socket_.recv_callback_ = recv_callback;
+    replay_socket_.recv_callback_ = [this](auto socket, auto rx_time) { replayRecvCallback(socket, rx_time); };
+    snapshot_service_socket_.recv_callback_ = [this](auto socket, auto rx_time) { snapshotServiceRecvCallback(socket, rx_time); };
   }
 
-  /// Main loop for this thread - reads and processes messages from the multicast sockets - the heavy lifting is in the recvCallback() and checkSnapshotSync() methods.
+  /// Main loop for this thread - reads and processes messages from the multicast sockets of every channel and the replay and snapshot services - the heavy lifting is in
+  /// the recvCallback(), checkSnapshotSync() and checkReplaySync() methods.
   auto MarketDataConsumer::run() noexcept -> void {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
     while (run_) {
-      incremental_mcast_socket_.sendAndRecv();
-      snapshot_mcast_socket_.sendAndRecv();
+      for (auto &channel: channel_states_) {
+        channel.incremental_mcast_socket_.sendAndRecv();
+        channel.snapshot_mcast_socket_.sendAndRecv();
+      }
+      replay_socket_.sendAndRecv();
+      snapshot_service_socket_.sendAndRecv();
+
+      for (auto &channel: channel_states_) {
+        if (UNLIKELY(channel.replay_pending_ && Common::getCurrentNanos() - channel.replay_request_time_ > MD_REPLAY_TIMEOUT)) {
+          logger_.log("%:% %() % Replay request on channel:% timed out, falling back to snapshot.\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), channel.channel_id_);
+          requestSnapshot(&channel);
+        }
+        if (UNLIKELY(channel.snapshot_request_pending_ && Common::getCurrentNanos() - channel.snapshot_request_time_ > MD_SNAPSHOT_REQUEST_TIMEOUT)) {
+          logger_.log("%:% %() % Snapshot request on channel:% timed out, falling back to snapshot stream.\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), channel.channel_id_);
+          startSnapshotSync(&channel);
+        }
+      }
     }
   }
 
-  /// Start the process of snapshot synchronization by subscribing to the snapshot multicast stream.
-  auto MarketDataConsumer::startSnapshotSync() -> void {
-    snapshot_queued_msgs_.clear();
-    incremental_queued_msgs_.clear();
+  /// Start the process of snapshot synchronization by subscribing to the channel's snapshot multicast stream.
+  auto MarketDataConsumer::startSnapshotSync(ChannelState *channel) -> void {
+    channel->snapshot_queued_msgs_.clear();
+    channel->incremental_queued_msgs_.clear();
+    channel->replay_recovery_ = channel->replay_pending_ = channel->snapshot_request_pending_ = false;
 
-    ASSERT(snapshot_mcast_socket_.init(snapshot_ip_, iface_, snapshot_port_, /*is_listening*/ true) >= 0,
+    ASSERT(channel->snapshot_mcast_socket_.init(channel->snapshot_ip_, iface_, channel->snapshot_port_, /*is_listening*/ true) >= 0,
            "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
-    ASSERT(snapshot_mcast_socket_.join(snapshot_ip_), // IGMP multicast subscription.
-           "Join failed on:" + std::to_string(snapshot_mcast_socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
+    ASSERT(channel->snapshot_mcast_socket_.join(channel->snapshot_ip_), // IGMP multicast subscription.
+           "Join failed on:" + std::to_string(channel->snapshot_mcast_socket_.socket_fd_) + " error:" + std::string(std::strerror(errno)));
   }
 
-  /// Check if a recovery / synchronization is possible from the queued up market data updates from the snapshot and incremental market data streams.
-  auto MarketDataConsumer::checkSnapshotSync() -> void {
-    if (snapshot_queued_msgs_.empty()) {
+  /// Check if a recovery / synchronization is possible from the queued up market data updates from the channel's snapshot and incremental streams.
+  /// The rings track how far their updates are contiguous, so this costs O(1) until a complete snapshot is queued, whose events are then applied
+  /// straight from the rings into the output queue.
+  auto MarketDataConsumer::checkSnapshotSync(ChannelState *channel) -> void {
+    auto &snapshot_msgs = channel->snapshot_queued_msgs_;
+    auto &incremental_msgs = channel->incremental_queued_msgs_;
+    if (snapshot_msgs.empty())
       return;
-    }
 
-    const auto &first_snapshot_msg = snapshot_queued_msgs_.begin()->second;
-    if (first_snapshot_msg.type_ != Exchange::MarketUpdateType::SNAPSHOT_START) {
-      logger_.log("%:% %() % Returning because have not seen a SNAPSHOT_START yet.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-      snapshot_queued_msgs_.clear();
+    const auto last_snapshot_msg = snapshot_msgs.find(snapshot_msgs.lastSeqNum());
+    if (last_snapshot_msg->type_ != Exchange::MarketUpdateType::SNAPSHOT_END)
       return;
-    }
-
-    std::vector<Exchange::MEMarketUpdate> final_events;
-
-    auto have_complete_snapshot = true;
-    size_t next_snapshot_seq = 0;
-    for (auto &snapshot_itr: snapshot_queued_msgs_) {
-      logger_.log("%:% %() % % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), snapshot_itr.first, snapshot_itr.second.toString());
-      if (snapshot_itr.first != next_snapshot_seq) {
-        have_complete_snapshot = false;
-        logger_.log("%:% %() % Detected gap in snapshot stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_), next_snapshot_seq, snapshot_itr.first, snapshot_itr.second.toString());
-        break;
-      }
 
-      if (snapshot_itr.second.type_ != Exchange::MarketUpdateType::SNAPSHOT_START &&
-          snapshot_itr.second.type_ != Exchange::MarketUpdateType::SNAPSHOT_END)
-        final_events.push_back(snapshot_itr.second);
-
-      ++next_snapshot_seq;
+    if (snapshot_msgs.runStartSeqNum() != 0) {
+      logger_.log("%:% %() % Detected gap in snapshot stream on channel:% before seq:%, waiting for the next snapshot.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), channel->channel_id_, snapshot_msgs.runStartSeqNum());
+      snapshot_msgs.clear();
+      return;
     }
 
-    if (!have_complete_snapshot) {
-      logger_.log("%:% %() % Returning because found gaps in snapshot stream.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-      snapshot_queued_msgs_.clear();
+    // The incremental updates after the snapshot have to continue from the one it is consistent with, up to the latest one received.
+    const auto snapshot_inc_seq_num = last_snapshot_msg->order_id_;
+    const auto have_incrementals = (!incremental_msgs.empty() && incremental_msgs.lastSeqNum() > snapshot_inc_seq_num);
+    if (have_incrementals && incremental_msgs.runStartSeqNum() > snapshot_inc_seq_num + 1) {
+      logger_.log("%:% %() % Detected gap in incremental stream on channel:% expected:% found:%, waiting for the next snapshot.\n", __FILE__, __LINE__,
+                  __FUNCTION__, Common::getCurrentTimeStr(&time_str_), channel->channel_id_, snapshot_inc_seq_num + 1, incremental_msgs.runStartSeqNum());
+      snapshot_msgs.clear();
       return;
     }
 
-    const auto &last_snapshot_msg = snapshot_queued_msgs_.rbegin()->second;
-    if (last_snapshot_msg.type_ != Exchange::MarketUpdateType::SNAPSHOT_END) {
-      logger_.log("%:% %() % Returning because have not seen a SNAPSHOT_END yet.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-      return;
+    for (auto seq_num = snapshot_msgs.runStartSeqNum() + 1; seq_num < snapshot_msgs.lastSeqNum(); ++seq_num) {
+      auto next_write = incoming_md_updates_->getNextToWriteTo();
+      *next_write = *snapshot_msgs.find(seq_num);
+      incoming_md_updates_->updateWriteIndex();
     }
 
-    auto have_complete_incremental = true;
+    channel->next_exp_inc_seq_num_ = snapshot_inc_seq_num + 1;
     size_t num_incrementals = 0;
-    next_exp_inc_seq_num_ = last_snapshot_msg.order_id_ + 1;
-    for (auto inc_itr = incremental_queued_msgs_.begin(); inc_itr != incremental_queued_msgs_.end(); ++inc_itr) {
-      logger_.log("%:% %() % Checking next_exp:% vs. seq:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), next_exp_inc_seq_num_, inc_itr->first, inc_itr->second.toString());
-
-      if (inc_itr->first < next_exp_inc_seq_num_)
-        continue;
-
-      if (inc_itr->first != next_exp_inc_seq_num_) {
-        logger_.log("%:% %() % Detected gap in incremental stream expected:% found:% %.\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_), next_exp_inc_seq_num_, inc_itr->first, inc_itr->second.toString());
-        have_complete_incremental = false;
-        break;
-      }
+    for (; have_incrementals && channel->next_exp_inc_seq_num_ <= incremental_msgs.lastSeqNum(); ++channel->next_exp_inc_seq_num_) {
+      auto next_write = incoming_md_updates_->getNextToWriteTo();
+      *next_write = *incremental_msgs.find(channel->next_exp_inc_seq_num_);
+      incoming_md_updates_->updateWriteIndex();
+      ++num_incrementals;
+    }
 
-      logger_.log("%:% %() % % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                  Common::getCurrentTimeStr(&time_str_), inc_itr->first, inc_itr->second.toString());
+    logger_.log("%:% %() % Recovered % snapshot and % incremental orders on channel:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), snapshot_msgs.lastSeqNum() - 1, num_incrementals, channel->channel_id_);
 
-      if (inc_itr->second.type_ != Exchange::MarketUpdateType::SNAPSHOT_START &&
-          inc_itr->second.type_ != Exchange::MarketUpdateType::SNAPSHOT_END)
-        final_events.push_back(inc_itr->second);
+    snapshot_msgs.clear();
+    incremental_msgs.clear();
+    channel->in_recovery_ = false;
 
-      ++next_exp_inc_seq_num_;
-      ++num_incrementals;
+    channel->snapshot_mcast_socket_.leave(channel->snapshot_ip_, channel->snapshot_port_);;
+  }
+
+  /// Queue up a message in the channel's *_queued_msgs_ rings, second parameter specifies if this update came from the snapshot or the incremental streams.
+  /// A snapshot cycle is only queued from its SNAPSHOT_START, with sequence number 0, on.
+  auto MarketDataConsumer::queueMessage(ChannelState *channel, bool is_snapshot, const Exchange::MDPMarketUpdate *request) {
+    if (is_snapshot) {
+      auto &snapshot_msgs = channel->snapshot_queued_msgs_;
+      if (request->seq_num_ == 0 || snapshot_msgs.find(request->seq_num_)) {
+        if (!snapshot_msgs.empty())
+          logger_.log("%:% %() % Snapshot cycle restarted on channel:% with % queued:%\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), channel->channel_id_, snapshot_msgs.lastSeqNum() + 1, request->toString());
+        snapshot_msgs.clear();
+      }
+
+      if (UNLIKELY(snapshot_msgs.empty() && request->me_market_update_.type_ != Exchange::MarketUpdateType::SNAPSHOT_START))
+        return;
+      if (UNLIKELY(request->seq_num_ >= snapshot_msgs.size())) {
+        logger_.log("%:% %() % Snapshot cycle on channel:% does not fit in % updates.\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), channel->channel_id_, snapshot_msgs.size());
+        snapshot_msgs.clear();
+        return;
+      }
+      snapshot_msgs.insert(request->seq_num_, request->me_market_update_);
+    } else {
+      channel->incremental_queued_msgs_.insert(request->seq_num_, request->me_market_update_);
     }
 
-    if (!have_complete_incremental) {
-      logger_.log("%:% %() % Returning because have gaps in queued incrementals.\n",
-                  __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-      snapshot_queued_msgs_.clear();
+    logger_.log("%:% %() % channel:% snapshot run:%-% incremental run:%-% % => %\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), channel->channel_id_,
+                channel->snapshot_queued_msgs_.runStartSeqNum(), channel->snapshot_queued_msgs_.lastSeqNum(),
+                channel->incremental_queued_msgs_.runStartSeqNum(), channel->incremental_queued_msgs_.lastSeqNum(), request->seq_num_, request->toString());
+
+    if (!channel->replay_recovery_ && !channel->snapshot_request_pending_)
+      checkSnapshotSync(channel);
+  }
+
+  /// Ask the replay service for the channel's incremental updates first_seq_num to last_seq_num, or recover from a snapshot if it cannot be reached.
+  auto MarketDataConsumer::requestReplay(ChannelState *channel, size_t first_seq_num, size_t last_seq_num) -> void {
+    if (UNLIKELY(replay_socket_.disconnected_)) {
+      logger_.log("%:% %() % Replay service disconnected, falling back to snapshot on channel:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), channel->channel_id_);
+      requestSnapshot(channel);
       return;
     }
 
-    for (const auto &itr: final_events) {
+    auto request = session_encoder_.append<Exchange::WireReplayRequest>(&replay_socket_, Exchange::MD_SESSION_SEQ_NUM);
+    *request = {channel->channel_id_, first_seq_num, last_seq_num};
+    channel->replay_recovery_ = channel->replay_pending_ = true;
+    channel->replay_request_time_ = Common::getCurrentNanos();
+
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), request->toString());
+  }
+
+  /// Process the replayed updates and replay responses read from the replay service.
+  /// Replayed updates are collected until the response after them, which says which channel they belong to and whether the replay covered the gap,
+  /// and are then queued with the channel's incremental ones.
+  auto MarketDataConsumer::replayRecvCallback(Common::TCPSocket *socket, Common::Nanos) noexcept -> void {
+    const auto consumed = Common::decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [&](const Common::WireFrameHeader *frame) {
+      Common::forEachWireMessage(frame, Exchange::MARKET_DATA_SCHEMA_ID, [&](size_t seq_num, const Common::WireMessageHeader *message_header, const char *block) {
+        if (const auto response = Common::wireMessage<Exchange::WireReplayResponse>(message_header, block); UNLIKELY(response)) {
+          const auto channel = (response->channel_id_ < subscribed_channels_.size() ? subscribed_channels_.at(response->channel_id_) : nullptr);
+          logger_.log("%:% %() % % pending:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), response->toString(),
+                      (channel && channel->replay_pending_));
+          if (!channel || !channel->replay_pending_) { // answer to a request which timed out.
+            replayed_updates_.clear();
+            return;
+          }
+
+          for (const auto &market_update: replayed_updates_) {
+            if (market_update.seq_num_ >= channel->next_exp_inc_seq_num_)
+              channel->incremental_queued_msgs_.insert(market_update.seq_num_, market_update.me_market_update_);
+          }
+          replayed_updates_.clear();
+
+          channel->replay_pending_ = false;
+          if (response->status_ == Exchange::ReplayStatus::OK) {
+            checkReplaySync(channel);
+          } else {
+            logger_.log("%:% %() % Replay of gap from seq:% on channel:% %, falling back to snapshot.\n", __FILE__, __LINE__, __FUNCTION__,
+                        Common::getCurrentTimeStr(&time_str_), channel->next_exp_inc_seq_num_, channel->channel_id_,
+                        Exchange::replayStatusToString(response->status_));
+            requestSnapshot(channel);
+          }
+          return;
+        }
+
+        Exchange::MEMarketUpdate market_update;
+        if (UNLIKELY(!Exchange::decodeMarketUpdate(message_header, block, &market_update))) {
+          logger_.log("%:% %() % Ignoring template:% block_length:% seq:% on replay socket\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), static_cast<int>(message_header->template_id_),
+                      static_cast<int>(message_header->block_length_), seq_num);
+          return;
+        }
+        replayed_updates_.push_back({seq_num, market_update});
+      });
+      return true;
+    });
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+    socket->next_rcv_valid_index_ -= consumed;
+  }
+
+  /// Forward the channel's queued incremental updates which continue from next_exp_inc_seq_num_ and end the recovery if there are no gaps left,
+  /// otherwise ask the replay service for the next gap.
+  auto MarketDataConsumer::checkReplaySync(ChannelState *channel) -> void {
+    auto &incremental_msgs = channel->incremental_queued_msgs_;
+    size_t num_forwarded = 0;
+    for (auto market_update = incremental_msgs.find(channel->next_exp_inc_seq_num_); market_update;
+         market_update = incremental_msgs.find(channel->next_exp_inc_seq_num_)) {
       auto next_write = incoming_md_updates_->getNextToWriteTo();
-      *next_write = itr;
+      *next_write = *market_update;
       incoming_md_updates_->updateWriteIndex();
+      ++channel->next_exp_inc_seq_num_;
+      ++num_forwarded;
     }
 
-    logger_.log("%:% %() % Recovered % snapshot and % incremental orders.\n", __FILE__, __LINE__, __FUNCTION__,
-                Common::getCurrentTimeStr(&time_str_), snapshot_queued_msgs_.size() - 2, num_incrementals);
+    if (!incremental_msgs.empty() && channel->next_exp_inc_seq_num_ <= incremental_msgs.lastSeqNum()) {
+      if (UNLIKELY(channel->next_exp_inc_seq_num_ < incremental_msgs.firstSeqNum())) { // the updates queued after the gap no longer fit in the ring.
+        logger_.log("%:% %() % Forwarded % updates, missing seq:% is older than the queued updates on channel:%, falling back to snapshot.\n", __FILE__,
+                    __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), num_forwarded, channel->next_exp_inc_seq_num_, channel->channel_id_);
+        requestSnapshot(channel);
+        return;
+      }
 
-    snapshot_queued_msgs_.clear();
-    incremental_queued_msgs_.clear();
-    in_recovery_ = false;
+      // Ask for everything up to the contiguous run at the end, updates queued between two gaps are replayed again rather than searched for.
+      const auto gap_end = incremental_msgs.runStartSeqNum();
+      logger_.log("%:% %() % Forwarded % updates, still missing seq:% to % on channel:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), num_forwarded, channel->next_exp_inc_seq_num_, gap_end - 1, channel->channel_id_);
+      requestReplay(channel, channel->next_exp_inc_seq_num_, gap_end - 1);
+      return;
+    }
 
-    snapshot_mcast_socket_.leave(snapshot_ip_, snapshot_port_);;
+    logger_.log("%:% %() % Recovered % queued incremental updates on channel:%.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                num_forwarded, channel->channel_id_);
+    incremental_msgs.clear();
+    channel->in_recovery_ = channel->replay_recovery_ = false;
   }
 
-  /// Queue up a message in the *_queued_msgs_ containers, first parameter specifies if this update came from the snapshot or the incremental streams.
-  auto MarketDataConsumer::queueMessage(bool is_snapshot, const Exchange::MDPMarketUpdate *request) {
-    if (is_snapshot) {
-      if (snapshot_queued_msgs_.find(request->seq_num_) != snapshot_queued_msgs_.end()) {
-        logger_.log("%:% %() % Packet drops on snapshot socket. Received for a 2nd time:%\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_), request->toString());
-        snapshot_queued_msgs_.clear();
-      }
-      snapshot_queued_msgs_[request->seq_num_] = request->me_market_update_;
-    } else {
-      incremental_queued_msgs_[request->seq_num_] = request->me_market_update_;
+  /// Ask the snapshot service for the book of every ticker on the channel, or start snapshot synchronization if it cannot be reached.
+  /// The incremental updates queued meanwhile are kept, the ones after the image are spliced on by checkReplaySync() once it arrives.
+  auto MarketDataConsumer::requestSnapshot(ChannelState *channel) -> void {
+    channel->replay_recovery_ = channel->replay_pending_ = false;
+    if (UNLIKELY(snapshot_service_socket_.disconnected_)) {
+      logger_.log("%:% %() % Snapshot service disconnected, falling back to snapshot stream on channel:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), channel->channel_id_);
+      startSnapshotSync(channel);
+      return;
     }
 
-    logger_.log("%:% %() % size snapshot:% incremental:% % => %\n", __FILE__, __LINE__, __FUNCTION__,
-                Common::getCurrentTimeStr(&time_str_), snapshot_queued_msgs_.size(), incremental_queued_msgs_.size(), request->seq_num_, request->toString());
+    auto request = session_encoder_.append<Exchange::WireSnapshotRequest>(&snapshot_service_socket_, Exchange::MD_SESSION_SEQ_NUM);
+    *request = {++last_snapshot_request_id_, channel->channel_id_,
+                Common::narrowToWire<Exchange::WireMDTickerId>(Common::TickerId_INVALID, Common::TickerId_INVALID)};
+    channel->snapshot_request_pending_ = true;
+    channel->snapshot_request_id_ = last_snapshot_request_id_;
+    channel->snapshot_request_time_ = Common::getCurrentNanos();
 
-    checkSnapshotSync();
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), request->toString());
   }
 
-  /// Process a market data update, the consumer needs to use the socket parameter to figure out whether this came from the snapshot or the incremental stream.
-  auto MarketDataConsumer::recvCallback(McastSocket *socket) noexcept -> void {
+  /// Process the image and snapshot responses read from the snapshot service.
+  /// The image is collected until the response after it, which says which channel's request it answers and which incremental sequence number
+  /// of that channel it is consistent with.
+  auto MarketDataConsumer::snapshotServiceRecvCallback(Common::TCPSocket *socket, Common::Nanos) noexcept -> void {
+    const auto consumed = Common::decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [&](const Common::WireFrameHeader *frame) {
+      Common::forEachWireMessage(frame, Exchange::MARKET_DATA_SCHEMA_ID, [&](size_t seq_num, const Common::WireMessageHeader *message_header, const char *block) {
+        if (const auto response = Common::wireMessage<Exchange::WireSnapshotResponse>(message_header, block); UNLIKELY(response)) {
+          const auto channel = (response->channel_id_ < subscribed_channels_.size() ? subscribed_channels_.at(response->channel_id_) : nullptr);
+          logger_.log("%:% %() % % pending:% request:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), response->toString(),
+                      (channel && channel->snapshot_request_pending_), (channel ? channel->snapshot_request_id_ : 0));
+          if (!channel || !channel->snapshot_request_pending_ || response->request_id_ != channel->snapshot_request_id_) { // answer to a request which timed out.
+            snapshot_image_.clear();
+            return;
+          }
+
+          channel->snapshot_request_pending_ = false;
+          if (response->status_ != Exchange::SnapshotStatus::OK || response->num_updates_ != snapshot_image_.size()) {
+            logger_.log("%:% %() % Snapshot of % updates not usable, falling back to snapshot stream on channel:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                        Common::getCurrentTimeStr(&time_str_), snapshot_image_.size(), channel->channel_id_);
+            snapshot_image_.clear();
+            startSnapshotSync(channel);
+            return;
+          }
+
+          for (const auto &market_update: snapshot_image_) {
+            auto next_write = incoming_md_updates_->getNextToWriteTo();
+            *next_write = market_update;
+            incoming_md_updates_->updateWriteIndex();
+          }
+          logger_.log("%:% %() % Recovered % snapshot updates at inc seq:% on channel:%.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                      snapshot_image_.size(), response->last_inc_seq_num_, channel->channel_id_);
+          snapshot_image_.clear();
+
+          channel->next_exp_inc_seq_num_ = response->last_inc_seq_num_ + 1;
+          checkReplaySync(channel);
+          return;
+        }
+
+        Exchange::MEMarketUpdate market_update;
+        if (UNLIKELY(!Exchange::decodeMarketUpdate(message_header, block, &market_update))) {
+          logger_.log("%:% %() % Ignoring template:% block_length:% seq:% on snapshot service socket\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), static_cast<int>(message_header->template_id_),
+                      static_cast<int>(message_header->block_length_), seq_num);
+          return;
+        }
+        snapshot_image_.push_back(market_update);
+      });
+      return true;
+    });
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+    socket->next_rcv_valid_index_ -= consumed;
+  }
+
+  /// Process a market data update read from one of the channel's sockets, the socket parameter tells whether it came from the snapshot or the incremental stream.
+  auto MarketDataConsumer::recvCallback(ChannelState *channel, McastSocket *socket) noexcept -> void {
     TTT_MEASURE(T7_MarketDataConsumer_UDP_read, logger_);
 
     START_MEASURE(Trading_MarketDataConsumer_recvCallback);
-    const auto is_snapshot = (socket->socket_fd_ == snapshot_mcast_socket_.socket_fd_);
-    if (UNLIKELY(is_snapshot && !in_recovery_)) { // market update was read from the snapshot market data stream and we are not in recovery, so we dont need it and discard it.
+    const auto is_snapshot = (socket->socket_fd_ == channel->snapshot_mcast_socket_.socket_fd_);
+    if (UNLIKELY(is_snapshot && !channel->in_recovery_)) { // market update was read from the snapshot market data stream and we are not in recovery, so we dont need it and discard it.
       socket->next_rcv_valid_index_ = 0;
 
       logger_.log("%:% %() % WARN Not expecting snapshot messages.\n",
@@ -177,40 +354,51 @@ namespace Trading {
       return;
     }
 
-    if (socket->next_rcv_valid_index_ >= sizeof(Exchange::MDPMarketUpdate)) {
-      size_t i = 0;
-      for (; i + sizeof(Exchange::MDPMarketUpdate) <= socket->next_rcv_valid_index_; i += sizeof(Exchange::MDPMarketUpdate)) {
-        auto request = reinterpret_cast<const Exchange::MDPMarketUpdate *>(socket->inbound_data_.data() + i);
+    const auto consumed = Common::decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [&](const Common::WireFrameHeader *frame) {
+      Common::forEachWireMessage(frame, Exchange::MARKET_DATA_SCHEMA_ID, [&](size_t seq_num, const Common::WireMessageHeader *message_header, const char *block) {
+        Exchange::MDPMarketUpdate update{seq_num, {}};
+        if (UNLIKELY(!Exchange::decodeMarketUpdate(message_header, block, &update.me_market_update_))) {
+          logger_.log("%:% %() % Ignoring template:% block_length:% seq:% on % socket\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), static_cast<int>(message_header->template_id_),
+                      static_cast<int>(message_header->block_length_), seq_num, (is_snapshot ? "snapshot" : "incremental"));
+          return;
+        }
+        const auto request = &update;
         logger_.log("%:% %() % Received % socket len:% %\n", __FILE__, __LINE__, __FUNCTION__,
                     Common::getCurrentTimeStr(&time_str_),
-                    (is_snapshot ? "snapshot" : "incremental"), sizeof(Exchange::MDPMarketUpdate), request->toString());
-
-        const bool already_in_recovery = in_recovery_;
-        in_recovery_ = (already_in_recovery || request->seq_num_ != next_exp_inc_seq_num_);
-
-        if (UNLIKELY(in_recovery_)) {
-          if (UNLIKELY(!already_in_recovery)) { // if we just entered recovery, start the snapshot synchonization process by subscribing to the snapshot multicast stream.
-            logger_.log("%:% %() % Packet drops on % socket. SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::getCurrentTimeStr(&time_str_), (is_snapshot ? "snapshot" : "incremental"), next_exp_inc_seq_num_, request->seq_num_);
-            startSnapshotSync();
+                    (is_snapshot ? "snapshot" : "incremental"), static_cast<int>(message_header->block_length_), request->toString());
+
+        const bool already_in_recovery = channel->in_recovery_;
+        channel->in_recovery_ = (already_in_recovery || request->seq_num_ != channel->next_exp_inc_seq_num_);
+
+        if (UNLIKELY(channel->in_recovery_)) {
+          if (UNLIKELY(!already_in_recovery)) { // if we just entered recovery, ask the replay service for the missing updates, or for a snapshot when joining mid-session.
+            logger_.log("%:% %() % Packet drops on % socket of channel:%. SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
+                        Common::getCurrentTimeStr(&time_str_), (is_snapshot ? "snapshot" : "incremental"), channel->channel_id_,
+                        channel->next_exp_inc_seq_num_, request->seq_num_);
+            if (request->seq_num_ > channel->next_exp_inc_seq_num_ && channel->next_exp_inc_seq_num_ > 1)
+              requestReplay(channel, channel->next_exp_inc_seq_num_, request->seq_num_ - 1);
+            else
+              requestSnapshot(channel);
           }
 
-          queueMessage(is_snapshot, request); // queue up the market data update message and check if snapshot recovery / synchronization can be completed successfully.
+          queueMessage(channel, is_snapshot, request); // queue up the market data update message and check if snapshot recovery / synchronization can be completed successfully.
         } else if (!is_snapshot) { // not in recovery and received a packet in the correct order and without gaps, process it.
           logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__,
                       Common::getCurrentTimeStr(&time_str_), request->toString());
 
-          ++next_exp_inc_seq_num_;
+          ++channel->next_exp_inc_seq_num_;
 
           auto next_write = incoming_md_updates_->getNextToWriteTo();
-          *next_write = std::move(request->me_market_update_);
+          *next_write = request->me_market_update_;
           incoming_md_updates_->updateWriteIndex();
           TTT_MEASURE(T8_MarketDataConsumer_LFQueue_write, logger_);
         }
-      }
-      memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
-      socket->next_rcv_valid_index_ -= i;
-    }
+      });
+      return true;
+    });
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+    socket->next_rcv_valid_index_ -= consumed;
     END_MEASURE(Trading_MarketDataConsumer_recvCallback, logger_);
   }
 }
@@ -1,21 +1,42 @@
 #pragma once
 
+#include <deque>
 #include <functional>
-#include <map>
 
 #include "common/thread_utils.h"
 #include "common/lf_queue.h"
 #include "common/macros.h"
 #include "common/mcast_socket.h"
+#include "common/tcp_socket.h"
 
 #include "exchange/market_data/market_update.h"
+#include "exchange/market_data/market_data_protocol.h"
+#include "exchange/market_data/market_data_channel.h"
+
+#include "recovery_ring.h"
 
 namespace Trading {
+  /// Give up on a replay request not answered this long after it was sent and recover from the snapshot stream instead.
+  constexpr Common::Nanos MD_REPLAY_TIMEOUT = 1 * Common::NANOS_TO_SECS;
+
+  /// Give up on a snapshot request not answered this long after it was sent and recover from the snapshot stream instead.
+  constexpr Common::Nanos MD_SNAPSHOT_REQUEST_TIMEOUT = 5 * Common::NANOS_TO_SECS;
+
+  /// Number of snapshot and incremental updates each channel queues while it recovers, a snapshot cycle of more updates is only recovered through
+  /// the snapshot service, as are incremental updates which arrived more than this many updates before the snapshot they are spliced on.
+  constexpr size_t MD_RECOVERY_RING_SIZE = Common::ME_MAX_MARKET_UPDATES;
+
   class MarketDataConsumer {
   public:
+    /// Only the incremental streams of the subscribed_channels out of the exchange's channels are received, each with its own sequence numbers,
+    /// and a gap on one of them only has that channel recovered.
+    /// Gaps on an incremental stream are recovered by asking the exchange's replay service at replay_ip:replay_port for the missing updates.
+    /// Joining mid-session, or if the replay service no longer has them, the channel's books are requested from the snapshot service at
+    /// snapshot_service_ip:snapshot_service_port, and recovered from the channel's snapshot stream only if that fails too.
     MarketDataConsumer(Common::ClientId client_id, Exchange::MEMarketUpdateLFQueue *market_updates, const std::string &iface,
-                       const std::string &snapshot_ip, int snapshot_port,
-                       const std::string &incremental_ip, int incremental_port);
+                       const Exchange::MarketDataChannels &channels, const std::vector<Common::ChannelId> &subscribed_channels,
+                       const std::string &replay_ip, int replay_port,
+                       const std::string &snapshot_service_ip, int snapshot_service_port);
 
     ~MarketDataConsumer() {
       stop();
@@ -27,6 +48,11 @@ namespace Trading {
     /// Start and stop the market data consumer main thread.
     auto start() {
       run_ = true;
+      ASSERT(replay_socket_.connect(replay_ip_, iface_, replay_port_, false) >= 0,
+             "Unable to connect to ip:" + replay_ip_ + " port:" + std::to_string(replay_port_) + " on iface:" + iface_ + " error:" + std::string(std::strerror(errno)));
+      ASSERT(snapshot_service_socket_.connect(snapshot_service_ip_, iface_, snapshot_service_port_, false) >= 0,
+             "Unable to connect to ip:" + snapshot_service_ip_ + " port:" + std::to_string(snapshot_service_port_) + " on iface:" + iface_ +
+             " error:" + std::string(std::strerror(errno)));
       ASSERT(Common::createAndStartThread(-1, "Trading/MarketDataConsumer", [this]() { run(); }) != nullptr, "Failed to start MarketData thread.");
     }
 
@@ -46,8 +72,43 @@ namespace Trading {
     MarketDataConsumer &operator=(const MarketDataConsumer &&) = delete;
 
   private:
-    /// Track the next expected sequence number on the incremental market data stream, used to detect gaps / drops.
-    size_t next_exp_inc_seq_num_ = 1;
+    /// Streams and recovery state of one subscribed market data channel.
+    struct ChannelState {
+      ChannelState(Common::ChannelId channel_id, const Exchange::MarketDataChannel &channel, Logger &logger)
+          : channel_id_(channel_id), incremental_mcast_socket_(logger), snapshot_mcast_socket_(logger),
+            snapshot_ip_(channel.snapshot_ip_), snapshot_port_(channel.snapshot_port_),
+            snapshot_queued_msgs_(MD_RECOVERY_RING_SIZE), incremental_queued_msgs_(MD_RECOVERY_RING_SIZE) {
+      }
+
+      const Common::ChannelId channel_id_;
+
+      /// Track the next expected sequence number on the channel's incremental stream, used to detect gaps / drops.
+      size_t next_exp_inc_seq_num_ = 1;
+
+      /// Multicast subscriber sockets for the channel's incremental and snapshot streams.
+      Common::McastSocket incremental_mcast_socket_, snapshot_mcast_socket_;
+
+      /// Tracks if we are currently in the process of recovering / synchronizing the channel either because we just started up or we dropped a packet.
+      bool in_recovery_ = false;
+
+      /// Information for the snapshot multicast stream.
+      const std::string snapshot_ip_;
+      const int snapshot_port_;
+
+      /// Set while the current recovery fills its gap from the replay service rather than the snapshot stream,
+      /// and while a replay request is outstanding together with when it was sent.
+      bool replay_recovery_ = false;
+      bool replay_pending_ = false;
+      Common::Nanos replay_request_time_ = 0;
+
+      /// Set while a snapshot request is outstanding, with its id and when it was sent.
+      bool snapshot_request_pending_ = false;
+      uint32_t snapshot_request_id_ = 0;
+      Common::Nanos snapshot_request_time_ = 0;
+
+      /// Rings to queue up market data updates from the snapshot and incremental streams by sequence number while recovering.
+      RecoveryRing snapshot_queued_msgs_, incremental_queued_msgs_;
+    };
 
     /// Lock free queue on which decoded market data updates are pushed to, to be consumed by the trade engine.
     Exchange::MEMarketUpdateLFQueue *incoming_md_updates_ = nullptr;
@@ -57,34 +118,61 @@ namespace Trading {
     std::string time_str_;
     Logger logger_;
 
-    /// Multicast subscriber sockets for the incremental and market data streams.
-    Common::McastSocket incremental_mcast_socket_, snapshot_mcast_socket_;
+    const std::string iface_;
+
+    /// Connection to the replay service.
+    const std::string replay_ip_;
+    const int replay_port_;
+    Common::TCPSocket replay_socket_;
 
-    /// Tracks if we are currently in the process of recovering / synchronizing with the snapshot market data stream either because we just started up or we dropped a packet.
-    bool in_recovery_ = false;
+    /// Connection to the snapshot service.
+    const std::string snapshot_service_ip_;
+    const int snapshot_service_port_;
+    Common::TCPSocket snapshot_service_socket_;
 
-    /// Information for the snapshot multicast stream.
-    const std::string iface_, snapshot_ip_;
-    const int snapshot_port_;
+    /// Encoder for the replay and snapshot requests.
+    Common::WireFrameEncoder session_encoder_;
 
-    /// Containers to queue up market data updates from the snapshot and incremental channels, queued up in order of increasing sequence numbers.
-    typedef std::map<size_t, Exchange::MEMarketUpdate> QueuedMarketUpdates;
-    QueuedMarketUpdates snapshot_queued_msgs_, incremental_queued_msgs_;
+    /// State of the subscribed channels, and a pointer to it indexed by ChannelId, nullptr for the channels not subscribed to.
+    std::deque<ChannelState> channel_states_;
+    std::vector<ChannelState *> subscribed_channels_;
+
+    /// The services answer the requests of every channel in order on one connection each, so the updates read before a response are the ones it answers:
+    /// the replayed updates and snapshot image received since the last response, and the id of the last snapshot request sent.
+    std::vector<Exchange::MDPMarketUpdate> replayed_updates_;
+    std::vector<Exchange::MEMarketUpdate> snapshot_image_;
+    uint32_t last_snapshot_request_id_ = 0;
 
   private:
-    /// Main loop for this thread - reads and processes messages from the multicast sockets - the heavy lifting is in the recvCallback() and checkSnapshotSync() methods.
+    /// Main loop for this thread - reads and processes messages from the multicast sockets of every channel - the heavy lifting is in the recvCallback() and checkSnapshotSync() methods.
     auto run() noexcept -> void;
 
-    /// Process a market data update, the consumer needs to use the socket parameter to figure out whether this came from the snapshot or the incremental stream.
-    auto recvCallback(McastSocket *socket) noexcept -> void;
+    /// Process a market data update read from one of the channel's sockets, the socket parameter tells whether it came from the snapshot or the incremental stream.
+    auto recvCallback(ChannelState *channel, McastSocket *socket) noexcept -> void;
+
+    /// Queue up a message in the channel's *_queued_msgs_ rings, second parameter specifies if this update came from the snapshot or the incremental streams.
+    auto queueMessage(ChannelState *channel, bool is_snapshot, const Exchange::MDPMarketUpdate *request);
+
+    /// Start the process of snapshot synchronization by subscribing to the channel's snapshot multicast stream.
+    auto startSnapshotSync(ChannelState *channel) -> void;
+
+    /// Check if a recovery / synchronization is possible from the queued up market data updates from the channel's snapshot and incremental streams.
+    auto checkSnapshotSync(ChannelState *channel) -> void;
+
+    /// Ask the replay service for the channel's incremental updates first_seq_num to last_seq_num, or recover from a snapshot if it cannot be reached.
+    auto requestReplay(ChannelState *channel, size_t first_seq_num, size_t last_seq_num) -> void;
+
+    /// Process the replayed updates and replay responses read from the replay service.
+    auto replayRecvCallback(Common::TCPSocket *socket, Common::Nanos rx_time) noexcept -> void;
 
-    /// Queue up a message in the *_queued_msgs_ containers, first parameter specifies if this update came from the snapshot or the incremental streams.
-    auto queueMessage(bool is_snapshot, const Exchange::MDPMarketUpdate *request);
+    /// Forward the channel's queued incremental updates which continue from next_exp_inc_seq_num_ and end the recovery if there are no gaps left,
+    /// otherwise ask the replay service for the next gap.
+    auto checkReplaySync(ChannelState *channel) -> void;
 
-    /// Start the process of snapshot synchronization by subscribing to the snapshot multicast stream.
-    auto startSnapshotSync() -> void;
+    /// Ask the snapshot service for the book of every ticker on the channel, or start snapshot synchronization if it cannot be reached.
+    auto requestSnapshot(ChannelState *channel) -> void;
 
-    /// Check if a recovery / synchronization is possible from the queued up market data updates from the snapshot and incremental market data streams.
-    auto checkSnapshotSync() -> void;
+    /// Process the image and snapshot responses read from the snapshot service.
+    auto snapshotServiceRecvCallback(Common::TCPSocket *socket, Common::Nanos rx_time) noexcept -> void;
   };
 }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "common/macros.h"
+
+#include "exchange/market_data/market_update.h"
+
+namespace Trading {
+  /// Market updates of one stream queued during a recovery, indexed by sequence number in a preallocated ring so queueing one costs O(1)
+  /// and never allocates.
+  /// The ring keeps the updates of the most recent size() sequence numbers up to lastSeqNum(), older ones are dropped as newer ones arrive,
+  /// and tracks where the contiguous run of updates ending at lastSeqNum() starts so the completeness of what is queued is known without walking it.
+  class RecoveryRing final {
+  public:
+    explicit RecoveryRing(size_t num_elems) :
+        store_(num_elems) /* pre-allocation of vector storage. */ {
+      ASSERT(num_elems > 0, "RecoveryRing needs room for at least one update.");
+    }
+
+    /// Forget every queued update in O(1), the slots of earlier generations are ignored rather than cleared.
+    auto clear() noexcept {
+      ++generation_;
+      empty_ = true;
+      last_seq_num_ = run_start_seq_num_ = 0;
+    }
+
+    auto empty() const noexcept {
+      return empty_;
+    }
+
+    auto size() const noexcept {
+      return store_.size();
+    }
+
+    /// Sequence number of the latest update queued, and the first one still in the ring.
+    auto lastSeqNum() const noexcept {
+      return last_seq_num_;
+    }
+
+    auto firstSeqNum() const noexcept {
+      return (last_seq_num_ >= store_.size() ? last_seq_num_ - store_.size() + 1 : 0);
+    }
+
+    /// First sequence number of the contiguous run of queued updates ending at lastSeqNum().
+    auto runStartSeqNum() const noexcept {
+      return run_start_seq_num_;
+    }
+
+    /// Queued update with sequence number seq_num, nullptr if it was not received or dropped from the ring.
+    auto find(size_t seq_num) const noexcept -> const Exchange::MEMarketUpdate * {
+      if (empty_ || seq_num > last_seq_num_ || seq_num < firstSeqNum())
+        return nullptr;
+
+      const auto &slot = store_[seq_num % store_.size()];
+      return (slot.generation_ == generation_ && slot.seq_num_ == seq_num ? &slot.market_update_ : nullptr);
+    }
+
+    /// Queue the update with sequence number seq_num, it is ignored if it is older than the updates kept in the ring.
+    auto insert(size_t seq_num, const Exchange::MEMarketUpdate &market_update) noexcept {
+      if (UNLIKELY(!empty_ && seq_num < firstSeqNum()))
+        return;
+
+      store_[seq_num % store_.size()] = {generation_, seq_num, market_update};
+
+      if (empty_ || seq_num > last_seq_num_) {
+        run_start_seq_num_ = (!empty_ && seq_num == last_seq_num_ + 1 ? run_start_seq_num_ : seq_num);
+        last_seq_num_ = seq_num;
+        empty_ = false;
+      }
+
+      // Updates older than the run's start fill a gap before it, the run grows back over every update already queued before them.
+      run_start_seq_num_ = std::max(run_start_seq_num_, firstSeqNum());
+      while (run_start_seq_num_ > 0 && find(run_start_seq_num_ - 1))
+        --run_start_seq_num_;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    RecoveryRing() = delete;
+
+    RecoveryRing(const RecoveryRing &) = delete;
+
+    RecoveryRing(const RecoveryRing &&) = delete;
+
+    RecoveryRing &operator=(const RecoveryRing &) = delete;
+
+    RecoveryRing &operator=(const RecoveryRing &&) = delete;
+
+  private:
+    /// A queued update, valid only if it was queued since the last clear() and is the latest update queued at its position.
+    struct Slot {
+      size_t generation_ = 0;
+      size_t seq_num_ = 0;
+      Exchange::MEMarketUpdate market_update_;
+    };
+
+    /// Underlying container of the updates, the one with sequence number n is at n % size().
+    std::vector<Slot> store_;
+
+    /// Generation of the updates queued since the last clear(), starting at 1 so the default constructed slots are never valid.
+    size_t generation_ = 1;
+
+    bool empty_ = true;
+    size_t last_seq_num_ = 0;
+    size_t run_start_seq_num_ = 0;
+  };
+}
@@ -1215,11 +1215,11 @@ void BinanceOrderGateway::processOrderUpdate(const nlohmann::json& order_update)
         }
         
         // Convert price from double to internal representation
-        Price internal_price = static_cast<Price>(price * Common::PriceMultiplier);
+        Price internal_price = static_cast<Price>(price * Binance::PriceMultiplier);
         
         // Convert quantities from double to internal representation
-        Qty internal_exec_qty = static_cast<Qty>(executed_qty * Common::QtyMultiplier);
-        Qty internal_leaves_qty = static_cast<Qty>(leaves_qty * Common::QtyMultiplier);
+        Qty internal_exec_qty = static_cast<Qty>(executed_qty * Binance::QtyMultiplier);
+        Qty internal_leaves_qty = static_cast<Qty>(leaves_qty * Binance::QtyMultiplier);
         
         // Determine the client response type based on the order status and execution type
         Exchange::ClientResponseType response_type = Exchange::ClientResponseType::ACCEPTED;
@@ -1234,12 +1234,12 @@ void BinanceOrderGateway::processOrderUpdate(const nlohmann::json& order_update)
             } else if (order_status == "PARTIALLY_FILLED") {
                 // Generate a FILL response for the executed portion
                 if (last_exec_qty > 0) {
-                    Qty last_exec_qty_internal = static_cast<Qty>(last_exec_qty * Common::QtyMultiplier);
-                    Price last_exec_price_internal = static_cast<Price>(last_exec_price * Common::PriceMultiplier);
+                    Qty last_exec_qty_internal = static_cast<Qty>(last_exec_qty * Binance::QtyMultiplier);
+                    Price last_exec_price_internal = static_cast<Price>(last_exec_price * Binance::PriceMultiplier);
                     
                     // If we have a partial fill, generate a separate fill response for just the executed portion
                     if (order_id > 0 && last_exec_qty_internal > 0) {
-                        generateAndEnqueueResponse(order_id, Exchange::ClientResponseType::FILL, ticker_id, side, 
+                        generateAndEnqueueResponse(order_id, Exchange::ClientResponseType::FILLED, ticker_id, side, 
                                                 last_exec_price_internal, last_exec_qty_internal, internal_leaves_qty);
                     }
                 }
@@ -1250,7 +1250,7 @@ void BinanceOrderGateway::processOrderUpdate(const nlohmann::json& order_update)
         } else if (exec_type == "CANCELED") {
             response_type = Exchange::ClientResponseType::CANCELED;
         } else if (exec_type == "REJECTED" || exec_type == "EXPIRED") {
-            response_type = Exchange::ClientResponseType::REJECTED;
+            response_type = Exchange::ClientResponseType::CANCELED;
         } else {
             // Handle order status if exec_type doesn't provide enough information
             if (order_status == "NEW") {
@@ -1262,7 +1262,7 @@ void BinanceOrderGateway::processOrderUpdate(const nlohmann::json& order_update)
             } else if (order_status == "CANCELED" || order_status == "EXPIRED") {
                 response_type = Exchange::ClientResponseType::CANCELED;
             } else if (order_status == "REJECTED") {
-                response_type = Exchange::ClientResponseType::REJECTED;
+                response_type = Exchange::ClientResponseType::CANCELED;
             }
         }
         
@@ -1347,12 +1347,10 @@ void BinanceOrderGateway::processAccountUpdate(const nlohmann::json& account_upd
             
             // Calculate portfolio value (if we have price information)
             double total_portfolio_value = 0.0;
-            double total_base_balance = 0.0;
             
             for (const auto& [asset, balance_info] : account_balances_) {
                 if (asset == config_.getQuoteAsset()) {
                     total_portfolio_value += balance_info.total;
-                    total_base_balance = balance_info.total;
                 } else {
                     // Try to estimate value using latest price information
                     double asset_price = getLatestMarketPrice(asset + config_.getQuoteAsset());
@@ -4,9 +4,11 @@ namespace Trading {
   OrderGateway::OrderGateway(ClientId client_id,
                              Exchange::ClientRequestLFQueue *client_requests,
                              Exchange::ClientResponseLFQueue *client_responses,
-                             std::string ip, const std::string &iface, int port)
+                             std::string ip, const std::string &iface, int port, Common::TCPBackend tcp_backend, Nanos resend_timeout)
       : client_id_(client_id), ip_(ip), iface_(iface), port_(port), outgoing_requests_(client_requests), incoming_responses_(client_responses),
-      logger_("/home/praveen/omlaxmiquant/ida/logs/trading_order_gateway_" + std::to_string(client_id) + ".log"), tcp_socket_(logger_) {
+      logger_("/home/praveen/omlaxmiquant/ida/logs/trading_order_gateway_" + std::to_string(client_id) + ".log"), tcp_socket_(logger_), tcp_backend_(tcp_backend),
+      order_entry_encoder_(Exchange::ORDER_ENTRY_SCHEMA_ID, Exchange::ORDER_ENTRY_SCHEMA_VERSION, Common::WIRE_MAX_FRAME_SIZE),
+      sent_requests_(Exchange::ME_MAX_RETRANSMIT_MESSAGES), resend_timeout_(resend_timeout) {
     tcp_socket_.recv_callback_ = [this](auto socket, auto rx_time) { recvCallback(socket, rx_time); };
   }
 
@@ -16,57 +18,166 @@ namespace Trading {
     while (run_) {
       tcp_socket_.sendAndRecv();
 
+      if (UNLIKELY(requests_resent_from_ || responses_requested_from_))
+        checkRecoveryTimeouts();
+
       for(auto client_request = outgoing_requests_->getNextToRead(); client_request; client_request = outgoing_requests_->getNextToRead()) {
         TTT_MEASURE(T11_OrderGateway_LFQueue_read, logger_);
 
-        logger_.log("%:% %() % Sending cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_), client_id_, next_outgoing_seq_num_, client_request->toString());
-        START_MEASURE(Trading_TCPSocket_send);
-        tcp_socket_.send(&next_outgoing_seq_num_, sizeof(next_outgoing_seq_num_));
-        tcp_socket_.send(client_request, sizeof(Exchange::MEClientRequest));
-        END_MEASURE(Trading_TCPSocket_send, logger_);
+        sendClientRequest(*client_request);
         outgoing_requests_->updateReadIndex();
         TTT_MEASURE(T12_OrderGateway_TCP_write, logger_);
+      }
+    }
+  }
+
+  /// Send a client request with the next outgoing sequence number and keep it for resending.
+  auto OrderGateway::sendClientRequest(const Exchange::MEClientRequest &client_request) noexcept -> void {
+    logger_.log("%:% %() % Sending cid:% seq:% %\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), client_id_, next_outgoing_seq_num_, client_request.toString());
+    START_MEASURE(Trading_TCPSocket_send);
+    order_entry_encoder_.append<Exchange::WireClientRequest>(&tcp_socket_, next_outgoing_seq_num_)->encode(client_request);
+    END_MEASURE(Trading_TCPSocket_send, logger_);
+    sent_requests_[next_outgoing_seq_num_ % sent_requests_.size()] = client_request;
+
+    next_outgoing_seq_num_++;
+  }
+
+  /// Ask the exchange to resend the client responses from the provided sequence number onwards.
+  auto OrderGateway::requestResponses(size_t from_seq_num) noexcept -> void {
+    *order_entry_encoder_.append<Exchange::WireResendRequest>(&tcp_socket_, Exchange::ORDER_SESSION_SEQ_NUM) =
+        {Common::narrowToWire<Exchange::WireClientId>(client_id_, ClientId_INVALID), from_seq_num};
+    responses_requested_from_ = from_seq_num;
+    responses_requested_time_ = Common::getCurrentNanos();
+  }
 
-        next_outgoing_seq_num_++;
+  /// Forget the recoveries which have not completed within resend_timeout_, so the next reject or out of sequence response starts them again.
+  /// A response recovery which is still stuck on the same gap is restarted right away since no further response might arrive to trigger it.
+  auto OrderGateway::checkRecoveryTimeouts() noexcept -> void {
+    const auto now = Common::getCurrentNanos();
+    if (requests_resent_from_ && now - requests_resent_time_ > resend_timeout_) {
+      logger_.log("%:% %() % Resend of requests from % timed out.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  requests_resent_from_);
+      requests_resent_from_ = 0;
+    }
+
+    if (responses_requested_from_ && now - responses_requested_time_ > resend_timeout_) {
+      if (responses_requested_from_ == next_exp_seq_num_) {
+        logger_.log("%:% %() % Resend of responses from % timed out, requesting it again.\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), responses_requested_from_);
+        requestResponses(next_exp_seq_num_);
+      } else {
+        responses_requested_from_ = 0;
       }
     }
   }
 
-  /// Callback when an incoming client response is read, we perform some checks and forward it to the lock free queue connected to the trade engine.
+  /// Callback when incoming order entry frames are read, client responses and session rejects are dispatched to the methods below.
   auto OrderGateway::recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void {
     TTT_MEASURE(T7t_OrderGateway_TCP_read, logger_);
 
     START_MEASURE(Trading_OrderGateway_recvCallback);
     logger_.log("%:% %() % Received socket:% len:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), socket->socket_fd_, socket->next_rcv_valid_index_, rx_time);
 
-    if (socket->next_rcv_valid_index_ >= sizeof(Exchange::OMClientResponse)) {
-      size_t i = 0;
-      for (; i + sizeof(Exchange::OMClientResponse) <= socket->next_rcv_valid_index_; i += sizeof(Exchange::OMClientResponse)) {
-        auto response = reinterpret_cast<const Exchange::OMClientResponse *>(socket->inbound_data_.data() + i);
-        logger_.log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), response->toString());
-
-        if(response->me_client_response_.client_id_ != client_id_) { // this should never happen unless there is a bug at the exchange.
-          logger_.log("%:% %() % ERROR Incorrect client id. ClientId expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
-                      Common::getCurrentTimeStr(&time_str_), client_id_, response->me_client_response_.client_id_);
-          continue;
-        }
-        if(response->seq_num_ != next_exp_seq_num_) { // this should never happen since we use a reliable TCP protocol, unless there is a bug at the exchange.
-          logger_.log("%:% %() % ERROR Incorrect sequence number. ClientId:%. SeqNum expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
-                      Common::getCurrentTimeStr(&time_str_), client_id_, next_exp_seq_num_, response->seq_num_);
-          continue;
+    const auto consumed = Common::decodeWireFrames(socket->inbound_data_.data(), socket->next_rcv_valid_index_, [this](const Common::WireFrameHeader *frame) {
+      Common::forEachWireMessage(frame, Exchange::ORDER_ENTRY_SCHEMA_ID, [this](size_t seq_num, const Common::WireMessageHeader *message_header, const char *block) {
+        if (LIKELY(message_header->template_id_ == Exchange::WireClientResponse::TEMPLATE_ID)) {
+          if (const auto wire_response = Common::wireMessage<Exchange::WireClientResponse>(message_header, block); LIKELY(wire_response)) {
+            onClientResponse(seq_num, wire_response->decode());
+            return;
+          }
+        } else if (const auto reject = Common::wireMessage<Exchange::WireSessionReject>(message_header, block); reject) {
+          onSessionReject(reject);
+          return;
         }
 
-        ++next_exp_seq_num_;
+        logger_.log("%:% %() % Ignoring template:% block_length:% seq:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                    static_cast<int>(message_header->template_id_), static_cast<int>(message_header->block_length_), seq_num);
+      });
+      return true;
+    });
+    memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + consumed, socket->next_rcv_valid_index_ - consumed);
+    socket->next_rcv_valid_index_ -= consumed;
+    END_MEASURE(Trading_OrderGateway_recvCallback, logger_);
+  }
 
-        auto next_write = incoming_responses_->getNextToWriteTo();
-        *next_write = std::move(response->me_client_response_);
-        incoming_responses_->updateWriteIndex();
-        TTT_MEASURE(T8t_OrderGateway_LFQueue_write, logger_);
+  /// Check a client response for gaps and forward it to the lock free queue connected to the trade engine.
+  /// On a gap the exchange is asked to resend the missing responses, duplicates of responses already forwarded are dropped.
+  auto OrderGateway::onClientResponse(size_t seq_num, const Exchange::MEClientResponse &response) noexcept -> void {
+    logger_.log("%:% %() % Received seq:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), seq_num, response.toString());
+
+    if(response.client_id_ != client_id_) { // this should never happen unless there is a bug at the exchange.
+      logger_.log("%:% %() % ERROR Incorrect client id. ClientId expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), client_id_, response.client_id_);
+      return;
+    }
+
+    if(UNLIKELY(seq_num != next_exp_seq_num_)) {
+      if(seq_num < next_exp_seq_num_) {
+        logger_.log("%:% %() % Dropping duplicate. ClientId:%. SeqNum expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), client_id_, next_exp_seq_num_, seq_num);
+      } else if(responses_requested_from_ != next_exp_seq_num_) {
+        logger_.log("%:% %() % Gap in responses, requesting resend. ClientId:%. SeqNum expected:% received:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), client_id_, next_exp_seq_num_, seq_num);
+        requestResponses(next_exp_seq_num_);
       }
-      memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
-      socket->next_rcv_valid_index_ -= i;
+      return;
     }
-    END_MEASURE(Trading_OrderGateway_recvCallback, logger_);
+
+    ++next_exp_seq_num_;
+    if(UNLIKELY(responses_requested_from_ && responses_requested_from_ < next_exp_seq_num_)) // the gap has been filled.
+      responses_requested_from_ = 0;
+
+    auto next_write = incoming_responses_->getNextToWriteTo();
+    *next_write = response;
+    incoming_responses_->updateWriteIndex();
+    TTT_MEASURE(T8t_OrderGateway_LFQueue_write, logger_);
+  }
+
+  /// Recover from a session reject, a sequence gap in the client requests is recovered by resending them from the expected sequence number.
+  auto OrderGateway::onSessionReject(const Exchange::WireSessionReject *reject) noexcept -> void {
+    logger_.log("%:% %() % Received %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_), reject->toString());
+
+    const size_t expected_seq_num = reject->expected_seq_num_;
+    if(reject->reason_ == Exchange::SessionRejectReason::RESEND_UNAVAILABLE) {
+      responses_requested_from_ = 0;
+      if(expected_seq_num <= next_exp_seq_num_) // asked for responses which were not sent yet, the next gap asks again.
+        return;
+
+      // The responses up to the oldest one still kept by the exchange are lost for good, their fills and cancels will never be known.
+      // Resume from the oldest one and cancel all of this client's orders, so no order the trade engine lost track of is left working.
+      // The trade engine learns about every order still live from the CANCELED responses, and an order it still thinks is live but is not
+      // gets a CANCEL_REJECTED or MODIFY_REJECTED the next time it is moved.
+      logger_.log("%:% %() % ERROR Responses [%, %) are lost. ClientId:%, cancelling all orders.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), next_exp_seq_num_, expected_seq_num, client_id_);
+      next_exp_seq_num_ = expected_seq_num;
+      requestResponses(next_exp_seq_num_);
+      sendClientRequest({Exchange::ClientRequestType::MASS_CANCEL, client_id_, TickerId_INVALID, OrderId_INVALID, Side::INVALID, Price_INVALID,
+                         Qty_INVALID, Exchange::OrderType::LIMIT, Exchange::TimeInForce::GTC});
+      return;
+    }
+
+    if(reject->reason_ != Exchange::SessionRejectReason::SEQ_NUM_GAP) { // nothing to recover here, the session has to be reset.
+      logger_.log("%:% %() % ERROR Session rejected. ClientId:% reason:%.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  client_id_, Exchange::sessionRejectReasonToString(reject->reason_));
+      return;
+    }
+
+    if(expected_seq_num == requests_resent_from_) // already resent, this reject was for a request sent before the resend arrived.
+      return;
+
+    if(expected_seq_num >= next_outgoing_seq_num_ || next_outgoing_seq_num_ - expected_seq_num > sent_requests_.size()) {
+      logger_.log("%:% %() % ERROR Cannot resend requests. ClientId:% expected:% next:%.\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), client_id_, expected_seq_num, next_outgoing_seq_num_);
+      return;
+    }
+
+    for(auto seq_num = expected_seq_num; seq_num < next_outgoing_seq_num_; ++seq_num) {
+      order_entry_encoder_.append<Exchange::WireClientRequest>(&tcp_socket_, seq_num)->encode(sent_requests_[seq_num % sent_requests_.size()]);
+    }
+    requests_resent_from_ = expected_seq_num;
+    requests_resent_time_ = Common::getCurrentNanos();
+    logger_.log("%:% %() % Resent requests [%, %).\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                expected_seq_num, next_outgoing_seq_num_);
   }
 }
@@ -5,9 +5,11 @@
 #include "common/thread_utils.h"
 #include "common/macros.h"
 #include "common/tcp_server.h"
+#include "common/io_uring_tcp.h"
 
 #include "exchange/order_server/client_request.h"
 #include "exchange/order_server/client_response.h"
+#include "exchange/order_server/order_entry_protocol.h"
 
 namespace Trading {
   class OrderGateway {
@@ -15,13 +17,16 @@ namespace Trading {
     OrderGateway(ClientId client_id,
                  Exchange::ClientRequestLFQueue *client_requests,
                  Exchange::ClientResponseLFQueue *client_responses,
-                 std::string ip, const std::string &iface, int port);
+                 std::string ip, const std::string &iface, int port, Common::TCPBackend tcp_backend, Nanos resend_timeout);
 
     ~OrderGateway() {
       stop();
 
       using namespace std::literals::chrono_literals;
       std::this_thread::sleep_for(5s);
+
+      delete io_uring_;
+      io_uring_ = nullptr;
     }
 
     /// Start and stop the order gateway main thread.
@@ -29,6 +34,10 @@ namespace Trading {
       run_ = true;
       ASSERT(tcp_socket_.connect(ip_, iface_, port_, false) >= 0,
              "Unable to connect to ip:" + ip_ + " port:" + std::to_string(port_) + " on iface:" + iface_ + " error:" + std::string(std::strerror(errno)));
+      if (tcp_backend_ != Common::TCPBackend::EPOLL) {
+        io_uring_ = new Common::IoUringTCP(logger_, tcp_backend_ == Common::TCPBackend::IO_URING_SQPOLL);
+        io_uring_->addSocket(&tcp_socket_);
+      }
       ASSERT(Common::createAndStartThread(-1, "Trading/OrderGateway", [this]() { run(); }) != nullptr, "Failed to start OrderGateway thread.");
     }
 
@@ -70,14 +79,50 @@ namespace Trading {
     size_t next_outgoing_seq_num_ = 1;
     size_t next_exp_seq_num_ = 1;
 
-    /// TCP connection to the exchange's order server.
+    /// TCP connection to the exchange's order server, and the io_uring moving its data with the io_uring backends.
     Common::TCPSocket tcp_socket_;
+    const Common::TCPBackend tcp_backend_;
+    Common::IoUringTCP *io_uring_ = nullptr;
+
+    /// Encodes client requests into order entry protocol frames in the TCP send buffer, requests sent in one loop iteration share a frame.
+    Common::WireFrameEncoder order_entry_encoder_;
+
+    /// Ring of the last ME_MAX_RETRANSMIT_MESSAGES client requests sent, indexed by sequence number, resent when the exchange reports a gap.
+    std::vector<Exchange::MEClientRequest> sent_requests_;
+
+    /// Sequence number the client requests were last resent from and the client responses were last asked to be resent from,
+    /// so a gap is only recovered once while the rejects and responses sent before the recovery are still arriving. 0 if no recovery is pending.
+    size_t requests_resent_from_ = 0;
+    size_t responses_requested_from_ = 0;
+
+    /// Times of the last resend of client requests and of the last resend request for client responses,
+    /// a recovery which has not completed resend_timeout_ later is started again.
+    Nanos requests_resent_time_ = 0;
+    Nanos responses_requested_time_ = 0;
+    const Nanos resend_timeout_ = 0;
 
   private:
     /// Main thread loop - sends out client requests to the exchange and reads and dispatches incoming client responses.
     auto run() noexcept -> void;
 
-    /// Callback when an incoming client response is read, we perform some checks and forward it to the lock free queue connected to the trade engine.
+    /// Callback when incoming order entry frames are read, client responses and session rejects are dispatched to the methods below.
     auto recvCallback(TCPSocket *socket, Nanos rx_time) noexcept -> void;
+
+    /// Check a client response for gaps and forward it to the lock free queue connected to the trade engine.
+    /// On a gap the exchange is asked to resend the missing responses, duplicates of responses already forwarded are dropped.
+    auto onClientResponse(size_t seq_num, const Exchange::MEClientResponse &response) noexcept -> void;
+
+    /// Recover from a session reject, a sequence gap in the client requests is recovered by resending them from the expected sequence number
+    /// and client responses which are no longer available are skipped after cancelling all the orders they could have been for.
+    auto onSessionReject(const Exchange::WireSessionReject *reject) noexcept -> void;
+
+    /// Send a client request with the next outgoing sequence number and keep it for resending.
+    auto sendClientRequest(const Exchange::MEClientRequest &client_request) noexcept -> void;
+
+    /// Ask the exchange to resend the client responses from the provided sequence number onwards.
+    auto requestResponses(size_t from_seq_num) noexcept -> void;
+
+    /// Forget the recoveries which have not completed within resend_timeout_, so the next reject or out of sequence response starts them again.
+    auto checkRecoveryTimeouts() noexcept -> void;
   };
 }
@@ -28,6 +28,7 @@ namespace Trading {
     }
 
     /// Process a trade event and in this case compute the feature to capture aggressive trade quantity ratio against the BBO quantity.
+    /// For a TRADE_SUMMARY the quantity is the whole sweep and the BBO is still the one from before the sweep, so the ratio exceeds 1 when levels beyond the top were taken.
     auto onTradeUpdate(const Exchange::MEMarketUpdate *market_update, MarketOrderBook* book) noexcept -> void {
       const auto bbo = book->getBBO();
       if(LIKELY(bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID)) {
@@ -39,11 +39,16 @@ namespace Trading {
         const auto threshold = ticker_cfg_.at(market_update->ticker_id_).threshold_;
 
         if (agg_qty_ratio >= threshold) {
+          // Aggressive orders are sent as IOC, so any quantity not matched is cancelled by the exchange instead of resting in the book.
+          // A TRADE_SUMMARY arrives before the book is updated for the sweep and carries the best price left on the passive side, so follow that instead of the old BBO.
+          const auto is_summary = (market_update->type_ == Exchange::MarketUpdateType::TRADE_SUMMARY);
           START_MEASURE(Trading_OrderManager_moveOrders);
           if (market_update->side_ == Side::BUY)
-            order_manager_->moveOrders(market_update->ticker_id_, bbo->ask_price_, Price_INVALID, clip);
+            order_manager_->moveOrders(market_update->ticker_id_, (is_summary ? market_update->price_ : bbo->ask_price_), Price_INVALID, clip,
+                                       Exchange::TimeInForce::IOC);
           else
-            order_manager_->moveOrders(market_update->ticker_id_, Price_INVALID, bbo->bid_price_, clip);
+            order_manager_->moveOrders(market_update->ticker_id_, Price_INVALID, (is_summary ? market_update->price_ : bbo->bid_price_), clip,
+                                       Exchange::TimeInForce::IOC);
           END_MEASURE(Trading_OrderManager_moveOrders, (*logger_));
         }
       }
@@ -36,7 +36,7 @@ namespace Trading {
         const auto ask_price = bbo->ask_price_ + (bbo->ask_price_ - fair_price >= threshold ? 0 : 1);
 
         START_MEASURE(Trading_OrderManager_moveOrders);
-        order_manager_->moveOrders(ticker_id, bid_price, ask_price, clip);
+        order_manager_->moveOrders(ticker_id, bid_price, ask_price, clip, Exchange::TimeInForce::GTC);
         END_MEASURE(Trading_OrderManager_moveOrders, (*logger_));
       }
     }
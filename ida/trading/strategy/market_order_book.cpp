@@ -18,8 +18,8 @@ namespace Trading {
 
   /// Process market data update and update the limit order book.
   auto MarketOrderBook::onMarketUpdate(const Exchange::MEMarketUpdate *market_update) noexcept -> void {
-    const auto bid_updated = (bids_by_price_ && market_update->side_ == Side::BUY && market_update->price_ >= bids_by_price_->price_);
-    const auto ask_updated = (asks_by_price_ && market_update->side_ == Side::SELL && market_update->price_ <= asks_by_price_->price_);
+    auto bid_updated = (bids_by_price_ && market_update->side_ == Side::BUY && market_update->price_ >= bids_by_price_->price_);
+    auto ask_updated = (asks_by_price_ && market_update->side_ == Side::SELL && market_update->price_ <= asks_by_price_->price_);
 
     switch (market_update->type_) {
       case Exchange::MarketUpdateType::ADD: {
@@ -32,7 +32,22 @@ namespace Trading {
         break;
       case Exchange::MarketUpdateType::MODIFY: {
         auto order = oid_to_order_.at(market_update->order_id_);
-        order->qty_ = market_update->qty_;
+        if (LIKELY(order->price_ == market_update->price_ && order->priority_ == market_update->priority_)) {
+          order->qty_ = market_update->qty_;
+        } else { // order was re-prioritized by a cancel-replace, move it to the back of the FIFO queue at its new price.
+          bid_updated |= (order->side_ == Side::BUY && order->price_ >= bids_by_price_->price_);
+          ask_updated |= (order->side_ == Side::SELL && order->price_ <= asks_by_price_->price_);
+
+          START_MEASURE(Trading_MarketOrderBook_removeOrder);
+          removeOrder(order);
+          END_MEASURE(Trading_MarketOrderBook_removeOrder, (*logger_));
+
+          order = order_pool_.allocate(market_update->order_id_, market_update->side_, market_update->price_,
+                                       market_update->qty_, market_update->priority_, nullptr, nullptr);
+          START_MEASURE(Trading_MarketOrderBook_addOrder);
+          addOrder(order);
+          END_MEASURE(Trading_MarketOrderBook_addOrder, (*logger_));
+        }
       }
         break;
       case Exchange::MarketUpdateType::CANCEL: {
@@ -43,7 +58,15 @@ namespace Trading {
       }
         break;
       case Exchange::MarketUpdateType::TRADE: {
-        trade_engine_->onTradeUpdate(market_update, this);
+        // With trade summaries the individual trades are only detail, the trade engine acts on the summaries instead.
+        if (LIKELY(trade_engine_ && !use_trade_summaries_))
+          trade_engine_->onTradeUpdate(market_update, this);
+        return;
+      }
+        break;
+      case Exchange::MarketUpdateType::TRADE_SUMMARY: {
+        if (LIKELY(trade_engine_ && use_trade_summaries_))
+          trade_engine_->onTradeUpdate(market_update, this);
         return;
       }
         break;
@@ -82,7 +105,42 @@ namespace Trading {
     logger_->log("%:% %() % % %", __FILE__, __LINE__, __FUNCTION__,
                  Common::getCurrentTimeStr(&time_str_), market_update->toString(), bbo_.toString());
 
-    trade_engine_->onOrderBookUpdate(market_update->ticker_id_, market_update->price_, market_update->side_, this);
+    if (LIKELY(trade_engine_))
+      trade_engine_->onOrderBookUpdate(market_update->ticker_id_, market_update->price_, market_update->side_, this);
+  }
+
+  /// Run synthetic add, modify, trade and cancel updates through onMarketUpdate() before trading starts and clear the book afterwards,
+  /// the trade engine is not notified of any of them.
+  auto MarketOrderBook::warmup(size_t num_iterations) noexcept -> void {
+    const auto trade_engine = trade_engine_;
+    trade_engine_ = nullptr;
+
+    constexpr size_t num_warmup_price_levels = 16;
+    for (size_t i = 0; i < num_iterations; ++i) {
+      const Price price = 100 + static_cast<Price>(i % num_warmup_price_levels);
+      const OrderId bid_id = (2 * i) % ME_MAX_ORDER_IDS, ask_id = (2 * i + 1) % ME_MAX_ORDER_IDS;
+
+      // Same sequence of updates the exchange publishes for a resting bid and ask, a trade, a queue priority preserving modify, a cancel-replace and the cancels.
+      const Exchange::MEMarketUpdate updates[] = {
+          {Exchange::MarketUpdateType::ADD, bid_id, ticker_id_, Side::BUY, price, 20, 1, false},
+          {Exchange::MarketUpdateType::ADD, ask_id, ticker_id_, Side::SELL, price + 1, 20, 1, true},
+          {Exchange::MarketUpdateType::TRADE, OrderId_INVALID, ticker_id_, Side::SELL, price, 5, Priority_INVALID, false},
+          {Exchange::MarketUpdateType::MODIFY, bid_id, ticker_id_, Side::BUY, price, 15, 1, true},
+          {Exchange::MarketUpdateType::MODIFY, bid_id, ticker_id_, Side::BUY, price - 1, 15, 2, true},
+          {Exchange::MarketUpdateType::CANCEL, bid_id, ticker_id_, Side::BUY, price - 1, 0, 2, true},
+          {Exchange::MarketUpdateType::CANCEL, ask_id, ticker_id_, Side::SELL, price + 1, 0, 1, true}};
+      for (const auto &market_update : updates) {
+        onMarketUpdate(&market_update);
+      }
+    }
+
+    // Leaves an empty book and touches the whole order id index on the way.
+    const Exchange::MEMarketUpdate clear{Exchange::MarketUpdateType::CLEAR, OrderId_INVALID, ticker_id_, Side::INVALID, Price_INVALID, Qty_INVALID,
+                                         Priority_INVALID, true};
+    onMarketUpdate(&clear);
+    updateBBO(true, true);
+
+    trade_engine_ = trade_engine;
   }
 
   auto MarketOrderBook::toString(bool detailed, bool validity_check) const -> std::string {
@@ -19,10 +19,20 @@ namespace Trading {
     /// Process market data update and update the limit order book.
     auto onMarketUpdate(const Exchange::MEMarketUpdate *market_update) noexcept -> void;
 
+    /// Run synthetic add, modify, trade and cancel updates through onMarketUpdate() before trading starts and clear the book afterwards,
+    /// the trade engine is not notified of any of them.
+    auto warmup(size_t num_iterations) noexcept -> void;
+
     auto setTradeEngine(TradeEngine *trade_engine) {
       trade_engine_ = trade_engine;
     }
 
+    /// Forward TRADE_SUMMARY updates to the trade engine instead of TRADE updates, for an exchange which publishes the summaries.
+    /// Only one of the two is forwarded so a sweep is never counted twice.
+    auto setUseTradeSummaries(bool use_trade_summaries) noexcept {
+      use_trade_summaries_ = use_trade_summaries;
+    }
+
     /// Update the BBO abstraction, the two boolean parameters represent if the buy or the sekk (or both) sides or both need to be updated.
     auto updateBBO(bool update_bid, bool update_ask) noexcept {
       if(update_bid) {
@@ -93,6 +103,9 @@ namespace Trading {
 
     BBO bbo_;
 
+    /// Whether TRADE_SUMMARY or TRADE updates are forwarded to the trade engine.
+    bool use_trade_summaries_ = false;
+
     std::string time_str_;
     Logger *logger_ = nullptr;
 
@@ -223,6 +236,6 @@ namespace Trading {
     }
   };
 
-  /// Hash map from TickerId -> MarketOrderBook.
-  typedef std::array<MarketOrderBook *, ME_MAX_TICKERS> MarketOrderBookHashMap;
+  /// Hash map from TickerId -> MarketOrderBook, sized to the instruments being traded.
+  typedef std::vector<MarketOrderBook *> MarketOrderBookHashMap;
 }
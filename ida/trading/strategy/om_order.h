@@ -13,7 +13,8 @@ namespace Trading {
     PENDING_NEW = 1,
     LIVE = 2,
     PENDING_CANCEL = 3,
-    DEAD = 4
+    DEAD = 4,
+    PENDING_MODIFY = 5
   };
 
   inline auto OMOrderStateToString(OMOrderState side) -> std::string {
@@ -26,6 +27,8 @@ namespace Trading {
         return "PENDING_CANCEL";
       case OMOrderState::DEAD:
         return "DEAD";
+      case OMOrderState::PENDING_MODIFY:
+        return "PENDING_MODIFY";
       case OMOrderState::INVALID:
         return "INVALID";
     }
@@ -60,5 +63,5 @@ namespace Trading {
   typedef std::array<OMOrder, sideToIndex(Side::MAX) + 1> OMOrderSideHashMap;
 
   /// Hash map from TickerId -> Side -> OMOrder.
-  typedef std::array<OMOrderSideHashMap, ME_MAX_TICKERS> OMOrderTickerSideHashMap;
+  typedef std::vector<OMOrderSideHashMap> OMOrderTickerSideHashMap;
 }
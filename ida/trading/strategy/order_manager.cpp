@@ -3,9 +3,13 @@
 
 namespace Trading {
   /// Send a new order with specified attribute, and update the OMOrder object passed here.
-  auto OrderManager::newOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty) noexcept -> void {
+  auto OrderManager::newOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty, Exchange::TimeInForce tif) noexcept -> void {
     const Exchange::MEClientRequest new_request{Exchange::ClientRequestType::NEW, trade_engine_->clientId(), ticker_id,
-                                                next_order_id_, side, price, qty};
+                                                next_order_id_, side, price, qty, Exchange::OrderType::LIMIT, tif};
+    if (UNLIKELY(dry_run_)) { // order is a copy of the managed order and the order id is not used up.
+      *order = {ticker_id, new_request.order_id_, side, price, qty, OMOrderState::PENDING_NEW};
+      return;
+    }
     trade_engine_->sendClientRequest(&new_request);
 
     *order = {ticker_id, next_order_id_, side, price, qty, OMOrderState::PENDING_NEW};
@@ -21,6 +25,10 @@ namespace Trading {
     const Exchange::MEClientRequest cancel_request{Exchange::ClientRequestType::CANCEL, trade_engine_->clientId(),
                                                    order->ticker_id_, order->order_id_, order->side_, order->price_,
                                                    order->qty_};
+    if (UNLIKELY(dry_run_)) {
+      order->order_state_ = OMOrderState::PENDING_CANCEL;
+      return;
+    }
     trade_engine_->sendClientRequest(&cancel_request);
 
     order->order_state_ = OMOrderState::PENDING_CANCEL;
@@ -29,4 +37,20 @@ namespace Trading {
                  Common::getCurrentTimeStr(&time_str_),
                  cancel_request.toString().c_str(), order->toString().c_str());
   }
+  /// Send a modify (cancel-replace) for the specified order to the new price and quantity, and update the OMOrder object passed here.
+  auto OrderManager::modifyOrder(OMOrder *order, Price price, Qty qty) noexcept -> void {
+    const Exchange::MEClientRequest modify_request{Exchange::ClientRequestType::MODIFY, trade_engine_->clientId(),
+                                                   order->ticker_id_, order->order_id_, order->side_, price, qty};
+    if (UNLIKELY(dry_run_)) {
+      order->order_state_ = OMOrderState::PENDING_MODIFY;
+      return;
+    }
+    trade_engine_->sendClientRequest(&modify_request);
+
+    order->order_state_ = OMOrderState::PENDING_MODIFY;
+
+    logger_->log("%:% %() % Sent modify % for %\n", __FILE__, __LINE__, __FUNCTION__,
+                 Common::getCurrentTimeStr(&time_str_),
+                 modify_request.toString().c_str(), order->toString().c_str());
+  }
 }
@@ -3,6 +3,7 @@
 #include "common/macros.h"
 #include "common/logging.h"
 
+#include "exchange/order_server/client_request.h"
 #include "exchange/order_server/client_response.h"
 
 #include "om_order.h"
@@ -16,14 +17,18 @@ namespace Trading {
   /// Manages orders for a trading algorithm, hides the complexity of order management to simplify trading strategies.
   class OrderManager {
   public:
-    OrderManager(Common::Logger *logger, TradeEngine *trade_engine, RiskManager& risk_manager)
-        : trade_engine_(trade_engine), risk_manager_(risk_manager), logger_(logger) {
+    OrderManager(Common::Logger *logger, TradeEngine *trade_engine, RiskManager& risk_manager, size_t num_tickers)
+        : trade_engine_(trade_engine), risk_manager_(risk_manager), logger_(logger), ticker_side_order_(num_tickers) {
     }
 
     /// Process an order update from a client response and update the state of the orders being managed.
     auto onOrderUpdate(const Exchange::MEClientResponse *client_response) noexcept -> void {
       logger_->log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                    client_response->toString().c_str());
+      // Completes a MASS_CANCEL, which can be for every ticker. The orders it cancelled were updated by the CANCELED responses before it.
+      if (UNLIKELY(client_response->type_ == Exchange::ClientResponseType::MASS_CANCELED))
+        return;
+
       auto order = &(ticker_side_order_.at(client_response->ticker_id_).at(sideToIndex(client_response->side_)));
       logger_->log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                    order->toString().c_str());
@@ -43,7 +48,21 @@ namespace Trading {
             order->order_state_ = OMOrderState::DEAD;
         }
           break;
-        case Exchange::ClientResponseType::CANCEL_REJECTED:
+        case Exchange::ClientResponseType::MODIFIED: {
+          order->price_ = client_response->price_;
+          order->qty_ = client_response->leaves_qty_;
+          order->order_state_ = OMOrderState::LIVE;
+        }
+          break;
+        case Exchange::ClientResponseType::MODIFY_REJECTED: { // the order is no longer live at the exchange.
+          order->order_state_ = OMOrderState::DEAD;
+        }
+          break;
+        case Exchange::ClientResponseType::CANCEL_REJECTED: { // the order is no longer live at the exchange, e.g. it was filled in a lost response.
+          order->order_state_ = OMOrderState::DEAD;
+        }
+          break;
+        case Exchange::ClientResponseType::MASS_CANCELED:
         case Exchange::ClientResponseType::INVALID: {
         }
           break;
@@ -51,17 +70,36 @@ namespace Trading {
     }
 
     /// Send a new order with specified attribute, and update the OMOrder object passed here.
-    auto newOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty) noexcept -> void;
+    auto newOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty, Exchange::TimeInForce tif) noexcept -> void;
 
     /// Send a cancel for the specified order, and update the OMOrder object passed here.
     auto cancelOrder(OMOrder *order) noexcept -> void;
 
+    /// Send a modify (cancel-replace) for the specified order to the new price and quantity, and update the OMOrder object passed here.
+    auto modifyOrder(OMOrder *order, Price price, Qty qty) noexcept -> void;
+
     /// Move a single order on the specified side so that it has the specified price and quantity.
     /// This will perform risk checks prior to sending the order, and update the OMOrder object passed here.
-    auto moveOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty) noexcept {
+    auto moveOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty, Exchange::TimeInForce tif) noexcept {
       switch (order->order_state_) {
         case OMOrderState::LIVE: {
           if(order->price_ != price) {
+            if(LIKELY(price != Price_INVALID)) { // move the order in a single round trip instead of a cancel followed by a new.
+              START_MEASURE(Trading_RiskManager_checkPreTradeRisk);
+              const auto risk_result = risk_manager_.checkPreTradeRisk(ticker_id, side, qty);
+              END_MEASURE(Trading_RiskManager_checkPreTradeRisk, (*logger_));
+              if(LIKELY(risk_result == RiskCheckResult::ALLOWED)) {
+                START_MEASURE(Trading_OrderManager_modifyOrder);
+                modifyOrder(order, price, qty);
+                END_MEASURE(Trading_OrderManager_modifyOrder, (*logger_));
+                break;
+              }
+              logger_->log("%:% %() % Ticker:% Side:% Qty:% RiskCheckResult:%\n", __FILE__, __LINE__, __FUNCTION__,
+                           Common::getCurrentTimeStr(&time_str_),
+                           tickerIdToString(ticker_id), sideToString(side), qtyToString(qty),
+                           riskCheckResultToString(risk_result));
+            }
+
             START_MEASURE(Trading_OrderManager_cancelOrder);
             cancelOrder(order);
             END_MEASURE(Trading_OrderManager_cancelOrder, (*logger_));
@@ -76,7 +114,7 @@ namespace Trading {
             END_MEASURE(Trading_RiskManager_checkPreTradeRisk, (*logger_));
             if(LIKELY(risk_result == RiskCheckResult::ALLOWED)) {
               START_MEASURE(Trading_OrderManager_newOrder);
-              newOrder(order, ticker_id, price, side, qty);
+              newOrder(order, ticker_id, price, side, qty, tif);
               END_MEASURE(Trading_OrderManager_newOrder, (*logger_));
             } else
               logger_->log("%:% %() % Ticker:% Side:% Qty:% RiskCheckResult:%\n", __FILE__, __LINE__, __FUNCTION__,
@@ -88,6 +126,7 @@ namespace Trading {
           break;
         case OMOrderState::PENDING_NEW:
         case OMOrderState::PENDING_CANCEL:
+        case OMOrderState::PENDING_MODIFY:
           break;
       }
     }
@@ -96,22 +135,39 @@ namespace Trading {
     /// This can result in new orders being sent if there are none.
     /// This can result in existing orders being cancelled if they are not at the specified price or of the specified quantity.
     /// Specifying Price_INVALID for the buy or sell prices indicates that we do not want an order there.
-    auto moveOrders(TickerId ticker_id, Price bid_price, Price ask_price, Qty clip) noexcept {
+    /// New orders are sent with the specified time in force, IOC orders never rest so there is nothing left to cancel after they are matched.
+    /// In dry run mode the orders are moved on copies of the OMOrders, so the managed orders are left untouched.
+    auto moveOrders(TickerId ticker_id, Price bid_price, Price ask_price, Qty clip, Exchange::TimeInForce tif) noexcept {
+      OMOrder dry_run_order;
       {
         auto bid_order = &(ticker_side_order_.at(ticker_id).at(sideToIndex(Side::BUY)));
+        if (UNLIKELY(dry_run_)) {
+          dry_run_order = *bid_order;
+          bid_order = &dry_run_order;
+        }
         START_MEASURE(Trading_OrderManager_moveOrder);
-        moveOrder(bid_order, ticker_id, bid_price, Side::BUY, clip);
+        moveOrder(bid_order, ticker_id, bid_price, Side::BUY, clip, tif);
         END_MEASURE(Trading_OrderManager_moveOrder, (*logger_));
       }
 
       {
         auto ask_order = &(ticker_side_order_.at(ticker_id).at(sideToIndex(Side::SELL)));
+        if (UNLIKELY(dry_run_)) {
+          dry_run_order = *ask_order;
+          ask_order = &dry_run_order;
+        }
         START_MEASURE(Trading_OrderManager_moveOrder);
-        moveOrder(ask_order, ticker_id, ask_price, Side::SELL, clip);
+        moveOrder(ask_order, ticker_id, ask_price, Side::SELL, clip, tif);
         END_MEASURE(Trading_OrderManager_moveOrder, (*logger_));
       }
     }
 
+    /// In dry run mode the full order management and risk check logic runs but no client requests are sent and the managed orders do not change,
+    /// used to keep the decision path warm in the caches while the market is quiet.
+    auto setDryRun(bool dry_run) noexcept {
+      dry_run_ = dry_run;
+    }
+
     /// Helper method to fetch the buy and sell OMOrders for the specified TickerId.
     auto getOMOrderSideHashMap(TickerId ticker_id) const {
       return &(ticker_side_order_.at(ticker_id));
@@ -143,5 +199,8 @@ namespace Trading {
 
     /// Used to set OrderIds on outgoing new order requests.
     OrderId next_order_id_ = 1;
+
+    /// Set while the trade engine keeps the decision path warm, client requests are built but not sent.
+    bool dry_run_ = false;
   };
 }
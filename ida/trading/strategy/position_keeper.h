@@ -107,8 +107,8 @@ namespace Trading {
   /// Top level position keeper class to compute position, pnl and volume for all trading instruments.
   class PositionKeeper {
   public:
-    PositionKeeper(Common::Logger *logger)
-        : logger_(logger) {
+    PositionKeeper(Common::Logger *logger, size_t num_tickers)
+        : logger_(logger), ticker_position_(num_tickers) {
     }
 
     /// Deleted default, copy & move constructors and assignment-operators.
@@ -127,7 +127,7 @@ namespace Trading {
     Common::Logger *logger_ = nullptr;
 
     /// Hash map container from TickerId -> PositionInfo.
-    std::array<PositionInfo, ME_MAX_TICKERS> ticker_position_;
+    std::vector<PositionInfo> ticker_position_;
 
   public:
     auto addFill(const Exchange::MEClientResponse *client_response) noexcept {
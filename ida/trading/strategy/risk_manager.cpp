@@ -4,8 +4,8 @@
 
 namespace Trading {
   RiskManager::RiskManager(Common::Logger *logger, const PositionKeeper *position_keeper, const TradeEngineCfgHashMap &ticker_cfg)
-      : logger_(logger) {
-    for (TickerId i = 0; i < ME_MAX_TICKERS; ++i) {
+      : logger_(logger), ticker_risk_(ticker_cfg.size()) {
+    for (TickerId i = 0; i < ticker_risk_.size(); ++i) {
       ticker_risk_.at(i).position_info_ = position_keeper->getPositionInfo(i);
       ticker_risk_.at(i).risk_cfg_ = ticker_cfg[i].risk_cfg_;
     }
@@ -69,7 +69,7 @@ namespace Trading {
   };
 
   /// Hash map from TickerId -> RiskInfo.
-  typedef std::array<RiskInfo, ME_MAX_TICKERS> TickerRiskInfoHashMap;
+  typedef std::vector<RiskInfo> TickerRiskInfoHashMap;
 
   /// Top level risk manager class to compute and check risk across all trading instruments.
   class RiskManager {
@@ -10,9 +10,11 @@ namespace Trading {
       : client_id_(client_id), outgoing_ogw_requests_(client_requests), incoming_ogw_responses_(client_responses),
         incoming_md_updates_(market_updates), logger_("/home/praveen/omlaxmiquant/ida/logs/trading_engine_" + std::to_string(client_id) + ".log"),
         feature_engine_(&logger_),
-        position_keeper_(&logger_),
-        order_manager_(&logger_, this, risk_manager_),
+        position_keeper_(&logger_, ticker_cfg.size()),
+        order_manager_(&logger_, this, risk_manager_, ticker_cfg.size()),
         risk_manager_(&logger_, &position_keeper_, ticker_cfg) {
+    // Order books are only built for the instruments this trade engine is configured to trade.
+    ticker_order_book_.resize(ticker_cfg.size(), nullptr);
     for (size_t i = 0; i < ticker_order_book_.size(); ++i) {
       ticker_order_book_[i] = new MarketOrderBook(i, &logger_);
       ticker_order_book_[i]->setTradeEngine(this);
@@ -60,6 +62,17 @@ namespace Trading {
     incoming_md_updates_ = nullptr;
   }
 
+  /// Warm up the order book paths of every traded instrument with synthetic market updates, must be called before start().
+  /// The books do not notify the trading algorithm during warmup so no orders are sent and no features or positions change.
+  auto TradeEngine::warmup(size_t num_iterations) noexcept -> void {
+    const auto start_time = Common::getCurrentNanos();
+    for (auto order_book : ticker_order_book_) {
+      order_book->warmup(num_iterations);
+    }
+    logger_.log("%:% %() % Warmed up % order books with % iterations in % ns.\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                ticker_order_book_.size(), num_iterations, Common::getCurrentNanos() - start_time);
+  }
+
   /// Write a client request to the lock free queue for the order server to consume and send to the exchange.
   auto TradeEngine::sendClientRequest(const Exchange::MEClientRequest *client_request) noexcept -> void {
     logger_.log("%:% %() % Sending %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
@@ -74,6 +87,7 @@ namespace Trading {
   auto TradeEngine::run() noexcept -> void {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
     while (run_) {
+      bool processed = false;
       for (auto client_response = incoming_ogw_responses_->getNextToRead(); client_response; client_response = incoming_ogw_responses_->getNextToRead()) {
         TTT_MEASURE(T9t_TradeEngine_LFQueue_read, logger_);
 
@@ -82,6 +96,7 @@ namespace Trading {
         onOrderUpdate(client_response);
         incoming_ogw_responses_->updateReadIndex();
         last_event_time_ = Common::getCurrentNanos();
+        processed = true;
       }
 
       for (auto market_update = incoming_md_updates_->getNextToRead(); market_update; market_update = incoming_md_updates_->getNextToRead()) {
@@ -89,15 +104,59 @@ namespace Trading {
 
         logger_.log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                     market_update->toString().c_str());
-        ASSERT(market_update->ticker_id_ < ticker_order_book_.size(),
-               "Unknown ticker-id on update:" + market_update->toString());
-        ticker_order_book_[market_update->ticker_id_]->onMarketUpdate(market_update);
+        if (LIKELY(market_update->ticker_id_ < ticker_order_book_.size())) { // updates for instruments we do not trade are skipped.
+          if (UNLIKELY(idle_)) { // reaction to the first market update after a quiet period, when the hot path is most likely cold.
+            START_MEASURE(Trading_TradeEngine_onMarketUpdateAfterIdle);
+            ticker_order_book_[market_update->ticker_id_]->onMarketUpdate(market_update);
+            END_MEASURE(Trading_TradeEngine_onMarketUpdateAfterIdle, logger_);
+          } else {
+            ticker_order_book_[market_update->ticker_id_]->onMarketUpdate(market_update);
+          }
+        }
         incoming_md_updates_->updateReadIndex();
         last_event_time_ = Common::getCurrentNanos();
+        processed = true;
+        idle_ = false;
+      }
+
+      // The clock is only read on iterations without any events, so the busy path is unaffected.
+      if (!processed) {
+        const auto now = Common::getCurrentNanos();
+        if (now - last_event_time_ >= TE_IDLE_GAP_NANOS) {
+          idle_ = true;
+          if (keep_warm_interval_ && now - last_keep_warm_time_ >= keep_warm_interval_) {
+            keepWarm();
+            last_keep_warm_time_ = Common::getCurrentNanos();
+          }
+        }
       }
     }
   }
 
+  /// Run the decision path for the next traded instrument on its current order book with the order manager in dry run mode,
+  /// so the trading algorithm, order manager and risk manager code and data stay in the caches while the market is quiet.
+  /// The position keeper and feature engine are recomputed from the same order book so they are unchanged, and no client requests are sent.
+  auto TradeEngine::keepWarm() noexcept -> void {
+    if (UNLIKELY(ticker_order_book_.empty()))
+      return;
+
+    const auto ticker_id = keep_warm_ticker_id_;
+    keep_warm_ticker_id_ = (ticker_id + 1 == ticker_order_book_.size() ? 0 : ticker_id + 1);
+    auto book = ticker_order_book_[ticker_id];
+    const auto bbo = book->getBBO();
+
+    // The trade is not fed to the feature engine, so the aggressive trade ratio the liquidity taker acts on is left as it is.
+    const Exchange::MEMarketUpdate trade{Exchange::MarketUpdateType::TRADE, OrderId_INVALID, ticker_id, Side::BUY, bbo->ask_price_, 0,
+                                         Priority_INVALID, true};
+
+    order_manager_.setDryRun(true);
+    START_MEASURE(Trading_TradeEngine_keepWarm);
+    onOrderBookUpdate(ticker_id, bbo->bid_price_, Side::BUY, book);
+    algoOnTradeUpdate_(&trade, book);
+    END_MEASURE(Trading_TradeEngine_keepWarm, logger_);
+    order_manager_.setDryRun(false);
+  }
+
   /// Process changes to the order book - updates the position keeper, feature engine and informs the trading algorithm about the update.
   auto TradeEngine::onOrderBookUpdate(TickerId ticker_id, Price price, Side side, MarketOrderBook *book) noexcept -> void {
     logger_.log("%:% %() % ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
@@ -23,6 +23,10 @@
 #include "liquidity_taker.h"
 
 namespace Trading {
+  /// Time without any client responses or market updates after which the trade engine counts as idle,
+  /// the first market update after that is measured separately as the reaction latency after an idle gap.
+  constexpr Nanos TE_IDLE_GAP_NANOS = 100 * NANOS_TO_MICROS;
+
   class TradeEngine {
   public:
     TradeEngine(Common::ClientId client_id,
@@ -55,6 +59,21 @@ namespace Trading {
       run_ = false;
     }
 
+    /// Warm up the order book paths of every traded instrument with synthetic market updates, must be called before start().
+    auto warmup(size_t num_iterations) noexcept -> void;
+
+    /// Run the decision path every interval nanoseconds while the trade engine is idle, so it is still in the caches when the market moves.
+    /// Disabled by default and with an interval of 0, must be called before start().
+    auto setKeepWarmInterval(Nanos interval) noexcept {
+      keep_warm_interval_ = interval;
+    }
+
+    /// Act on the TRADE_SUMMARY market updates instead of the TRADE updates of every traded instrument, see MarketOrderBook::setUseTradeSummaries().
+    auto setUseTradeSummaries(bool use_trade_summaries) noexcept {
+      for (auto order_book : ticker_order_book_)
+        order_book->setUseTradeSummaries(use_trade_summaries);
+    }
+
     /// Main loop for this thread - processes incoming client responses and market data updates which in turn may generate client requests.
     auto run() noexcept -> void;
 
@@ -116,6 +135,14 @@ namespace Trading {
     Nanos last_event_time_ = 0;
     volatile bool run_ = false;
 
+    /// Set once no events have been processed for TE_IDLE_GAP_NANOS, cleared by the next event.
+    bool idle_ = false;
+
+    /// Keep-warm interval, 0 if disabled, the last time the decision path was kept warm and the instrument to use for the next keep-warm pass.
+    Nanos keep_warm_interval_ = 0;
+    Nanos last_keep_warm_time_ = 0;
+    TickerId keep_warm_ticker_id_ = 0;
+
     std::string time_str_;
     Logger logger_;
 
@@ -135,6 +162,9 @@ namespace Trading {
     MarketMaker *mm_algo_ = nullptr;
     LiquidityTaker *taker_algo_ = nullptr;
 
+    /// Run the decision path for the next traded instrument on its current order book with the order manager in dry run mode.
+    auto keepWarm() noexcept -> void;
+
     /// Default methods to initialize the function wrappers.
     auto defaultAlgoOnOrderBookUpdate(TickerId ticker_id, Price price, Side side, MarketOrderBook *) noexcept -> void {
       logger_.log("%:% %() % ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
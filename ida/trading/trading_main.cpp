@@ -19,8 +19,10 @@ Trading::OrderGateway *order_gateway = nullptr;
 /// Loads configuration from JSON file
 bool loadConfigFromJson(const std::string& algo_type_str, Common::TradeEngineCfgHashMap& ticker_cfg, 
                         std::string& order_gw_ip, std::string& order_gw_iface, int& order_gw_port,
-                        std::string& mkt_data_iface, std::string& snapshot_ip, int& snapshot_port,
-                        std::string& incremental_ip, int& incremental_port, std::string& time_str) {
+                        std::string& mkt_data_iface, Exchange::MarketDataChannels& md_channels,
+                        std::vector<Common::ChannelId>& subscribed_channels, std::string& replay_ip, int& replay_port,
+                        std::string& snapshot_service_ip, int& snapshot_service_port,
+                        Common::Nanos& keep_warm_interval, bool& use_trade_summaries, std::string& time_str) {
   const std::string config_path = "/home/praveen/omlaxmiquant/ida/config/StrategyConfig.json";
   
   try {
@@ -49,17 +51,18 @@ bool loadConfigFromJson(const std::string& algo_type_str, Common::TradeEngineCfg
     // Load ticker configurations
     for (const auto& ticker : strategy_config["tickers"]) {
       size_t ticker_id = ticker["ticker_id"];
-      if (ticker_id < Common::ME_MAX_TICKERS) {
-        ticker_cfg.at(ticker_id) = {
-          static_cast<Common::Qty>(ticker["clip"]),
-          ticker["threshold"],
-          {
-            static_cast<Common::Qty>(ticker["risk"]["max_order_size"]),
-            static_cast<Common::Qty>(ticker["risk"]["max_position"]),
-            ticker["risk"]["max_loss"]
-          }
-        };
+      if (ticker_id >= ticker_cfg.size()) {
+        ticker_cfg.resize(ticker_id + 1);
       }
+      ticker_cfg.at(ticker_id) = {
+        static_cast<Common::Qty>(ticker["clip"]),
+        ticker["threshold"],
+        {
+          static_cast<Common::Qty>(ticker["risk"]["max_order_size"]),
+          static_cast<Common::Qty>(ticker["risk"]["max_position"]),
+          ticker["risk"]["max_loss"]
+        }
+      };
     }
     
     // Load global settings
@@ -69,10 +72,21 @@ bool loadConfigFromJson(const std::string& algo_type_str, Common::TradeEngineCfg
       // Load market data settings
       if (global.contains("market_data")) {
         const auto& md = global["market_data"];
-        if (md.contains("snapshot_ip")) snapshot_ip = md["snapshot_ip"];
-        if (md.contains("snapshot_port")) snapshot_port = md["snapshot_port"];
-        if (md.contains("incremental_ip")) incremental_ip = md["incremental_ip"];
-        if (md.contains("incremental_port")) incremental_port = md["incremental_port"];
+        if (md.contains("channels")) {
+          md_channels.clear();
+          for (const auto& channel : md["channels"]) {
+            md_channels.push_back({channel["incremental_ip"], channel["incremental_port"], channel["snapshot_ip"], channel["snapshot_port"]});
+          }
+        }
+        if (md.contains("subscribed_channels")) {
+          for (const auto& channel_id : md["subscribed_channels"]) {
+            subscribed_channels.push_back(channel_id);
+          }
+        }
+        if (md.contains("replay_ip")) replay_ip = md["replay_ip"];
+        if (md.contains("replay_port")) replay_port = md["replay_port"];
+        if (md.contains("snapshot_service_ip")) snapshot_service_ip = md["snapshot_service_ip"];
+        if (md.contains("snapshot_service_port")) snapshot_service_port = md["snapshot_service_port"];
         if (md.contains("interface")) mkt_data_iface = md["interface"];
       }
       
@@ -83,6 +97,13 @@ bool loadConfigFromJson(const std::string& algo_type_str, Common::TradeEngineCfg
         if (og.contains("port")) order_gw_port = og["port"];
         if (og.contains("interface")) order_gw_iface = og["interface"];
       }
+
+      // Load trade engine settings
+      if (global.contains("trade_engine")) {
+        const auto& te = global["trade_engine"];
+        if (te.contains("keep_warm_interval_us")) keep_warm_interval = static_cast<Common::Nanos>(te["keep_warm_interval_us"]) * Common::NANOS_TO_MICROS;
+        if (te.contains("use_trade_summaries")) use_trade_summaries = te["use_trade_summaries"];
+      }
     }
     
     if (logger) logger->log("%:% %() % Successfully loaded config for % strategy\n", __FILE__, __LINE__, __FUNCTION__, 
@@ -103,6 +124,8 @@ int main(int argc, char **argv) {
   }
 
   const Common::ClientId client_id = atoi(argv[1]);
+  // The exchange accepts ClientIds below ME_MAX_NUM_CLIENTS except ClientId_WARMUP, the last one, which it reserves.
+  ASSERT(client_id < Common::ClientId_WARMUP, "CLIENT_ID:" + std::to_string(client_id) + " is not accepted by the exchange.");
   srand(client_id);
 
   const auto algo_type = stringToAlgoType(argv[2]);
@@ -112,6 +135,14 @@ int main(int argc, char **argv) {
 
   const int sleep_time = 20 * 1000;
 
+  // Number of synthetic market update rounds run through each order book before trading starts.
+  const size_t warmup_iterations = 1000;
+
+  // Kernel interface for the connection to the exchange's order server.
+  const auto order_gw_tcp_backend = Common::TCPBackend::EPOLL;
+  // A sequence gap recovery with the order server which has not completed after this long is started again.
+  const Nanos order_gw_resend_timeout = 1 * Common::NANOS_TO_SECS;
+
   // The lock free queues to facilitate communication between order gateway <-> trade engine and market data consumer -> trade engine.
   Exchange::ClientRequestLFQueue client_requests(ME_MAX_CLIENT_UPDATES);
   Exchange::ClientResponseLFQueue client_responses(ME_MAX_CLIENT_UPDATES);
@@ -124,12 +155,18 @@ int main(int argc, char **argv) {
   std::string order_gw_iface = "lo";
   int order_gw_port = 12345;
   std::string mkt_data_iface = "lo";
-  std::string snapshot_ip = "233.252.14.1";
-  int snapshot_port = 20000;
-  std::string incremental_ip = "233.252.14.3";
-  int incremental_port = 20001;
-
-  // Initialize TradeEngineCfgHashMap with empty config
+  // Incremental and snapshot streams of each market data channel, all of them are subscribed to unless the config picks some.
+  Exchange::MarketDataChannels md_channels = {{"233.252.14.3", 20001, "233.252.14.1", 20000},
+                                              {"233.252.15.3", 20011, "233.252.15.1", 20010}};
+  std::vector<Common::ChannelId> subscribed_channels;
+  std::string replay_ip = "127.0.0.1";
+  int replay_port = 20003;
+  std::string snapshot_service_ip = "127.0.0.1";
+  int snapshot_service_port = 20004;
+  Common::Nanos keep_warm_interval = 0; // keep-warm is disabled unless configured.
+  bool use_trade_summaries = true; // act on TRADE_SUMMARY instead of TRADE updates, the exchange has to publish them.
+
+  // Initialize TradeEngineCfgHashMap with no instruments, the config determines which TickerIds are traded.
   TradeEngineCfgHashMap ticker_cfg;
 
   // Try to load configuration from JSON file
@@ -137,8 +174,9 @@ int main(int argc, char **argv) {
   if (argc == 3) { // Only client_id and algo_type provided, attempt to use config file
     config_loaded = loadConfigFromJson(algo_type_str, ticker_cfg, 
                                       order_gw_ip, order_gw_iface, order_gw_port,
-                                      mkt_data_iface, snapshot_ip, snapshot_port,
-                                      incremental_ip, incremental_port, time_str);
+                                      mkt_data_iface, md_channels,
+                                      subscribed_channels, replay_ip, replay_port,
+                                      snapshot_service_ip, snapshot_service_port, keep_warm_interval, use_trade_summaries, time_str);
     
     if (config_loaded) {
       logger->log("%:% %() % Successfully loaded configuration from JSON file\n", 
@@ -156,29 +194,45 @@ int main(int argc, char **argv) {
                
     // Parse and initialize the TradeEngineCfgHashMap from command line arguments
     // [CLIP_1 THRESH_1 MAX_ORDER_SIZE_1 MAX_POS_1 MAX_LOSS_1] [CLIP_2 THRESH_2 MAX_ORDER_SIZE_2 MAX_POS_2 MAX_LOSS_2] ...
-    size_t next_ticker_id = 0;
-    for (int i = 3; i < argc; i += 5, ++next_ticker_id) {
-      ticker_cfg.at(next_ticker_id) = {static_cast<Qty>(std::atoi(argv[i])), std::atof(argv[i + 1]),
-                                      {static_cast<Qty>(std::atoi(argv[i + 2])),
-                                        static_cast<Qty>(std::atoi(argv[i + 3])),
-                                        std::atof(argv[i + 4])}};
+    for (int i = 3; i < argc; i += 5) {
+      ticker_cfg.push_back({static_cast<Qty>(std::atoi(argv[i])), std::atof(argv[i + 1]),
+                            {static_cast<Qty>(std::atoi(argv[i + 2])),
+                              static_cast<Qty>(std::atoi(argv[i + 3])),
+                              std::atof(argv[i + 4])}});
     }
   }
 
+  // Without any configuration trade the default set of instruments with empty configs.
+  if (ticker_cfg.empty()) {
+    ticker_cfg.resize(ME_DEFAULT_NUM_TICKERS);
+  }
+
   logger->log("%:% %() % Starting Trade Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
   trade_engine = new Trading::TradeEngine(client_id, algo_type,
                                           ticker_cfg,
                                           &client_requests,
                                           &client_responses,
                                           &market_updates);
+  // Prime the order book paths before any real market data arrives.
+  trade_engine->warmup(warmup_iterations);
+  trade_engine->setKeepWarmInterval(keep_warm_interval);
+  trade_engine->setUseTradeSummaries(use_trade_summaries);
   trade_engine->start();
 
   logger->log("%:% %() % Starting Order Gateway...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  order_gateway = new Trading::OrderGateway(client_id, &client_requests, &client_responses, order_gw_ip, order_gw_iface, order_gw_port);
+  order_gateway = new Trading::OrderGateway(client_id, &client_requests, &client_responses, order_gw_ip, order_gw_iface, order_gw_port,
+                                            order_gw_tcp_backend, order_gw_resend_timeout);
   order_gateway->start();
 
+  if (subscribed_channels.empty()) {
+    for (size_t channel_id = 0; channel_id < md_channels.size(); ++channel_id) {
+      subscribed_channels.push_back(static_cast<Common::ChannelId>(channel_id));
+    }
+  }
+
   logger->log("%:% %() % Starting Market Data Consumer...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
-  market_data_consumer = new Trading::MarketDataConsumer(client_id, &market_updates, mkt_data_iface, snapshot_ip, snapshot_port, incremental_ip, incremental_port);
+  market_data_consumer = new Trading::MarketDataConsumer(client_id, &market_updates, mkt_data_iface, md_channels, subscribed_channels,
+                                                         replay_ip, replay_port, snapshot_service_ip, snapshot_service_port);
   market_data_consumer->start();
 
   usleep(10 * 1000 * 1000);
@@ -190,11 +244,11 @@ int main(int argc, char **argv) {
   if (algo_type == AlgoType::RANDOM) {
     Common::OrderId order_id = client_id * 1000;
     std::vector<Exchange::MEClientRequest> client_requests_vec;
-    std::array<Price, ME_MAX_TICKERS> ticker_base_price;
-    for (size_t i = 0; i < ME_MAX_TICKERS; ++i)
+    std::vector<Price> ticker_base_price(ticker_cfg.size());
+    for (size_t i = 0; i < ticker_base_price.size(); ++i)
       ticker_base_price[i] = (rand() % 100) + 100;
     for (size_t i = 0; i < 10000; ++i) {
-      const Common::TickerId ticker_id = rand() % Common::ME_MAX_TICKERS;
+      const Common::TickerId ticker_id = rand() % ticker_base_price.size();
       const Price price = ticker_base_price[ticker_id] + (rand() % 10) + 1;
       const Qty qty = 1 + (rand() % 100) + 1;
       const Side side = (rand() % 2 ? Common::Side::BUY : Common::Side::SELL);